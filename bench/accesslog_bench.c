@@ -0,0 +1,88 @@
+// Замер стоимости журнала доступа на пути обработки запроса.
+// Сравнивает прежний printf всего запроса, кольцевой журнал с разной
+// долей записей и обработку без журнала. Журнал пишется в stdout,
+// результаты - в stderr.
+// Сборка: gcc -O2 -pthread -o accesslog_bench bench/accesslog_bench.c httpd/accesslog.c httpd/http.c httpd/arena.c
+// Запуск: ./accesslog_bench [запросов] > /dev/null
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../httpd/accesslog.h"
+#include "../httpd/http.h"
+
+enum
+{
+    MODE_PRINTF,
+    MODE_RING,
+    MODE_OFF
+};
+
+static const char *const requests[] = {
+    "GET / HTTP/1.1\r\nHost: orangepi:8000\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+    "Accept: text/html,application/xhtml+xml\r\nAccept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: ru-RU,ru;q=0.9,en;q=0.8\r\nConnection: keep-alive\r\n\r\n",
+    "GET /ON HTTP/1.1\r\nHost: orangepi:8000\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+    "Referer: http://orangepi:8000/\r\nAccept-Encoding: gzip, deflate, br\r\nConnection: keep-alive\r\n\r\n",
+    "GET /static/app.js HTTP/1.1\r\nHost: orangepi:8000\r\nIf-None-Match: \"bb9-18dfe9ce8ad91ce9\"\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\nConnection: keep-alive\r\n\r\n",
+};
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Разбор запроса как в сервере плюс запись в журнал выбранным способом
+static double run(int mode, long count)
+{
+    double start = nowSec();
+    unsigned checksum = 0;
+
+    for (long i = 0; i < count; i++)
+    {
+        const char *req = requests[i % 3];
+        size_t len = httpRequestLength(req, strlen(req));
+        char method[8], path[256];
+        uint64_t begin = accessLogNow();
+
+        sscanf(req, "%7s %255s", method, path);
+        checksum += httpKeepAlive(req, len);
+        if (mode == MODE_PRINTF)
+            printf("%.*s\n", (int)len, req);
+        else if (mode == MODE_RING)
+            accessLog(0x0100007F, method, path, strlen(path), 200, 612, begin);
+    }
+    fflush(stdout);
+    if (!checksum)
+        fprintf(stderr, "unexpected\n");
+    return count / (nowSec() - start);
+}
+
+int main(int argc, char **argv)
+{
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    static const unsigned rates[] = {1, 10, 100};
+    double rps;
+
+    accessLogStart(STDOUT_FILENO, 0);
+    fprintf(stderr, "%-22s %12.0f req/s\n", "printf raw request", run(MODE_PRINTF, count));
+    for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        char name[32];
+        uint64_t dropped = accessLogDropped();
+
+        accessLogSetSampling(rates[i]);
+        rps = run(MODE_RING, count);
+        snprintf(name, sizeof(name), "ring log 1/%u", rates[i]);
+        fprintf(stderr, "%-22s %12.0f req/s  dropped %llu\n", name, rps,
+                (unsigned long long)(accessLogDropped() - dropped));
+    }
+    accessLogSetSampling(0);
+    fprintf(stderr, "%-22s %12.0f req/s\n", "logging disabled", run(MODE_OFF, count));
+    accessLogStop();
+    return 0;
+}
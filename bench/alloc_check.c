@@ -0,0 +1,229 @@
+// Проверка, что обработка запросов в установившемся режиме не обращается
+// к куче. Запускает сервер с bench/malloc_count.so, прогревает его, затем
+// гоняет смешанный поток запросов (страница с аргументами, статика с
+// ETag и 304, конвейер, /ON и /OFF с рассылкой SSE и WebSocket, ping) и
+// сравнивает число вызовов malloc до и после.
+// Сборка: gcc -O2 -shared -fPIC -o malloc_count.so bench/malloc_count.c
+//         gcc -O2 -o alloc_check bench/alloc_check.c
+// Запуск: ./alloc_check ./button ./malloc_count.so [итераций]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define PORT 8000
+#define WWW_DIR "/tmp/alloc_check_www"
+
+typedef struct
+{
+    int fd;
+    size_t len;
+    char buf[8192];
+} Reader;
+
+static int connectTo(void)
+{
+    struct sockaddr_in server_addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static void sendAll(int fd, const void *data, size_t len)
+{
+    if (send(fd, data, len, 0) != (ssize_t)len)
+    {
+        printf("=> Send failed\n");
+        exit(1);
+    }
+}
+
+// Читает один ответ HTTP, лишние байты остаются в буфере для следующего
+static void readResponse(Reader *r, char *etag, size_t etagCap)
+{
+    char *end, *cl, *tag;
+    size_t total;
+
+    while (!(end = memmem(r->buf, r->len, "\r\n\r\n", 4)))
+    {
+        ssize_t n = recv(r->fd, r->buf + r->len, sizeof(r->buf) - 1 - r->len, 0);
+        if (n <= 0)
+        {
+            printf("=> Connection lost\n");
+            exit(1);
+        }
+        r->len += n;
+        r->buf[r->len] = '\0';
+    }
+    cl = strstr(r->buf, "Content-Length:");
+    total = end + 4 - r->buf + (cl && cl < end ? strtoul(cl + 15, NULL, 10) : 0);
+    if (etag && (tag = strstr(r->buf, "ETag: ")) && tag < end)
+        snprintf(etag, etagCap, "%.*s", (int)strcspn(tag + 6, "\r"), tag + 6);
+    while (r->len < total)
+    {
+        ssize_t n = recv(r->fd, r->buf + r->len, sizeof(r->buf) - 1 - r->len, 0);
+        if (n <= 0)
+        {
+            printf("=> Connection lost\n");
+            exit(1);
+        }
+        r->len += n;
+    }
+    memmove(r->buf, r->buf + total, r->len - total);
+    r->len -= total;
+    r->buf[r->len] = '\0';
+}
+
+// Вычитывает все, что пришло подписчику
+static void drain(int fd)
+{
+    char buf[4096];
+
+    while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+        ;
+}
+
+static void sendWs(int fd, uint8_t opcode, uint8_t payload)
+{
+    uint8_t frame[7] = {0x80 | opcode, 0x80 | 1, 0x11, 0x22, 0x33, 0x44, payload ^ 0x11};
+    sendAll(fd, frame, sizeof(frame));
+}
+
+static void iteration(Reader *http, int sse, int ws, char *etag)
+{
+    char req[512];
+
+    sendAll(http->fd, req, snprintf(req, sizeof(req),
+            "GET /?name=relay%%201&state=on&x HTTP/1.1\r\nHost: bench\r\nUser-Agent: alloc_check\r\n"
+            "Accept: text/html\r\nAccept-Language: ru-RU,ru;q=0.9\r\n\r\n"));
+    readResponse(http, NULL, 0);
+    sendAll(http->fd, req, snprintf(req, sizeof(req),
+            "GET /static/app.js HTTP/1.1\r\nHost: bench\r\nAccept-Encoding: gzip, br\r\n\r\n"));
+    readResponse(http, etag, 64);
+    sendAll(http->fd, req, snprintf(req, sizeof(req),
+            "GET /static/app.js HTTP/1.1\r\nHost: bench\r\nIf-None-Match: %s\r\n\r\n", etag));
+    readResponse(http, NULL, 0);
+    sendAll(http->fd, req, snprintf(req, sizeof(req),
+            "GET /ON HTTP/1.1\r\nHost: bench\r\n\r\nGET /OFF HTTP/1.1\r\nHost: bench\r\n\r\n"
+            "GET /missing/../x HTTP/1.1\r\nHost: bench\r\n\r\n"));
+    readResponse(http, NULL, 0);
+    readResponse(http, NULL, 0);
+    readResponse(http, NULL, 0);
+
+    sendWs(ws, 0x9, 0x42);          // ping
+    sendWs(ws, 0x2, 0x01);          // команда ON
+    sendWs(ws, 0x2, 0x00);          // команда OFF
+    usleep(200);
+    drain(ws);
+    drain(sse);
+}
+
+// Счетчики из malloc_count.so: SIGUSR2 и чтение файла
+static unsigned long snapshot(pid_t server, const char *file)
+{
+    unsigned long allocs = 0, frees = 0;
+    FILE *f;
+
+    unlink(file);
+    kill(server, SIGUSR2);
+    for (int i = 0; i < 100 && !(f = fopen(file, "r")); i++)
+        usleep(10000);
+    if (!f || fscanf(f, "%lu %lu", &allocs, &frees) != 2)
+    {
+        printf("=> No counters from the server, is malloc_count.so loaded?\n");
+        exit(1);
+    }
+    fclose(f);
+    return allocs;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 3 ? atoi(argv[3]) : 2000;
+    char preload[512], counterFile[64], etag[64] = "\"none\"";
+    static const char wsUpgrade[] =
+        "GET /ws HTTP/1.1\r\nHost: bench\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    static const char sseRequest[] = "GET /events HTTP/1.1\r\nHost: bench\r\n\r\n";
+    Reader http = {0};
+    unsigned long before, after;
+    int sse, ws, file, status;
+    pid_t server;
+
+    if (argc < 3)
+    {
+        printf("Usage: %s ./button ./malloc_count.so [iterations]\n", argv[0]);
+        return 2;
+    }
+    mkdir(WWW_DIR, 0755);
+    file = open(WWW_DIR "/app.js", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    for (int i = 0; i < 64; i++)
+        dprintf(file, "console.log('relay %d');\n", i);
+    close(file);
+
+    snprintf(counterFile, sizeof(counterFile), "/tmp/malloc_count.%d", getpid());
+    snprintf(preload, sizeof(preload), "%s%s", argv[2][0] == '/' ? "" : "./", argv[2]);
+    if (!(server = fork()))
+    {
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        setenv("BUTTON_RATE", "0", 1); // прогрев и замер - сотни запросов в секунду
+        setenv("BUTTON_CONN_RATE", "0", 1);
+        setenv("BUTTON_WS_RATE", "0", 1);
+        setenv("LD_PRELOAD", preload, 1);
+        setenv("MALLOC_COUNT_FILE", counterFile, 1);
+        execl(argv[1], argv[1], WWW_DIR, (char *)NULL);
+        _exit(127);
+    }
+    for (int i = 0; i < 100 && (http.fd = connectTo()) < 0; i++)
+        usleep(20000);
+    if (http.fd < 0 || (sse = connectTo()) < 0 || (ws = connectTo()) < 0)
+    {
+        printf("=> Server did not start\n");
+        kill(server, SIGTERM);
+        return 1;
+    }
+    sendAll(sse, sseRequest, sizeof(sseRequest) - 1);
+    sendAll(ws, wsUpgrade, sizeof(wsUpgrade) - 1);
+    usleep(100000);
+
+    for (int i = 0; i < count / 4 + 1; i++)
+        iteration(&http, sse, ws, etag);
+    before = snapshot(server, counterFile);
+    for (int i = 0; i < count; i++)
+        iteration(&http, sse, ws, etag);
+    after = snapshot(server, counterFile);
+
+    printf("%d iterations, %d HTTP requests, %d WebSocket frames, %d relay toggles\n",
+           count, count * 6, count * 3, count * 4);
+    printf("heap allocations in the server during the run: %lu\n", after - before);
+
+    kill(server, SIGTERM);
+    waitpid(server, &status, 0);
+    unlink(counterFile);
+    return after == before ? 0 : 1;
+}
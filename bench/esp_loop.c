@@ -0,0 +1,704 @@
+// Замер прошивки main.c в сборке для Linux (host/): время итерации loop()
+// и пропускная способность веб-сервера под нагрузкой.
+// Программа готовит каталог с файлом EEPROM (режим станции и брокер MQTT
+// на 127.0.0.1), поднимает заглушку брокера - она отвечает на CONNECT,
+// SUBSCRIBE и PINGREQ и считает публикации, - и запускает прошивку с
+// HOST_LOOP_STATS. Затем одно соединение keep-alive, как страница в
+// браузере, шлет запросы по очереди по путям из -p в течение -d секунд
+// (с -i - не чаще раза в заданное число миллисекунд, как опрос /data
+// страницей); с -e открыто еще столько же потоков /events, как у страниц
+// с EventSource, - считаются принятые байты и события (без -p запросов
+// тогда нет вовсе); с -c клиент, как браузер с кэшем, повторяет ETag
+// последнего ответа по пути в If-None-Match; с -o от-до брокер
+// недоступен с указанной секунды замера по указанную (обрывает соединение
+// и не принимает новые) - так проверяется очередь показаний прошивки;
+// с -a мс брокер отвечает на CONNECT с задержкой, как далекий или
+// занятый; выводятся время от запуска прошивки до первой публикации MQTT
+// и паузы между попытками подключения к брокеру; с -q N журнал очереди
+// прошивки заранее содержит N показаний прошлого запуска - их отправка
+// длится N / 40 секунд (проверка keepalive при долгой выгрузке). Со
+// своим HOST_EEPROM настройки пишутся в существующий файл поверх, а
+// остальное (кэш подключения WiFi) сохраняется между запусками;
+// по окончании прошивка получает SIGTERM и пишет статистику loop().
+// По умолчанию часы прошивки виртуальные (HOST_CLOCK=virtual): delay(1)
+// не спит, и в итерации остается только работа самой прошивки; с -r -
+// настоящие часы, как на устройстве.
+// Сборка: gcc -O2 -pthread -o esp_loop bench/esp_loop.c
+// Запуск: ./esp_loop [-a мс] [-c] [-d секунд] [-e потоков] [-i мс] [-o от-до] [-p /путь,...] [-q показаний] [-r]
+//                   [-s сценарий DHT]
+//                   ./esp_relay
+//         (опрос страницей: -r -i 500 -p /data, события: -r -e 1,
+//          долгая выгрузка очереди: -r -d 80 -q 2880)
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define MAX_PATHS 8
+#define EEPROM_SIZE 1024
+#define PARAM_LENGTH 32 // maxStrParamLength в main.c
+#define IN_SIZE 65536
+#define MAX_STREAMS 8
+#define MAX_ATTEMPTS 32
+
+typedef struct
+{
+    int listenFd;
+    volatile int fd;                        // текущее соединение
+    volatile bool offline;
+    double offlineFrom, offlineTo;          // секунды от начала замера, -o
+    double startUs, firstPublishUs;         // запуск прошивки и первая публикация
+    double connackDelayUs;                  // -a
+    double attemptUs[MAX_ATTEMPTS];         // принятые соединения, и при недоступности
+    volatile int attempts;
+    volatile int connects, subscribes, publishes, pings;
+    volatile int backlogPublishes, backlogReadings; // пачки в .../backlog и показания в них
+} Broker;
+
+// Потоки /events: соединения и счетчики, поток чтения до stop
+typedef struct
+{
+    int fds[MAX_STREAMS], count;
+    volatile bool stop;
+    uint64_t bytes, events;
+} Streams;
+
+static char *paths[MAX_PATHS];
+static char etags[MAX_PATHS][64]; // ETag последнего ответа по пути для -c
+static int pathCount;
+static bool useCache;
+static size_t notModifiedCount;
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int listenLocal(uint16_t *port)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t len = sizeof(addr);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 4) < 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &len) < 0)
+        return -1;
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static bool readFull(int fd, void *buf, size_t len)
+{
+    for (size_t got = 0; got < len;)
+    {
+        ssize_t n = read(fd, (char *)buf + got, len - got);
+        if (n <= 0)
+            return false;
+        got += n;
+    }
+    return true;
+}
+
+// Заглушка брокера MQTT 3.1.1: соединения по одному, как у прошивки
+static void *brokerThread(void *arg)
+{
+    Broker *b = arg;
+    static uint8_t packet[IN_SIZE];
+
+    for (;;)
+    {
+        int fd = accept4(b->listenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        if (b->attempts < MAX_ATTEMPTS)
+            b->attemptUs[b->attempts] = nowUs() - b->startUs;
+        b->attempts++;
+        if (b->offline)
+        {
+            close(fd);
+            continue;
+        }
+        b->fd = fd;
+        for (;;)
+        {
+            uint8_t type, byte;
+            size_t len = 0, shift = 0;
+
+            if (!readFull(fd, &type, 1))
+                break;
+            do
+            {
+                if (!readFull(fd, &byte, 1))
+                    goto closed;
+                len |= (size_t)(byte & 127) << shift;
+                shift += 7;
+            } while (byte & 128);
+            if (len > sizeof(packet) || !readFull(fd, packet, len))
+                break;
+
+            switch (type & 0xF0)
+            {
+            case 0x10: // CONNECT -> CONNACK
+            {
+                static const uint8_t connack[] = {0x20, 2, 0, 0};
+                b->connects++;
+                if (b->connackDelayUs > 0)
+                    usleep(b->connackDelayUs);
+                write(fd, connack, sizeof(connack));
+                break;
+            }
+            case 0x80: // SUBSCRIBE -> SUBACK с QoS 0
+            {
+                uint8_t suback[] = {0x90, 3, packet[0], packet[1], 0};
+                b->subscribes++;
+                write(fd, suback, sizeof(suback));
+                break;
+            }
+            case 0x30: // PUBLISH с QoS 0: длина топика, топик, данные
+            {
+                size_t topicLen = len >= 2 ? (size_t)packet[0] << 8 | packet[1] : 0;
+
+                if (!b->publishes++)
+                    b->firstPublishUs = nowUs() - b->startUs;
+                if (topicLen + 2 <= len && topicLen >= 8 && !memcmp(packet + 2 + topicLen - 8, "/backlog", 8))
+                {
+                    b->backlogPublishes++;
+                    for (size_t i = 2 + topicLen; i < len; i++)
+                        b->backlogReadings += packet[i] == '[';
+                }
+                break;
+            }
+            case 0xC0: // PINGREQ -> PINGRESP
+            {
+                static const uint8_t pingresp[] = {0xD0, 0};
+                b->pings++;
+                write(fd, pingresp, sizeof(pingresp));
+                break;
+            }
+            case 0xE0:
+                goto closed;
+            }
+        }
+    closed:
+        b->fd = -1;
+        close(fd);
+    }
+    return NULL;
+}
+
+// Строка параметра EEPROM: PARAM_LENGTH байт, хвост нулями
+static size_t putParam(uint8_t *eeprom, size_t offset, const char *value)
+{
+    memset(eeprom + offset, 0, PARAM_LENGTH);
+    strncpy((char *)eeprom + offset, value, PARAM_LENGTH);
+    return offset + PARAM_LENGTH;
+}
+
+// Настройки в раскладке readConfig() из main.c, поверх прежнего файла
+static bool writeEeprom(const char *path, uint16_t mqttPort)
+{
+    uint8_t eeprom[EEPROM_SIZE];
+    size_t offset = 4;
+    FILE *f;
+    bool ok;
+
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    if ((f = fopen(path, "rb")))
+    {
+        if (fread(eeprom, 1, sizeof(eeprom), f) != sizeof(eeprom))
+            memset(eeprom, 0xFF, sizeof(eeprom));
+        fclose(f);
+    }
+    memcpy(eeprom, "#REL", 4);
+    offset = putParam(eeprom, offset, "bench");     // ssid
+    offset = putParam(eeprom, offset, "password");
+    offset = putParam(eeprom, offset, "");          // domain
+    offset = putParam(eeprom, offset, "127.0.0.1"); // сервер MQTT
+    memcpy(eeprom + offset, &mqttPort, sizeof(mqttPort));
+    offset += sizeof(mqttPort);
+    offset = putParam(eeprom, offset, "");          // пользователь
+    offset = putParam(eeprom, offset, "");          // пароль
+    offset = putParam(eeprom, offset, "ESP_Bench");
+    putParam(eeprom, offset, "/Relay");
+
+    if (!(f = fopen(path, "wb")))
+        return false;
+    ok = fwrite(eeprom, 1, sizeof(eeprom), f) == sizeof(eeprom);
+    return fclose(f) == 0 && ok;
+}
+
+// Журнал очереди MQTT в раскладке main.c (QueueHeader и Reading): count
+// показаний с bootId 0 - для прошивки они из прошлого запуска
+static bool writeBacklog(const char *dir, unsigned count)
+{
+    char path[300];
+    uint16_t header[2] = {0, count};
+    FILE *f;
+    bool ok;
+
+    snprintf(path, sizeof(path), "%s/mqttqueue.bin", dir);
+    if (!(f = fopen(path, "wb")))
+        return false;
+    ok = fwrite("#QUE", 1, 4, f) == 4 && fwrite(header, sizeof(header), 1, f) == 1;
+    for (unsigned i = 0; ok && i < count; i++)
+    {
+        struct
+        {
+            uint32_t boot, time;
+            float temp;
+        } reading = {0, i * 30000, 20 + i % 10 * 0.1f};
+
+        ok = fwrite(&reading, sizeof(reading), 1, f) == 1;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+static int connectLocal(uint16_t port)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port),
+                               .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0), one = 1;
+    struct timeval tv = {5, 0};
+
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+// Длина полного ответа в начале buf: 0 - ответ еще не пришел целиком,
+// -1 - ошибка разбора. *close - сервер закроет соединение
+static ssize_t responseLength(const char *buf, size_t len, bool *close)
+{
+    const char *end = memmem(buf, len, "\r\n\r\n", 4), *h;
+    size_t head, pos;
+
+    if (!end)
+        return 0;
+    head = end + 4 - buf;
+    *close = memmem(buf, head, "Connection: close", 17) != NULL;
+    if (!memcmp(buf, "HTTP/1.1 304", 12))
+        return head; // у 304 тела нет
+    if ((h = strcasestr(buf, "\r\nContent-Length:")) && h < end)
+    {
+        size_t body = strtoul(h + 17, NULL, 10);
+        return head + body <= len ? (ssize_t)(head + body) : 0;
+    }
+    if (!(h = strcasestr(buf, "\r\nTransfer-Encoding: chunked")) || h > end)
+        return *close ? 0 : -1;
+    for (pos = head;;)
+    {
+        char *next;
+        size_t chunk;
+
+        if (!memmem(buf + pos, len - pos, "\r\n", 2))
+            return 0;
+        chunk = strtoul(buf + pos, &next, 16);
+        pos = (const char *)memmem(buf + pos, len - pos, "\r\n", 2) - buf + 2;
+        if (pos + chunk + 2 > len)
+            return 0;
+        pos += chunk + 2;
+        if (!chunk)
+            return pos;
+    }
+}
+
+// ETag ответа для следующего If-None-Match
+static void saveEtag(const char *in, char *etag, size_t size)
+{
+    const char *h = strcasestr(in, "\r\nETag: "), *end;
+
+    if (!h || !(end = strstr(h + 8, "\r\n")) || (size_t)(end - h - 8) >= size)
+        return;
+    memcpy(etag, h + 8, end - h - 8);
+    etag[end - h - 8] = '\0';
+}
+
+// Запрос и ожидание ответа; возвращает задержку в мкс или -1, в *firstUs -
+// время до первого байта ответа. С etag (-c) запрос условный
+static double request(int *fd, uint16_t port, const char *path, char *etag, uint64_t *bytes, double *firstUs)
+{
+    static char in[IN_SIZE];
+    char req[256];
+    size_t inLen = 0;
+    int reqLen = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n%s%s%s\r\n", path,
+                          etag && *etag ? "If-None-Match: " : "", etag && *etag ? etag : "",
+                          etag && *etag ? "\r\n" : "");
+    double start = nowUs();
+
+    if (*fd < 0 && (*fd = connectLocal(port)) < 0)
+        return -1;
+    if (write(*fd, req, reqLen) != reqLen)
+        goto fail;
+    for (;;)
+    {
+        ssize_t n = read(*fd, in + inLen, sizeof(in) - 1 - inLen), total;
+        bool close_ = false;
+
+        if (n < 0)
+            goto fail;
+        if (!inLen)
+            *firstUs = nowUs() - start;
+        inLen += n;
+        in[inLen] = '\0';
+        total = responseLength(in, inLen, &close_);
+        if (total < 0 || (n == 0 && !close_))
+            goto fail;
+        if (n == 0 || total > 0)
+        {
+            // Ответ с Connection: close дочитывается до закрытия
+            if (close_ && n > 0)
+                continue;
+            *bytes += inLen;
+            if (!strncmp(in, "HTTP/1.1 304", 12))
+                notModifiedCount++;
+            else if (etag)
+                saveEtag(in, etag, sizeof(etags[0]));
+            if (close_)
+            {
+                close(*fd);
+                *fd = -1;
+            }
+            return nowUs() - start;
+        }
+        if (inLen == sizeof(in) - 1)
+            goto fail;
+    }
+fail:
+    close(*fd);
+    *fd = -1;
+    return -1;
+}
+
+// Недоступность брокера по -o: соединение обрывается, новые закрываются
+static void *outageThread(void *arg)
+{
+    Broker *b = arg;
+    int fd;
+
+    usleep(b->offlineFrom * 1e6);
+    b->offline = true;
+    if ((fd = b->fd) >= 0)
+        shutdown(fd, SHUT_RDWR);
+    usleep((b->offlineTo - b->offlineFrom) * 1e6);
+    b->offline = false;
+    return NULL;
+}
+
+// Читает потоки событий и считает строки "data:" - по одной на событие
+static void *streamThread(void *arg)
+{
+    Streams *st = arg;
+    struct pollfd pfds[MAX_STREAMS];
+    int matched[MAX_STREAMS] = {0}; // совпавших символов "data:" с начала строки
+    char buf[4096];
+
+    for (int i = 0; i < st->count; i++)
+        pfds[i] = (struct pollfd){.fd = st->fds[i], .events = POLLIN};
+    while (!st->stop)
+    {
+        if (poll(pfds, st->count, 100) <= 0)
+            continue;
+        for (int i = 0; i < st->count; i++)
+        {
+            ssize_t n;
+
+            if (!(pfds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            if ((n = read(pfds[i].fd, buf, sizeof(buf))) <= 0)
+            {
+                pfds[i].fd = -1;
+                continue;
+            }
+            st->bytes += n;
+            for (ssize_t j = 0; j < n; j++)
+            {
+                if (buf[j] == '\n')
+                    matched[i] = 0;
+                else if (matched[i] >= 0 && matched[i] < 5 && buf[j] == "data:"[matched[i]])
+                {
+                    if (++matched[i] == 5)
+                        st->events++;
+                }
+                else
+                    matched[i] = -1;
+            }
+        }
+    }
+    return NULL;
+}
+
+static bool waitListening(uint16_t port)
+{
+    for (int i = 0; i < 500; i++)
+    {
+        int fd = connectLocal(port);
+        if (fd >= 0)
+        {
+            close(fd);
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+static void printLoopStats(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char name[64];
+    double value;
+
+    if (!f)
+    {
+        printf("=> No loop() statistics in %s\n", path);
+        return;
+    }
+    printf("loop():\n");
+    while (fscanf(f, "%63s %lf", name, &value) == 2)
+        printf("   %-12s %12.3f\n", name, value);
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    char dir[] = "/tmp/esp_loopXXXXXX", eepromPath[256], statsPath[64], logPath[64];
+    char httpPortStr[8], *pathList = "/data", *dhtScript = NULL;
+    double seconds = 5, intervalUs = 0, *latencies, *firstBytes;
+    size_t latencyCap = 1 << 20, count = 0, errors = 0;
+    uint64_t bytes = 0;
+    bool realClock = false, pathsSet = false;
+    unsigned backlog = 0;
+    uint16_t mqttPort, httpPort;
+    Broker broker = {.fd = -1};
+    Streams streams = {.count = 0};
+    pthread_t thread, streamReader, outage;
+    pid_t pid;
+    int opt, fd = -1, status;
+
+    while ((opt = getopt(argc, argv, "a:cd:e:i:o:p:q:rs:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            broker.connackDelayUs = atof(optarg) * 1e3;
+            break;
+        case 'c':
+            useCache = true;
+            break;
+        case 'd':
+            seconds = atof(optarg);
+            break;
+        case 'e':
+            streams.count = atoi(optarg) < MAX_STREAMS ? atoi(optarg) : MAX_STREAMS;
+            break;
+        case 'i':
+            intervalUs = atof(optarg) * 1e3;
+            break;
+        case 'o':
+            if (sscanf(optarg, "%lf-%lf", &broker.offlineFrom, &broker.offlineTo) != 2 ||
+                broker.offlineTo <= broker.offlineFrom)
+            {
+                fprintf(stderr, "=> -o from-to, seconds\n");
+                return 1;
+            }
+            break;
+        case 'p':
+            pathList = optarg;
+            pathsSet = true;
+            break;
+        case 'q':
+            backlog = atoi(optarg) < 2880 ? atoi(optarg) : 2880; // flashQueueSize
+            break;
+        case 'r':
+            realClock = true;
+            break;
+        case 's':
+            dhtScript = realpath(optarg, NULL);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-a ms] [-c] [-d seconds] [-e streams] [-i ms] [-o from-to] [-p /path,...] [-q readings] [-r] [-s dht-script] "
+                    "./esp_relay\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "=> Firmware binary required\n");
+        return 1;
+    }
+    for (char *p = strtok(strdup(pathList), ","); p && pathCount < MAX_PATHS; p = strtok(NULL, ","))
+        paths[pathCount++] = p;
+
+    signal(SIGPIPE, SIG_IGN);
+    if (!mkdtemp(dir))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    if (getenv("HOST_EEPROM"))
+        snprintf(eepromPath, sizeof(eepromPath), "%s", getenv("HOST_EEPROM"));
+    else
+        snprintf(eepromPath, sizeof(eepromPath), "%s/eeprom.bin", dir);
+    snprintf(statsPath, sizeof(statsPath), "%s/loop.txt", dir);
+    snprintf(logPath, sizeof(logPath), "%s/firmware.log", dir);
+
+    // Порт для прошивки: занять свободный и сразу отпустить
+    if ((broker.listenFd = listenLocal(&mqttPort)) < 0 || (fd = listenLocal(&httpPort)) < 0 ||
+        !writeEeprom(eepromPath, mqttPort) ||
+        (backlog && !writeBacklog(getenv("HOST_FS") ? getenv("HOST_FS") : dir, backlog)))
+    {
+        perror("=> Setup");
+        return 1;
+    }
+    close(fd);
+    fd = -1;
+    snprintf(httpPortStr, sizeof(httpPortStr), "%u", httpPort);
+    pthread_create(&thread, NULL, brokerThread, &broker);
+
+    broker.startUs = nowUs();
+    if ((pid = fork()) == 0)
+    {
+        int log = open(logPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        dup2(log, STDOUT_FILENO);
+        setenv("HOST_HTTP_PORT", httpPortStr, 1);
+        setenv("HOST_EEPROM", eepromPath, 1);
+        setenv("HOST_LOOP_STATS", statsPath, 1);
+        setenv("HOST_FS", dir, 0); // свой HOST_FS - проверка журнала после перезапуска
+        if (!realClock)
+            setenv("HOST_CLOCK", "virtual", 1);
+        if (dhtScript)
+            setenv("HOST_DHT_SCRIPT", dhtScript, 1);
+        execv(argv[optind], argv + optind);
+        _exit(127);
+    }
+    if (pid < 0 || !waitListening(httpPort))
+    {
+        fprintf(stderr, "=> Firmware did not start, see %s\n", logPath);
+        if (pid > 0)
+            kill(pid, SIGKILL);
+        return 1;
+    }
+
+    for (int i = 0; i < streams.count; i++)
+    {
+        static const char req[] = "GET /events HTTP/1.1\r\nHost: 127.0.0.1\r\nAccept: text/event-stream\r\n\r\n";
+
+        if ((streams.fds[i] = connectLocal(httpPort)) < 0 || write(streams.fds[i], req, sizeof(req) - 1) < 0)
+        {
+            fprintf(stderr, "=> Event stream %d failed\n", i);
+            streams.count = i;
+            break;
+        }
+    }
+    if (streams.count)
+        pthread_create(&streamReader, NULL, streamThread, &streams);
+    if (broker.offlineTo > 0)
+        pthread_create(&outage, NULL, outageThread, &broker);
+
+    latencies = malloc(latencyCap * sizeof(*latencies));
+    firstBytes = malloc(latencyCap * sizeof(*firstBytes));
+    double start = nowUs(), end = start + seconds * 1e6;
+    if (streams.count && !pathsSet)
+    {
+        while (nowUs() < end)
+            usleep(10000);
+    }
+    for (int i = 0; (pathsSet || !streams.count) && nowUs() < end; i = (i + 1) % pathCount)
+    {
+        char *etag = useCache ? etags[i] : NULL;
+        double first = 0, sent = nowUs(), us = request(&fd, httpPort, paths[i], etag, &bytes, &first);
+
+        if (us < 0)
+            errors++;
+        else if (count < latencyCap)
+        {
+            firstBytes[count] = first;
+            latencies[count++] = us;
+        }
+        if (intervalUs > 0 && sent + intervalUs > nowUs())
+            usleep(sent + intervalUs - nowUs());
+    }
+    double elapsed = (nowUs() - start) / 1e6;
+    if (fd >= 0)
+        close(fd);
+
+    if (streams.count)
+    {
+        streams.stop = true;
+        pthread_join(streamReader, NULL);
+        for (int i = 0; i < streams.count; i++)
+            close(streams.fds[i]);
+    }
+
+    kill(pid, SIGTERM);
+    waitpid(pid, &status, 0);
+
+    qsort(latencies, count, sizeof(*latencies), compareDouble);
+    qsort(firstBytes, count, sizeof(*firstBytes), compareDouble);
+    printf("=> %s, %s clock, %.1f s, interval %.0f ms, paths %s\n", argv[optind], realClock ? "real" : "virtual",
+           elapsed, intervalUs / 1e3, pathsSet || !streams.count ? pathList : "-");
+    printf("requests:     %zu (%.0f req/s), errors %zu, 304 %zu, %.1f KB received\n", count, count / elapsed, errors,
+           notModifiedCount, bytes / 1024.0);
+    if (count)
+        printf("latency us:   p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", latencies[count / 2],
+               latencies[(size_t)(count * 0.9)], latencies[(size_t)(count * 0.99)],
+               latencies[(size_t)(count * 0.999)], latencies[count - 1]);
+    if (streams.count)
+        printf("events:       %d streams, %llu events, %.1f KB received (%.1f B/s per stream)\n", streams.count,
+               (unsigned long long)streams.events, streams.bytes / 1024.0, streams.bytes / elapsed / streams.count);
+    if (count)
+        printf("first byte us: p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", firstBytes[count / 2],
+               firstBytes[(size_t)(count * 0.9)], firstBytes[(size_t)(count * 0.99)], firstBytes[count - 1]);
+    printLoopStats(statsPath);
+    printf("mqtt:         connects %d, subscribes %d, publishes %d, pings %d\n", broker.connects,
+           broker.subscribes, broker.publishes, broker.pings);
+    if (broker.attempts > 1)
+    {
+        printf("mqtt attempts: %d, gaps ms:", broker.attempts);
+        for (int i = 1; i < broker.attempts && i < MAX_ATTEMPTS; i++)
+            printf(" %.0f", (broker.attemptUs[i] - broker.attemptUs[i - 1]) / 1e3);
+        printf("\n");
+    }
+    if (broker.publishes)
+        printf("first publish: %.0f ms after start\n", broker.firstPublishUs / 1e3);
+    if (broker.backlogPublishes)
+        printf("backlog:      %d publishes, %d readings\n", broker.backlogPublishes,
+               broker.backlogReadings - broker.backlogPublishes);
+    printf("firmware log: %s\n", logPath);
+    free(latencies);
+    free(firstBytes);
+    return 0;
+}
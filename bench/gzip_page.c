@@ -0,0 +1,131 @@
+// Страница сервера со сжатием и без: запросы keep-alive к / с
+// Accept-Encoding: gzip и без него. Для каждого варианта - запросов в
+// секунду, байт ответа на проводе (заголовки и тело) и время передачи
+// одного ответа по медленным каналам; в конце - сколько байт сэкономлено.
+// Сборка: gcc -O2 -o gzip_page bench/gzip_page.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 ./button > /dev/null & ./gzip_page [запросов] [путь] [порт]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static const struct
+{
+    const char *name;
+    double bitsPerSec;
+} links[] = {{"GPRS 40 kbit/s", 40e3}, {"2G EDGE 200 kbit/s", 200e3}, {"Wi-Fi 1 Mbit/s", 1e6}};
+
+#define LINKS (sizeof(links) / sizeof(links[0]))
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int connectTo(int portNum)
+{
+    struct sockaddr_in server_addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        printf("=> Error connecting to port %d\n", portNum);
+        exit(1);
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Читает ответ целиком, возвращает его длину или 0; gzip - есть ли Content-Encoding: gzip
+static size_t recvResponse(int fd, char *buf, size_t cap, bool *gzip)
+{
+    size_t got = 0, total;
+    char *end = NULL, *cl;
+
+    while (!end)
+    {
+        ssize_t n = recv(fd, buf + got, cap - 1 - got, 0);
+        if (n <= 0)
+            return 0;
+        got += n;
+        buf[got] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+    }
+    *end = '\0';
+    cl = strcasestr(buf, "Content-Length:");
+    *gzip = strcasestr(buf, "Content-Encoding: gzip") != NULL;
+    total = end + 4 - buf + (cl ? strtoul(cl + 15, NULL, 10) : 0);
+    if (total >= cap || strncmp(buf, "HTTP/1.1 200", 12))
+        return 0;
+    while (got < total)
+    {
+        ssize_t n = recv(fd, buf + got, total - got, 0);
+        if (n <= 0)
+            return 0;
+        got += n;
+    }
+    return total;
+}
+
+// count запросов path; возвращает байт на ответ или 0 при ошибке
+static double run(const char *label, const char *path, bool acceptGzip, int count, int portNum)
+{
+    static char buf[1 << 20];
+    char req[512];
+    int len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: localhost\r\n%sConnection: keep-alive\r\n\r\n",
+                       path, acceptGzip ? "Accept-Encoding: gzip, deflate, br\r\n" : "");
+    int fd = connectTo(portNum);
+    size_t bytes = 0, size = 0;
+    bool gzip = false;
+    double start = nowSec(), elapsed;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (send(fd, req, len, 0) != len || !(size = recvResponse(fd, buf, sizeof(buf), &gzip)))
+        {
+            printf("=> Request to %s failed\n", path);
+            exit(1);
+        }
+        bytes += size;
+    }
+    elapsed = nowSec() - start;
+    close(fd);
+    if (acceptGzip && !gzip)
+        printf("=> %s was not compressed\n", path);
+
+    printf("%-10s %8.0f req/s  %6.0f B/response  %6.1f MB/s", label, count / elapsed,
+           (double)bytes / count, bytes / elapsed / 1e6);
+    for (size_t i = 0; i < LINKS; i++)
+        printf("  %s %.1f ms", links[i].name, (double)bytes / count * 8 / links[i].bitsPerSec * 1000);
+    printf("\n");
+    return (double)bytes / count;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 50000;
+    const char *path = argc > 2 ? argv[2] : "/";
+    int portNum = argc > 3 ? atoi(argv[3]) : 8000;
+    double plain, gzip;
+
+    plain = run("identity", path, false, count, portNum);
+    gzip = run("gzip", path, true, count, portNum);
+    printf("saved %.0f B per response (%.1f%%), %.1f MB per %d responses\n", plain - gzip,
+           100 * (plain - gzip) / plain, (plain - gzip) * count / 1e6, count);
+    return 0;
+}
@@ -0,0 +1,288 @@
+// Загрузка данных панели управления (страница, /relay/mask и /metrics):
+// три последовательных запроса HTTP/1.1 keep-alive против трех потоков
+// HTTP/2 (h2c с преамбулой), отправленных разом по одному соединению.
+// Для каждого способа - байты заголовков запроса и ответа (в HTTP/2 вместе
+// с заголовками кадров HEADERS) и время загрузки всех трех ответов.
+// Заголовки запросов как у браузера, чтобы сжатие HPACK было видно.
+// Сборка: gcc -O2 -pthread -o h2_load bench/h2_load.c httpd/hpack.c httpd/arena.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 ./button > /dev/null & ./h2_load [загрузок] [порт]
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../httpd/hpack.h"
+
+#define PATHS 3
+
+static const char *const paths[PATHS] = {"/", "/relay/mask", "/metrics"};
+
+// Заголовки браузера после псевдозаголовков
+static const char *const browser[][2] = {
+    {"user-agent", "Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0"},
+    {"accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8"},
+    {"accept-language", "ru-RU,ru;q=0.8,en-US;q=0.5,en;q=0.3"},
+    {"accept-encoding", "gzip, deflate"},
+    {"cookie", "session=6f1c2a9e4b7d8035; theme=dark"},
+};
+
+#define BROWSER_FIELDS (sizeof(browser) / sizeof(browser[0]))
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connectTo(int portNum)
+{
+    struct sockaddr_in server_addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        printf("=> Error connecting to port %d\n", portNum);
+        exit(1);
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool recvAll(int fd, void *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = recv(fd, (char *)buf + got, len - got, 0);
+        if (n <= 0)
+            return false;
+        got += n;
+    }
+    return true;
+}
+
+// Читает ответ HTTP/1.1 целиком, возвращает длину заголовков или 0
+static size_t recvResponse(int fd, char *buf, size_t cap)
+{
+    size_t got = 0;
+    char *end = NULL;
+
+    while (!end)
+    {
+        ssize_t n = recv(fd, buf + got, cap - 1 - got, 0);
+        if (n <= 0)
+            return 0;
+        got += n;
+        buf[got] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+    }
+    char *cl = strstr(buf, "Content-Length:");
+    size_t head = end + 4 - buf;
+    size_t total = head + (cl ? strtoul(cl + 15, NULL, 10) : 0);
+    if (total >= cap || strncmp(buf, "HTTP/1.1 200", 12))
+        return 0;
+    return got >= total || recvAll(fd, buf + got, total - got) ? head : 0;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *load, int count, size_t reqHead, size_t respHead)
+{
+    double sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += load[i];
+    qsort(load, count, sizeof(double), compareDouble);
+    printf("%-16s loads %d  request head %5.1f B  response head %5.1f B  mean %.1f us  p50 %.1f us  p99 %.1f us\n",
+           name, count, (double)reqHead / (count * PATHS), (double)respHead / (count * PATHS),
+           sum / count, load[count / 2], load[(int)(count * 0.99)]);
+}
+
+static bool loadHttp1(int fd, double *load, size_t *reqHead, size_t *respHead)
+{
+    static char buf[65536];
+    char req[1024];
+
+    for (int i = 0; i < PATHS; i++)
+    {
+        int len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: localhost:8000\r\n", paths[i]);
+        size_t head;
+
+        for (size_t k = 0; k < BROWSER_FIELDS; k++)
+            len += snprintf(req + len, sizeof(req) - len, "%s: %s\r\n", browser[k][0], browser[k][1]);
+        len += snprintf(req + len, sizeof(req) - len, "Connection: keep-alive\r\n\r\n");
+        // Время загрузки - от первого запроса до последнего ответа
+        if (!i)
+            *load = nowUs();
+        if (send(fd, req, len, 0) != len || !(head = recvResponse(fd, buf, sizeof(buf))))
+            return false;
+        *reqHead += len;
+        *respHead += head;
+    }
+    *load = nowUs() - *load;
+    return true;
+}
+
+// Кадры HTTP/2 клиента
+static uint8_t *frameHead(uint8_t *p, size_t len, int type, int flags, uint32_t stream)
+{
+    p[0] = len >> 16;
+    p[1] = len >> 8;
+    p[2] = len;
+    p[3] = type;
+    p[4] = flags;
+    p[5] = stream >> 24;
+    p[6] = stream >> 16;
+    p[7] = stream >> 8;
+    p[8] = stream;
+    return p + 9;
+}
+
+typedef struct
+{
+    int fd;
+    HpackTable encoder, decoder;
+    uint32_t nextStream;
+    Arena arena;
+    _Alignas(16) char arenaMem[4096];
+} H2Client;
+
+static bool h2Connect(H2Client *h, int portNum)
+{
+    static const char preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    uint8_t out[64], *p = out;
+
+    h->fd = connectTo(portNum);
+    hpackInit(&h->encoder, HPACK_TABLE_SIZE);
+    hpackInit(&h->decoder, HPACK_TABLE_SIZE);
+    arenaInit(&h->arena, h->arenaMem, sizeof(h->arenaMem));
+    h->nextStream = 1;
+    memcpy(p, preface, sizeof(preface) - 1);
+    p += sizeof(preface) - 1;
+    p = frameHead(p, 0, 4, 0, 0); // пустые SETTINGS
+    // Окно соединения сразу на гигабайт: его обновления не нужны
+    p = frameHead(p, 4, 8, 0, 0);
+    *p++ = 0x40;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
+    return send(h->fd, out, p - out, 0) == p - out;
+}
+
+static bool loadHttp2(H2Client *h, double *load, size_t *reqHead, size_t *respHead)
+{
+    uint8_t out[4096], *p = out, frame[9];
+    static uint8_t payload[16384]; // SETTINGS_MAX_FRAME_SIZE по умолчанию
+    int pending = PATHS;
+
+    for (int i = 0; i < PATHS; i++)
+    {
+        uint8_t *q = p + 9, *start = q;
+
+        q += hpackEncode(&h->encoder, q, out + sizeof(out) - q, ":method", 7, "GET", 3, true);
+        q += hpackEncode(&h->encoder, q, out + sizeof(out) - q, ":scheme", 7, "http", 4, true);
+        q += hpackEncode(&h->encoder, q, out + sizeof(out) - q, ":authority", 10, "localhost:8000", 14, true);
+        q += hpackEncode(&h->encoder, q, out + sizeof(out) - q, ":path", 5, paths[i], strlen(paths[i]), true);
+        for (size_t k = 0; k < BROWSER_FIELDS; k++)
+            q += hpackEncode(&h->encoder, q, out + sizeof(out) - q, browser[k][0], strlen(browser[k][0]),
+                             browser[k][1], strlen(browser[k][1]), true);
+        frameHead(p, q - start, 1, 0x05, h->nextStream); // END_STREAM | END_HEADERS
+        h->nextStream += 2;
+        p = q;
+    }
+    *reqHead += p - out;
+    *load = nowUs();
+    if (send(h->fd, out, p - out, 0) != p - out)
+        return false;
+
+    while (pending)
+    {
+        size_t len;
+        int type, flags;
+
+        if (!recvAll(h->fd, frame, sizeof(frame)))
+            return false;
+        len = (size_t)frame[0] << 16 | frame[1] << 8 | frame[2];
+        type = frame[3];
+        flags = frame[4];
+        if (!recvAll(h->fd, payload, len))
+            return false;
+        if (type == 1) // HEADERS ответа
+        {
+            HttpField fields[32];
+            int count;
+
+            arenaReset(&h->arena);
+            if (!(flags & 0x04) || !hpackDecode(&h->decoder, &h->arena, payload, len, fields, 32, &count) ||
+                !count || strcmp(fields[0].value, "200"))
+            {
+                printf("=> Bad HTTP/2 response headers\n");
+                return false;
+            }
+            *respHead += sizeof(frame) + len;
+        }
+        else if (type == 4 && !(flags & 0x01)) // SETTINGS - подтвердить
+        {
+            frameHead(frame, 0, 4, 0x01, 0);
+            send(h->fd, frame, sizeof(frame), 0);
+        }
+        else if (type == 3 || type == 7) // RST_STREAM, GOAWAY
+        {
+            printf("=> HTTP/2 stream reset or connection closed by server\n");
+            return false;
+        }
+        if ((type == 0 || type == 1) && (flags & 0x01))
+            pending--;
+    }
+    *load = nowUs() - *load;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 5000;
+    int portNum = argc > 2 ? atoi(argv[2]) : 8000;
+    double *load = calloc(count, sizeof(double));
+    size_t reqHead = 0, respHead = 0;
+    H2Client *h = calloc(1, sizeof(H2Client));
+    int fd;
+
+    fd = connectTo(portNum);
+    for (int i = 0; i < count; i++)
+    {
+        if (!loadHttp1(fd, &load[i], &reqHead, &respHead))
+        {
+            printf("=> HTTP/1.1 request failed\n");
+            return 1;
+        }
+    }
+    close(fd);
+    report("http/1.1", load, count, reqHead, respHead);
+
+    reqHead = respHead = 0;
+    if (!h2Connect(h, portNum))
+        return 1;
+    for (int i = 0; i < count; i++)
+    {
+        if (!loadHttp2(h, &load[i], &reqHead, &respHead))
+            return 1;
+    }
+    close(h->fd);
+    report("h2c multiplexed", load, count, reqHead, respHead);
+    return 0;
+}
@@ -0,0 +1,627 @@
+// Нагрузочный генератор HTTP/1.1 в духе wrk.
+// Потоки держат по своему epoll с частью соединений; в каждом соединении
+// в полете до depth запросов (конвейер), следующий запрос уходит сразу
+// после ответа на предыдущий. С -C запрос идет с Connection: close и на
+// каждый открывается новое соединение. Путь выбирается случайно по весам
+// из смеси маршрутов. Задержка - от записи запроса в сокет до последнего
+// байта ответа, в гистограмме с шагом ~6%.
+// Итог печатается таблицей и, с -j, в JSON для сравнения прогонов
+// (-l - метка прогона, например хэш коммита).
+// Сборка: gcc -O2 -pthread -o http_load bench/http_load.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 ./button > /dev/null &
+//         ./http_load [-t потоков] [-c соединений] [-d секунд] [-p конвейер]
+//                     [-C] [-r /путь:вес,...] [-j файл|-] [-l метка] [порт]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MAX_ROUTES 16
+#define MAX_DEPTH 64        // наибольшая глубина конвейера
+#define IN_SIZE 16384       // буфер приема соединения
+#define OUT_SIZE 8192       // буфер запросов соединения
+#define HIST_SUB 16         // линейных ячеек на степень двойки
+#define HIST_BUCKETS (64 * HIST_SUB)
+
+typedef struct
+{
+    char path[128];
+    int weight;
+    char request[256];  // готовый запрос
+    size_t requestLen;
+} Route;
+
+typedef struct
+{
+    uint64_t requests;
+    uint64_t bytes;         // принято байт ответов
+    uint64_t status[6];     // 1xx..5xx, [0] - прочие коды
+    uint64_t connectErrors, readErrors, writeErrors, parseErrors;
+    uint64_t connections;   // открыто соединений
+    uint64_t latencySum;    // нс
+    uint64_t latencyMax;
+    uint64_t hist[HIST_BUCKETS];
+} Stats;
+
+typedef struct
+{
+    int fd;
+    bool connecting;
+    int inFlight;               // запросов без ответа
+    uint64_t sent[MAX_DEPTH];   // время записи каждого из них, кольцо
+    int sentHead;
+    char out[OUT_SIZE];
+    size_t outLen, outOff;
+    char in[IN_SIZE];
+    size_t inLen;
+    size_t bodyLeft;            // пропускаемый остаток тела текущего ответа
+    bool inBody;
+    int status;
+} Client;
+
+typedef struct
+{
+    pthread_t thread;
+    int conns;
+    uint64_t seed;
+    Stats stats;
+} Worker;
+
+static struct sockaddr_in target;
+static Route routes[MAX_ROUTES];
+static int routeCount, totalWeight;
+static int depth = 1;
+static bool closeMode;
+static uint64_t deadline; // нс, CLOCK_MONOTONIC
+
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Ячейка гистограммы: до 16 нс точно, дальше 16 ячеек на степень двойки
+static int histIndex(uint64_t v)
+{
+    int e;
+
+    if (v < HIST_SUB)
+        return v;
+    e = 63 - __builtin_clzll(v);
+    return (e - 3) * HIST_SUB + ((v >> (e - 4)) & (HIST_SUB - 1));
+}
+
+static uint64_t histLower(int index)
+{
+    int e = index / HIST_SUB + 3;
+
+    if (index < HIST_SUB)
+        return index;
+    return (uint64_t)(HIST_SUB + index % HIST_SUB) << (e - 4);
+}
+
+static uint64_t xorshift(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+static const Route *pickRoute(uint64_t *seed)
+{
+    int r = xorshift(seed) % totalWeight;
+    int i = 0;
+
+    while (r >= routes[i].weight)
+        r -= routes[i++].weight;
+    return &routes[i];
+}
+
+// Дописывает запросы до глубины конвейера; в режиме close - один
+static void fillRequests(Client *cl, uint64_t *seed)
+{
+    int limit = closeMode ? 1 : depth;
+
+    while (cl->inFlight < limit)
+    {
+        const Route *r = pickRoute(seed);
+
+        if (cl->outLen + r->requestLen > OUT_SIZE)
+            break;
+        memcpy(cl->out + cl->outLen, r->request, r->requestLen);
+        cl->outLen += r->requestLen;
+        cl->inFlight++;
+    }
+}
+
+static void closeClient(int epfd, Client *cl)
+{
+    if (cl->fd >= 0)
+    {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, cl->fd, NULL);
+        close(cl->fd);
+    }
+    cl->fd = -1;
+}
+
+// Новое соединение с неблокирующим connect; запросы уходят после него
+static bool openClient(int epfd, Client *cl, Stats *st)
+{
+    struct epoll_event ev;
+    int one = 1;
+
+    cl->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (cl->fd < 0)
+    {
+        st->connectErrors++;
+        return false;
+    }
+    setsockopt(cl->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(cl->fd, (struct sockaddr *)&target, sizeof(target)) < 0 && errno != EINPROGRESS)
+    {
+        st->connectErrors++;
+        close(cl->fd);
+        cl->fd = -1;
+        return false;
+    }
+    cl->connecting = true;
+    cl->inFlight = 0;
+    cl->sentHead = 0;
+    cl->outLen = cl->outOff = cl->inLen = 0;
+    cl->inBody = false;
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.ptr = cl;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, cl->fd, &ev);
+    st->connections++;
+    return true;
+}
+
+static void watchWrite(int epfd, Client *cl, bool on)
+{
+    struct epoll_event ev;
+
+    ev.events = EPOLLIN | (on ? EPOLLOUT : 0);
+    ev.data.ptr = cl;
+    epoll_ctl(epfd, EPOLL_CTL_MOD, cl->fd, &ev);
+}
+
+// Отправляет накопленные запросы; при полном сокете ждет EPOLLOUT
+static bool flushRequests(int epfd, Client *cl, Stats *st)
+{
+    ssize_t n;
+
+    if (cl->outOff == cl->outLen)
+        return true;
+    n = send(cl->fd, cl->out + cl->outOff, cl->outLen - cl->outOff, MSG_NOSIGNAL);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR))
+    {
+        watchWrite(epfd, cl, true);
+        return true;
+    }
+    if (n < 0)
+    {
+        st->writeErrors++;
+        return false;
+    }
+    cl->outOff += n;
+    if (cl->outOff == cl->outLen)
+    {
+        cl->outOff = cl->outLen = 0;
+        watchWrite(epfd, cl, false);
+    }
+    return true;
+}
+
+static void record(Client *cl, Stats *st, uint64_t now)
+{
+    uint64_t latency = now - cl->sent[cl->sentHead];
+
+    cl->sentHead = (cl->sentHead + 1) % MAX_DEPTH;
+    cl->inFlight--;
+    st->requests++;
+    st->status[cl->status >= 100 && cl->status < 600 ? cl->status / 100 : 0]++;
+    st->latencySum += latency;
+    if (latency > st->latencyMax)
+        st->latencyMax = latency;
+    st->hist[histIndex(latency)]++;
+}
+
+// Разбирает принятые ответы; false - ошибка разбора
+static bool parseResponses(Client *cl, Stats *st, uint64_t now, int *done)
+{
+    size_t pos = 0;
+
+    *done = 0;
+    while (pos < cl->inLen)
+    {
+        if (cl->inBody)
+        {
+            size_t n = cl->inLen - pos < cl->bodyLeft ? cl->inLen - pos : cl->bodyLeft;
+
+            pos += n;
+            cl->bodyLeft -= n;
+            if (cl->bodyLeft)
+                break;
+            cl->inBody = false;
+            record(cl, st, now);
+            (*done)++;
+            continue;
+        }
+
+        char *head = cl->in + pos;
+        char *end = memmem(head, cl->inLen - pos, "\r\n\r\n", 4);
+        const char *line;
+
+        if (!end)
+        {
+            if (cl->inLen - pos == IN_SIZE)
+                return false; // заголовки не помещаются в буфер
+            break;
+        }
+        if (cl->inLen - pos < 12 || memcmp(head, "HTTP/1.", 7))
+            return false;
+        cl->status = atoi(head + 9);
+        cl->bodyLeft = 0;
+        for (line = head; line && line < end; line = memchr(line, '\n', end - line))
+        {
+            line++;
+            if (!strncasecmp(line, "Content-Length:", 15))
+                cl->bodyLeft = strtoull(line + 15, NULL, 10);
+        }
+        pos = end + 4 - cl->in;
+        cl->inBody = true;
+        if (!cl->bodyLeft)
+        {
+            cl->inBody = false;
+            record(cl, st, now);
+            (*done)++;
+        }
+    }
+    memmove(cl->in, cl->in + pos, cl->inLen - pos);
+    cl->inLen -= pos;
+    return true;
+}
+
+// Новые запросы в буфер с отметкой времени и их отправка
+static void queueAndSend(int epfd, Client *cl, Worker *w)
+{
+    int before = cl->inFlight;
+    uint64_t now;
+
+    fillRequests(cl, &w->seed);
+    now = nowNs();
+    for (int i = before; i < cl->inFlight; i++)
+        cl->sent[(cl->sentHead + i) % MAX_DEPTH] = now;
+    if (!flushRequests(epfd, cl, &w->stats))
+    {
+        closeClient(epfd, cl);
+        openClient(epfd, cl, &w->stats);
+    }
+}
+
+static void handleEvent(int epfd, Client *cl, uint32_t events, Worker *w)
+{
+    Stats *st = &w->stats;
+
+    if (cl->connecting)
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+            return;
+        getsockopt(cl->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err)
+        {
+            st->connectErrors++;
+            closeClient(epfd, cl);
+            openClient(epfd, cl, st);
+            return;
+        }
+        cl->connecting = false;
+        queueAndSend(epfd, cl, w);
+        return;
+    }
+
+    if (events & EPOLLOUT && !flushRequests(epfd, cl, st))
+    {
+        closeClient(epfd, cl);
+        openClient(epfd, cl, st);
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+    {
+        ssize_t n = recv(cl->fd, cl->in + cl->inLen, IN_SIZE - cl->inLen, 0);
+        int done;
+
+        if (n < 0 && (errno == EAGAIN || errno == EINTR))
+            return;
+        if (n <= 0)
+        {
+            // Закрытие сервером в режиме close после ответа - норма
+            if (cl->inFlight)
+                st->readErrors++;
+            closeClient(epfd, cl);
+            openClient(epfd, cl, st);
+            return;
+        }
+        st->bytes += n;
+        cl->inLen += n;
+        if (!parseResponses(cl, st, nowNs(), &done))
+        {
+            st->parseErrors++;
+            closeClient(epfd, cl);
+            openClient(epfd, cl, st);
+            return;
+        }
+        if (closeMode && done)
+        {
+            closeClient(epfd, cl);
+            openClient(epfd, cl, st);
+        }
+        else if (done)
+        {
+            queueAndSend(epfd, cl, w);
+        }
+    }
+}
+
+static void *workerRun(void *arg)
+{
+    Worker *w = arg;
+    int epfd = epoll_create1(0);
+    Client *clients = calloc(w->conns, sizeof(Client));
+    struct epoll_event events[256];
+
+    for (int i = 0; i < w->conns; i++)
+        openClient(epfd, &clients[i], &w->stats);
+    while (nowNs() < deadline)
+    {
+        int n = epoll_wait(epfd, events, 256, 100);
+
+        for (int i = 0; i < n; i++)
+            handleEvent(epfd, events[i].data.ptr, events[i].events, w);
+    }
+    for (int i = 0; i < w->conns; i++)
+        closeClient(epfd, &clients[i]);
+    free(clients);
+    close(epfd);
+    return NULL;
+}
+
+// Смесь маршрутов "/a:3,/b:1"; вес по умолчанию 1
+static bool parseRoutes(const char *spec)
+{
+    char copy[1024], *save, *item;
+
+    snprintf(copy, sizeof(copy), "%s", spec);
+    for (item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save))
+    {
+        Route *r = &routes[routeCount];
+        char *colon = strrchr(item, ':');
+
+        if (routeCount == MAX_ROUTES || item[0] != '/')
+            return false;
+        r->weight = colon ? atoi(colon + 1) : 1;
+        if (colon)
+            *colon = '\0';
+        if (r->weight <= 0 || strlen(item) >= sizeof(r->path))
+            return false;
+        snprintf(r->path, sizeof(r->path), "%s", item);
+        totalWeight += r->weight;
+        routeCount++;
+    }
+    return routeCount > 0;
+}
+
+static void buildRequests(void)
+{
+    for (int i = 0; i < routeCount; i++)
+        routes[i].requestLen = snprintf(routes[i].request, sizeof(routes[i].request),
+                                        "GET %s HTTP/1.1\r\nHost: localhost\r\n%s\r\n", routes[i].path,
+                                        closeMode ? "Connection: close\r\n" : "");
+}
+
+// Задержка, ниже которой лежит доля q ответов (верхняя граница ячейки)
+static uint64_t percentile(const Stats *st, double q)
+{
+    uint64_t rank = (uint64_t)(q * st->requests), seen = 0;
+
+    for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += st->hist[i];
+        if (seen > rank)
+            return histLower(i + 1 < HIST_BUCKETS ? i + 1 : i);
+    }
+    return st->latencyMax;
+}
+
+static const double quantiles[] = {0.5, 0.75, 0.9, 0.99, 0.999};
+
+static void printReport(const Stats *st, double seconds, int threads, int conns)
+{
+    uint64_t errors = st->connectErrors + st->readErrors + st->writeErrors + st->parseErrors;
+    uint64_t peak = 0;
+
+    printf("=> %d threads, %d connections, depth %d, %s, %.1f s\n", threads, conns, closeMode ? 1 : depth,
+           closeMode ? "close" : "keep-alive", seconds);
+    printf("   requests %llu  %.0f req/s  %.2f MB/s  connections %llu\n", (unsigned long long)st->requests,
+           st->requests / seconds, st->bytes / seconds / 1e6, (unsigned long long)st->connections);
+    printf("   status 2xx %llu  3xx %llu  4xx %llu  5xx %llu  other %llu\n",
+           (unsigned long long)st->status[2], (unsigned long long)st->status[3], (unsigned long long)st->status[4],
+           (unsigned long long)st->status[5], (unsigned long long)(st->status[0] + st->status[1]));
+    printf("   errors %llu (connect %llu, read %llu, write %llu, parse %llu)\n", (unsigned long long)errors,
+           (unsigned long long)st->connectErrors, (unsigned long long)st->readErrors,
+           (unsigned long long)st->writeErrors, (unsigned long long)st->parseErrors);
+    if (!st->requests)
+        return;
+    printf("   latency mean %.1f us  max %.1f us\n", st->latencySum / 1e3 / st->requests, st->latencyMax / 1e3);
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++)
+        printf("   p%-5g %10.1f us\n", quantiles[i] * 100, percentile(st, quantiles[i]) / 1e3);
+
+    // Распределение по степеням двойки микросекунд
+    uint64_t octave[64] = {0};
+    for (int i = 0; i < HIST_BUCKETS; i++)
+        if (st->hist[i])
+            octave[63 - __builtin_clzll(histLower(i) / 1000 | 1)] += st->hist[i];
+    for (int i = 0; i < 64; i++)
+        peak = octave[i] > peak ? octave[i] : peak;
+    for (int i = 0; i < 64; i++)
+    {
+        if (!octave[i])
+            continue;
+        printf("   %8llu us %10llu |", i ? 1ULL << i : 0ULL, (unsigned long long)octave[i]);
+        for (uint64_t k = 0; k < octave[i] * 40 / peak; k++)
+            putchar('#');
+        putchar('\n');
+    }
+}
+
+static void writeJson(FILE *f, const Stats *st, double seconds, int threads, int conns, const char *label)
+{
+    fprintf(f, "{\n  \"label\": \"%s\",\n  \"threads\": %d,\n  \"connections\": %d,\n", label, threads, conns);
+    fprintf(f, "  \"depth\": %d,\n  \"keepAlive\": %s,\n  \"routes\": [", closeMode ? 1 : depth,
+            closeMode ? "false" : "true");
+    for (int i = 0; i < routeCount; i++)
+        fprintf(f, "%s{\"path\": \"%s\", \"weight\": %d}", i ? ", " : "", routes[i].path, routes[i].weight);
+    fprintf(f, "],\n  \"seconds\": %.3f,\n  \"requests\": %llu,\n  \"requestsPerSecond\": %.1f,\n", seconds,
+            (unsigned long long)st->requests, st->requests / seconds);
+    fprintf(f, "  \"bytes\": %llu,\n  \"connectionsOpened\": %llu,\n", (unsigned long long)st->bytes,
+            (unsigned long long)st->connections);
+    fprintf(f, "  \"status\": {\"2xx\": %llu, \"3xx\": %llu, \"4xx\": %llu, \"5xx\": %llu, \"other\": %llu},\n",
+            (unsigned long long)st->status[2], (unsigned long long)st->status[3], (unsigned long long)st->status[4],
+            (unsigned long long)st->status[5], (unsigned long long)(st->status[0] + st->status[1]));
+    fprintf(f, "  \"errors\": {\"connect\": %llu, \"read\": %llu, \"write\": %llu, \"parse\": %llu},\n",
+            (unsigned long long)st->connectErrors, (unsigned long long)st->readErrors,
+            (unsigned long long)st->writeErrors, (unsigned long long)st->parseErrors);
+    fprintf(f, "  \"latencyUs\": {\"mean\": %.2f, \"max\": %.2f", st->requests ? st->latencySum / 1e3 / st->requests : 0,
+            st->latencyMax / 1e3);
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++)
+        fprintf(f, ", \"p%g\": %.2f", quantiles[i] * 100, st->requests ? percentile(st, quantiles[i]) / 1e3 : 0);
+    // Гистограмма: [нижняя граница ячейки в нс, число ответов], только непустые
+    fprintf(f, "},\n  \"histogramNs\": [");
+    for (int i = 0, first = 1; i < HIST_BUCKETS; i++)
+    {
+        if (!st->hist[i])
+            continue;
+        fprintf(f, "%s[%llu, %llu]", first ? "" : ", ", (unsigned long long)histLower(i),
+                (unsigned long long)st->hist[i]);
+        first = 0;
+    }
+    fprintf(f, "]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 2, conns = 64, seconds = 10, opt;
+    const char *routeSpec = "/relay/mask", *jsonPath = NULL, *label = "";
+    int portNum = 8000;
+    struct rlimit lim;
+    Stats total;
+    Worker *workers;
+    uint64_t start;
+    double elapsed;
+
+    while ((opt = getopt(argc, argv, "t:c:d:p:Cr:j:l:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': threads = atoi(optarg); break;
+        case 'c': conns = atoi(optarg); break;
+        case 'd': seconds = atoi(optarg); break;
+        case 'p': depth = atoi(optarg); break;
+        case 'C': closeMode = true; break;
+        case 'r': routeSpec = optarg; break;
+        case 'j': jsonPath = optarg; break;
+        case 'l': label = optarg; break;
+        default:
+            printf("Usage: %s [-t threads] [-c connections] [-d seconds] [-p depth] [-C] "
+                   "[-r /path:weight,...] [-j file|-] [-l label] [port]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc)
+        portNum = atoi(argv[optind]);
+    if (threads < 1 || conns < threads || seconds < 1 || depth < 1 || depth > MAX_DEPTH || !parseRoutes(routeSpec))
+    {
+        printf("=> Bad arguments (depth 1..%d, connections >= threads, routes /path[:weight])\n", MAX_DEPTH);
+        return 1;
+    }
+    buildRequests();
+
+    // Соединений может быть больше предела дескрипторов по умолчанию
+    getrlimit(RLIMIT_NOFILE, &lim);
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+    signal(SIGPIPE, SIG_IGN);
+
+    target.sin_family = AF_INET;
+    target.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &target.sin_addr);
+
+    workers = calloc(threads, sizeof(Worker));
+    start = nowNs();
+    deadline = start + (uint64_t)seconds * 1000000000;
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i].conns = conns / threads + (i < conns % threads);
+        workers[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+        pthread_create(&workers[i].thread, NULL, workerRun, &workers[i]);
+    }
+
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < threads; i++)
+    {
+        const Stats *s = &workers[i].stats;
+
+        pthread_join(workers[i].thread, NULL);
+        total.requests += s->requests;
+        total.bytes += s->bytes;
+        total.connections += s->connections;
+        total.connectErrors += s->connectErrors;
+        total.readErrors += s->readErrors;
+        total.writeErrors += s->writeErrors;
+        total.parseErrors += s->parseErrors;
+        total.latencySum += s->latencySum;
+        total.latencyMax = s->latencyMax > total.latencyMax ? s->latencyMax : total.latencyMax;
+        for (int k = 0; k < 6; k++)
+            total.status[k] += s->status[k];
+        for (int k = 0; k < HIST_BUCKETS; k++)
+            total.hist[k] += s->hist[k];
+    }
+    elapsed = (nowNs() - start) / 1e9;
+
+    printReport(&total, elapsed, threads, conns);
+    if (jsonPath)
+    {
+        FILE *f = strcmp(jsonPath, "-") ? fopen(jsonPath, "w") : stdout;
+
+        if (!f)
+        {
+            printf("=> Can't write %s\n", jsonPath);
+            return 1;
+        }
+        writeJson(f, &total, elapsed, threads, conns, label);
+        if (f != stdout)
+            fclose(f);
+    }
+    free(workers);
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Счетчик обращений к куче для подгрузки через LD_PRELOAD.
+// По сигналу SIGUSR2 число вызовов malloc/calloc/realloc/free
+// записывается в файл из переменной MALLOC_COUNT_FILE.
+// Сборка: gcc -O2 -shared -fPIC -o malloc_count.so bench/malloc_count.c
+// Используется bench/alloc_check.c.
+#include <fcntl.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static _Atomic unsigned long allocs, frees;
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    if (ptr)
+        atomic_fetch_add_explicit(&frees, 1, memory_order_relaxed);
+    __libc_free(ptr);
+}
+
+// Число в десятичном виде без printf (вызывается из обработчика сигнала)
+static size_t formatNumber(char *out, unsigned long value)
+{
+    char tmp[24];
+    size_t n = 0, len = 0;
+
+    do
+        tmp[n++] = '0' + value % 10;
+    while ((value /= 10));
+    while (n)
+        out[len++] = tmp[--n];
+    return len;
+}
+
+static void report(int sig)
+{
+    const char *path = getenv("MALLOC_COUNT_FILE");
+    char line[64];
+    size_t len;
+    int fd;
+
+    (void)sig;
+    if (!path || (fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+        return;
+    len = formatNumber(line, atomic_load(&allocs));
+    line[len++] = ' ';
+    len += formatNumber(line + len, atomic_load(&frees));
+    line[len++] = '\n';
+    if (write(fd, line, len) < 0)
+        len = 0;
+    close(fd);
+}
+
+__attribute__((constructor)) static void install(void)
+{
+    signal(SIGUSR2, report);
+}
@@ -0,0 +1,186 @@
+// Проверка клиента MQTT прошивки (mqtt/mqtt_client.h) в сборке для Linux:
+// скетч с заглушкой брокера в соседнем потоке. Пакет больше буфера
+// отправки (2 * 1460 байт) не отправляется вовсе; когда брокер перестает
+// читать и буфер заполняется, publish() отказывает, а не обрезает пакет,
+// - после того как брокер снова читает, он получает ровно столько целых
+// пакетов, сколько publish() приняла, и ни одного испорченного.
+// Сборка: g++ -O2 -pthread -Ihost -o mqtt_check -x c++ bench/mqtt_check.c
+//           -x none host/Arduino.cpp host/ESP8266WiFi.cpp host/ESPAsyncTCP.cpp host/WString.cpp
+// Запуск: ./mqtt_check (код возврата 0 - проверка пройдена)
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "../mqtt/mqtt_client.h"
+
+const char topic[] = "check";
+const size_t bigPayload = 4000;   // больше буфера отправки
+const size_t smallPayload = 1000; // пакет 1010 байт: в буфер не ложится целое их число
+
+MqttClient mqtt;
+String payload;
+
+// Заглушка брокера: одно соединение; пока stalled, не читает
+struct
+{
+  int listenFd;
+  uint16_t port;
+  volatile bool stalled;
+  volatile int publishes, malformed;
+} broker;
+
+static bool readFull(int fd, void *buf, size_t len)
+{
+  for (size_t got = 0; got < len;)
+  {
+    ssize_t n = read(fd, (char *)buf + got, len - got);
+
+    if (n <= 0)
+      return false;
+    got += n;
+  }
+  return true;
+}
+
+static void *brokerThread(void *)
+{
+  static uint8_t packet[65536];
+  int fd = accept(broker.listenFd, NULL, NULL);
+
+  for (;;)
+  {
+    uint8_t type, b;
+    size_t len = 0, shift = 0;
+
+    while (broker.stalled)
+      usleep(1000);
+    if (!readFull(fd, &type, 1))
+      break;
+    do
+    {
+      if (!readFull(fd, &b, 1))
+        return NULL;
+      len |= (size_t)(b & 127) << shift;
+      shift += 7;
+    } while ((b & 128) && shift < 28);
+    if (len > sizeof(packet) || !readFull(fd, packet, len))
+    {
+      broker.malformed++;
+      break;
+    }
+    switch (type & 0xF0)
+    {
+    case 0x10:
+    {
+      static const uint8_t connack[] = {0x20, 2, 0, 0};
+
+      write(fd, connack, sizeof(connack));
+      break;
+    }
+    case 0x30:
+      // Целый пакет: топик check и данные ровно smallPayload байт из 'p'
+      if (len != 2 + strlen(topic) + smallPayload || memcmp(packet + 2, topic, strlen(topic)) ||
+          packet[len - 1] != 'p')
+        broker.malformed++;
+      else
+        broker.publishes++;
+      break;
+    case 0xC0:
+    {
+      static const uint8_t pingresp[] = {0xD0, 0};
+
+      write(fd, pingresp, sizeof(pingresp));
+      break;
+    }
+    default:
+      broker.malformed++;
+    }
+  }
+  close(fd);
+  return NULL;
+}
+
+static void finish(bool ok, const char *what)
+{
+  printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+  if (!ok)
+    exit(1);
+}
+
+void setup()
+{
+  struct sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  int small = 4096;
+  pthread_t thread;
+
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  broker.listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  setsockopt(broker.listenFd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small)); // буфер заполняется быстрее
+  if (bind(broker.listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(broker.listenFd, 1) < 0 ||
+      getsockname(broker.listenFd, (struct sockaddr *)&addr, &len) < 0)
+    finish(false, "broker socket");
+  broker.port = ntohs(addr.sin_port);
+  pthread_create(&thread, NULL, brokerThread, NULL);
+
+  WiFi.mode(WIFI_STA);
+  WiFi.begin("check", "password");
+  mqtt.setServer("127.0.0.1", broker.port);
+  mqtt.setCredentials("mqtt_check", "", "");
+}
+
+void loop()
+{
+  static int step = 0, accepted = 0;
+  static unsigned long since = millis();
+
+  mqtt.loop();
+  switch (step)
+  {
+  case 0: // подключение
+    if (!mqtt.connected())
+    {
+      if (millis() - since > 3000)
+        finish(false, "connect");
+      return;
+    }
+    payload = String();
+    for (size_t i = 0; i < bigPayload; i++)
+      payload += 'p';
+    finish(!mqtt.publish(topic, payload.c_str()), "payload larger than the send buffer is refused");
+
+    // Брокер не читает: буфер сокета, затем буфер отправки заполняются
+    broker.stalled = true;
+    payload = String();
+    for (size_t i = 0; i < smallPayload; i++)
+      payload += 'p';
+    step = 1;
+    since = millis();
+    break;
+  case 1:
+    if (mqtt.publish(topic, payload.c_str()))
+    {
+      accepted++;
+      return;
+    }
+    if (millis() - since < 500) // отказ - уже не от одного заполнения буфера сокета
+      return;
+    printf("   %d packets accepted before the buffer filled\n", accepted);
+    broker.stalled = false;
+    step = 2;
+    since = millis();
+    break;
+  case 2:
+    if (broker.publishes + broker.malformed < accepted && millis() - since < 5000)
+      return;
+    printf("   broker received %d packets, %d malformed\n", broker.publishes, broker.malformed);
+    finish(broker.publishes == accepted && !broker.malformed, "no truncated packets on a full buffer");
+    finish(mqtt.connected(), "connection kept");
+    exit(0);
+  }
+}
@@ -0,0 +1,151 @@
+// Смешанная нагрузка: медленные переключения реле (/ON, /OFF) идут
+// по нескольким соединениям, а отдельное соединение измеряет задержку
+// быстрой страницы "/". Сравниваются задержки без нагрузки и под ней.
+// Сборка: gcc -O2 -pthread -o pool_mixed bench/pool_mixed.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 BUTTON_GPIO_DELAY_US=2000 ./button > /dev/null &
+//         ./pool_mixed [запросов] [медленных соединений] [порт]
+// Для сравнения - тот же сервер с BUTTON_WORKERS=0.
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static int portNum = 8000;
+static _Atomic bool loading;
+static _Atomic long slowDone;
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connectTo(void)
+{
+    struct sockaddr_in server_addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        printf("=> Error connecting to port %d\n", portNum);
+        exit(1);
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Запрос keep-alive и чтение ответа целиком по Content-Length
+static bool roundTrip(int fd, const char *request)
+{
+    char buf[4096];
+    size_t got = 0, total = 0;
+
+    if (send(fd, request, strlen(request), 0) < 0)
+        return false;
+    while (!total || got < total)
+    {
+        ssize_t n = recv(fd, buf + got, sizeof(buf) - 1 - got, 0);
+        char *end, *cl;
+
+        if (n <= 0)
+            return false;
+        got += n;
+        buf[got] = '\0';
+        if (!total && (end = strstr(buf, "\r\n\r\n")))
+        {
+            cl = strstr(buf, "Content-Length:");
+            total = end + 4 - buf + (cl ? strtoul(cl + 15, NULL, 10) : 0);
+        }
+    }
+    return true;
+}
+
+static void *slowClient(void *arg)
+{
+    int fd = connectTo();
+    bool on = (long)arg & 1;
+
+    while (atomic_load(&loading))
+    {
+        on = !on;
+        if (!roundTrip(fd, on ? "GET /ON HTTP/1.1\r\nHost: bench\r\n\r\n" : "GET /OFF HTTP/1.1\r\nHost: bench\r\n\r\n"))
+            break;
+        atomic_fetch_add(&slowDone, 1);
+    }
+    close(fd);
+    return NULL;
+}
+
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Задержки быстрой страницы по одному соединению
+static void measure(const char *name, int count)
+{
+    static const char request[] = "GET / HTTP/1.1\r\nHost: bench\r\n\r\n";
+    double *samples = malloc(count * sizeof(double));
+    int fd = connectTo();
+
+    for (int i = 0; i < count; i++)
+    {
+        double start = nowUs();
+        if (!roundTrip(fd, request))
+        {
+            printf("=> Connection lost\n");
+            exit(1);
+        }
+        samples[i] = nowUs() - start;
+    }
+    close(fd);
+    qsort(samples, count, sizeof(double), compare);
+    printf("%-26s p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", name,
+           samples[count / 2], samples[count * 99 / 100], samples[count - 1]);
+    free(samples);
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 2000;
+    int slow = argc > 2 ? atoi(argv[2]) : 8;
+    pthread_t *threads;
+    double start;
+    char name[64];
+
+    if (argc > 3)
+        portNum = atoi(argv[3]);
+    threads = calloc(slow, sizeof(pthread_t));
+
+    measure("GET / idle", count);
+
+    atomic_store(&loading, true);
+    for (long i = 0; i < slow; i++)
+        pthread_create(&threads[i], NULL, slowClient, (void *)i);
+    usleep(100000);
+    start = nowUs();
+    atomic_store(&slowDone, 0);
+    snprintf(name, sizeof(name), "GET / with %d slow clients", slow);
+    measure(name, count);
+    printf("%-26s %8.0f req/s\n", "slow /ON, /OFF", atomic_load(&slowDone) / ((nowUs() - start) / 1e6));
+    atomic_store(&loading, false);
+    for (int i = 0; i < slow; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+    return 0;
+}
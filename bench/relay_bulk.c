@@ -0,0 +1,154 @@
+// Включение N реле: N запросов /relay/<n>/on против одного
+// /relay/set?mask= по одному соединению keep-alive. Число записей в порт
+// берется из button_gpio_writes_total до и после каждого прохода.
+// Сборка: gcc -O2 -o relay_bulk bench/relay_bulk.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 BUTTON_GPIO_DELAY_US=2000 BUTTON_RELAYS=64 ./button > /dev/null &
+//         ./relay_bulk [реле] [повторов] [порт]
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connectTo(int portNum)
+{
+    struct sockaddr_in server_addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        printf("=> Error connecting to port %d\n", portNum);
+        exit(1);
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool recvAll(int fd, void *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = recv(fd, (char *)buf + got, len - got, 0);
+        if (n <= 0)
+            return false;
+        got += n;
+    }
+    return true;
+}
+
+// Запрос и ответ целиком: заголовки до пустой строки и тело по Content-Length
+static bool request(int fd, const char *path, char *buf, size_t cap)
+{
+    char req[256];
+    size_t got = 0;
+    char *end = NULL;
+    int len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: bench\r\nAccept: application/json\r\n\r\n", path);
+
+    if (send(fd, req, len, 0) != len)
+        return false;
+    while (!end)
+    {
+        ssize_t n = recv(fd, buf + got, cap - 1 - got, 0);
+        if (n <= 0)
+            return false;
+        got += n;
+        buf[got] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+    }
+    char *cl = strstr(buf, "Content-Length:");
+    size_t body = cl ? strtoul(cl + 15, NULL, 10) : 0;
+    size_t total = end + 4 - buf + body;
+    if (total >= cap)
+        return false;
+    if (got < total && !recvAll(fd, buf + got, total - got))
+        return false;
+    buf[total] = '\0';
+    return strncmp(buf, "HTTP/1.1 200", 12) == 0;
+}
+
+// Успешные записи в порт по счетчику /metrics
+static unsigned long gpioWrites(int fd)
+{
+    static char buf[65536];
+    const char *line;
+
+    if (!request(fd, "/metrics", buf, sizeof(buf)))
+        return 0;
+    line = strstr(buf, "button_gpio_writes_total{result=\"ok\"} ");
+    return line ? strtoul(strchr(line, ' ') + 1, NULL, 10) : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int relays = argc > 1 ? atoi(argv[1]) : 32;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    int portNum = argc > 3 ? atoi(argv[3]) : 8000;
+    uint64_t mask = relays >= 64 ? ~0ULL : (1ULL << relays) - 1;
+    int fd = connectTo(portNum);
+    double single = 0, bulk = 0;
+    unsigned long singleWrites = 0, bulkWrites = 0;
+    char setPath[64], clearPath[64], buf[4096];
+
+    snprintf(setPath, sizeof(setPath), "/relay/set?mask=0x%llx", (unsigned long long)mask);
+    snprintf(clearPath, sizeof(clearPath), "/relay/clear?mask=0x%llx", (unsigned long long)mask);
+    for (int r = 0; r < rounds; r++)
+    {
+        unsigned long writes;
+        double start;
+
+        // По одному запросу на реле
+        if (!request(fd, clearPath, buf, sizeof(buf)))
+            goto failed;
+        writes = gpioWrites(fd);
+        start = nowUs();
+        for (int i = 0; i < relays; i++)
+        {
+            char one[32];
+            snprintf(one, sizeof(one), "/relay/%d/on", i);
+            if (!request(fd, one, buf, sizeof(buf)))
+                goto failed;
+        }
+        single += nowUs() - start;
+        singleWrites += gpioWrites(fd) - writes;
+
+        // Одним запросом
+        if (!request(fd, clearPath, buf, sizeof(buf)))
+            goto failed;
+        writes = gpioWrites(fd);
+        start = nowUs();
+        if (!request(fd, setPath, buf, sizeof(buf)))
+            goto failed;
+        bulk += nowUs() - start;
+        bulkWrites += gpioWrites(fd) - writes;
+    }
+    printf("%-10s relays %d  requests %d  gpio writes %.1f  time %.1f us\n", "per-relay", relays, relays,
+           (double)singleWrites / rounds, single / rounds);
+    printf("%-10s relays %d  requests %d  gpio writes %.1f  time %.1f us\n", "bulk", relays, 1,
+           (double)bulkWrites / rounds, bulk / rounds);
+    close(fd);
+    return 0;
+
+failed:
+    printf("=> Request failed: %s\n", buf);
+    close(fd);
+    return 1;
+}
@@ -0,0 +1,192 @@
+// Нагрузка slowloris: тысячи соединений присылают заголовки запроса по
+// одному байту в секунду и не завершают их; закрытые сервером соединения
+// сразу открываются заново. Параллельно каждые 50 мс выполняется обычный
+// запрос по новому соединению и измеряется его время.
+// Сборка: gcc -O2 -o slowloris bench/slowloris.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 ./button > /dev/null & ./slowloris [соединений] [секунд] [порт]
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define PROBE_INTERVAL_US 50000
+#define PROBE_TIMEOUT_S 5
+
+static int portNum = 8000;
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connectTo(void)
+{
+    struct sockaddr_in server_addr;
+    struct timeval timeout = {PROBE_TIMEOUT_S, 0};
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0)
+        return -1;
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+    return fd;
+}
+
+// Медленное соединение: начало запроса без завершающей пустой строки
+static int openTrickler(void)
+{
+    static const char start[] = "GET / HTTP/1.1\r\nHost: slowloris\r\n";
+    int fd = connectTo();
+
+    if (fd >= 0 && send(fd, start, sizeof(start) - 1, 0) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Еще один байт заголовка; false, если сервер уже закрыл соединение
+static bool trickle(int fd)
+{
+    char c;
+    ssize_t n = recv(fd, &c, 1, MSG_DONTWAIT);
+
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        return false;
+    return send(fd, "X", 1, MSG_DONTWAIT) == 1 || errno == EAGAIN;
+}
+
+// Обычный запрос по новому соединению: время до конца ответа или -1
+static double probe(void)
+{
+    static const char request[] = "GET / HTTP/1.1\r\nHost: probe\r\nConnection: close\r\n\r\n";
+    char buf[4096];
+    double start = nowUs();
+    size_t got = 0;
+    ssize_t n;
+    int fd = connectTo();
+
+    if (fd < 0)
+        return -1;
+    if (send(fd, request, sizeof(request) - 1, 0) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        got += n;
+    close(fd);
+    return n == 0 && got > 0 ? nowUs() - start : -1;
+}
+
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void report(const char *name, double *samples, int count, int failed)
+{
+    if (!count)
+    {
+        printf("%-10s no successful requests, %d failed\n", name, failed);
+        return;
+    }
+    qsort(samples, count, sizeof(double), compare);
+    printf("%-10s %5d ok %4d failed  p50 %8.1f us  p99 %8.1f us  max %9.1f us\n", name, count, failed,
+           samples[count / 2], samples[count * 99 / 100], samples[count - 1]);
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 3000;
+    int seconds = argc > 2 ? atoi(argv[2]) : 30;
+    int *fds, alive = 0, okCount = 0, failed = 0, idleOk = 0, idleFailed = 0;
+    double *samples, idle[100], end, nextTrickle;
+    unsigned long closedByServer = 0;
+
+    if (argc > 3)
+        portNum = atoi(argv[3]);
+    signal(SIGPIPE, SIG_IGN);
+    fds = malloc(count * sizeof(int));
+    samples = malloc((seconds * 1000000 / PROBE_INTERVAL_US + 1) * sizeof(double));
+
+    // Время запроса без нагрузки
+    for (int i = 0; i < 100; i++)
+    {
+        double t = probe();
+        if (t < 0)
+            idleFailed++;
+        else
+            idle[idleOk++] = t;
+    }
+    report("idle", idle, idleOk, idleFailed);
+
+    for (int i = 0; i < count; i++)
+        alive += (fds[i] = openTrickler()) >= 0;
+    printf("=> %d of %d slow connections opened\n", alive, count);
+
+    end = nowUs() + seconds * 1e6;
+    nextTrickle = nowUs();
+    while (nowUs() < end)
+    {
+        double t;
+
+        if (nowUs() >= nextTrickle)
+        {
+            // Раз в секунду каждому медленному соединению по байту
+            alive = 0;
+            for (int i = 0; i < count; i++)
+            {
+                if (fds[i] >= 0 && !trickle(fds[i]))
+                {
+                    close(fds[i]);
+                    fds[i] = -1;
+                    closedByServer++;
+                }
+                if (fds[i] < 0)
+                    fds[i] = openTrickler();
+                alive += fds[i] >= 0;
+            }
+            nextTrickle += 1e6;
+        }
+
+        t = probe();
+        if (t < 0)
+            failed++;
+        else
+            samples[okCount++] = t;
+        usleep(PROBE_INTERVAL_US);
+    }
+    printf("=> %d slow connections alive at the end, %lu closed by the server\n", alive, closedByServer);
+    report("attacked", samples, okCount, failed);
+
+    for (int i = 0; i < count; i++)
+        if (fds[i] >= 0)
+            close(fds[i]);
+    free(fds);
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Замер рассылки состояния реле через /events.
+// Открывает N подписчиков, переключает реле запросом /ON или /OFF и
+// измеряет, через сколько каждый подписчик получил новое событие.
+// Сборка: gcc -O2 -o sse_fanout bench/sse_fanout.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 ./button > /dev/null & ./sse_fanout [подписчиков] [раундов] [порт]
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct
+{
+    int fd;
+    int events;     // сколько событий "data:" получено
+    double arrived; // время прихода последнего события, мкс
+} Watcher;
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connectTo(struct sockaddr_in *addr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0 || connect(fd, (struct sockaddr *)addr, sizeof(*addr)) < 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Считает события в принятых данных; граница событий - пустая строка
+static int countEvents(const char *buf, ssize_t len)
+{
+    int count = 0;
+    for (ssize_t i = 0; i + 5 < len; i++)
+        if (!memcmp(buf + i, "data:", 5))
+            count++;
+    return count;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Читает события, пока все подписчики не получат target событий
+static bool waitEvents(int epfd, Watcher *w, int count, int target, double timeoutUs)
+{
+    struct epoll_event events[512];
+    char buf[4096];
+    double deadline = nowUs() + timeoutUs;
+    int done = 0;
+
+    for (int i = 0; i < count; i++)
+        if (w[i].events >= target)
+            done++;
+
+    while (done < count && nowUs() < deadline)
+    {
+        int n = epoll_wait(epfd, events, 512, 100);
+        for (int i = 0; i < n; i++)
+        {
+            Watcher *x = events[i].data.ptr;
+            ssize_t len = recv(x->fd, buf, sizeof(buf), 0);
+            if (len <= 0)
+            {
+                printf("=> Subscriber disconnected\n");
+                return false;
+            }
+            bool before = x->events >= target;
+            x->events += countEvents(buf, len);
+            x->arrived = nowUs();
+            if (!before && x->events >= target)
+                done++;
+        }
+    }
+    return done == count;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    int portNum = argc > 3 ? atoi(argv[3]) : 8000;
+    struct sockaddr_in server_addr;
+    struct rlimit limit;
+    int epfd = epoll_create1(0);
+    const char subscribe[] = "GET /events HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    Watcher *w = calloc(count, sizeof(Watcher));
+    double *lat = calloc(count, sizeof(double));
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+
+    printf("=> Opening %d subscribers...\n", count);
+    for (int i = 0; i < count; i++)
+    {
+        struct epoll_event ev;
+
+        w[i].fd = connectTo(&server_addr);
+        if (w[i].fd < 0)
+        {
+            printf("=> Error connecting subscriber %d: %s\n", i, strerror(errno));
+            return 1;
+        }
+        send(w[i].fd, subscribe, sizeof(subscribe) - 1, 0);
+        ev.events = EPOLLIN;
+        ev.data.ptr = &w[i];
+        epoll_ctl(epfd, EPOLL_CTL_ADD, w[i].fd, &ev);
+    }
+
+    // Новые подписчики сразу получают текущее состояние, если оно уже есть.
+    // Первое переключение гарантирует одинаковую точку отсчета у всех.
+    int target = 0;
+    for (int r = 0; r <= rounds; r++)
+    {
+        const char *req = (r % 2) ? "GET /OFF HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"
+                                  : "GET /ON HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+        char buf[2048];
+        int toggler;
+        double start;
+
+        waitEvents(epfd, w, count, target, 200000); // добираем начальное состояние
+        for (int i = 0; i < count; i++)
+            target = w[i].events > target ? w[i].events : target;
+        if (!waitEvents(epfd, w, count, target, 5e6))
+        {
+            printf("=> Subscribers did not settle\n");
+            return 1;
+        }
+        target++;
+
+        toggler = connectTo(&server_addr);
+        start = nowUs();
+        send(toggler, req, strlen(req), 0);
+        if (!waitEvents(epfd, w, count, target, 10e6))
+        {
+            printf("=> Timeout waiting for round %d\n", r);
+            return 1;
+        }
+        while (recv(toggler, buf, sizeof(buf), 0) > 0)
+            ;
+        close(toggler);
+
+        if (r == 0)
+            continue; // прогревочный раунд
+        for (int i = 0; i < count; i++)
+            lat[i] = w[i].arrived - start;
+        qsort(lat, count, sizeof(double), compareDouble);
+        printf("round %d: subscribers %d  min %.0f us  p50 %.0f us  p99 %.0f us  max %.0f us\n",
+               r, count, lat[0], lat[count / 2], lat[(int)(count * 0.99)], lat[count - 1]);
+    }
+
+    for (int i = 0; i < count; i++)
+        close(w[i].fd);
+    close(epfd);
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Замер раздачи статики: холодный и теплый кэш метаданных.
+// Создает временный каталог с файлами и их .gz копиями и измеряет
+// время подготовки ответа (поиск, заголовки, выбор кодирования).
+// Затем запрашивает один файл в разных записях пути ("//", "/./") и
+// больше файлов, чем помещается в кэш: число открытых дескрипторов
+// процесса после этого не должно расти.
+// Сборка: gcc -O2 -o static_cache bench/static_cache.c httpd/static.c httpd/buf.c httpd/http.c httpd/arena.c
+// Запуск: ./static_cache [файлов] [повторов]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../httpd/static.h"
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int openFds(void)
+{
+    DIR *d = opendir("/proc/self/fd");
+    int n = 0;
+
+    if (!d)
+        return -1;
+    while (readdir(d))
+        n++;
+    closedir(d);
+    return n;
+}
+
+static void writeFile(const char *name, size_t size)
+{
+    FILE *f = fopen(name, "w");
+    for (size_t i = 0; i < size; i++)
+        fputc('a' + i % 26, f);
+    fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+    int files = argc > 1 ? atoi(argv[1]) : 1000;
+    int repeats = argc > 2 ? atoi(argv[2]) : 100;
+    char dir[] = "/tmp/static_cacheXXXXXX";
+    char name[512], path[64];
+    const char gzip[] = "gzip, deflate";
+    char (*etags)[64] = calloc(files, 64);
+    StaticReply reply;
+    double start, cold, warm, notModified;
+    long served = 0;
+    int fdsBefore, spellingFds, overflowFds;
+
+    if (!mkdtemp(dir))
+    {
+        printf("=> Error creating temporary directory\n");
+        return 1;
+    }
+    for (int i = 0; i < files; i++)
+    {
+        snprintf(name, sizeof(name), "%s/file%d.js", dir, i);
+        writeFile(name, 4096);
+        snprintf(name, sizeof(name), "%s/file%d.js.gz", dir, i);
+        writeFile(name, 1024);
+    }
+    staticInit(dir);
+
+    // Холодный кэш: каждый файл открывается и получает заголовки впервые
+    start = nowNs();
+    for (int i = 0; i < files; i++)
+    {
+        snprintf(path, sizeof(path), "/file%d.js", i);
+        served += staticServe(path, strlen(path), gzip, sizeof(gzip) - 1, NULL, 0, &reply) == 200;
+        const char *etag = strstr(reply.head, "ETag: ") + 6;
+        snprintf(etags[i], 64, "%.*s", (int)(strchr(etag, '\r') - etag), etag);
+    }
+    cold = (nowNs() - start) / files;
+
+    // Теплый кэш: ответ 200 из готовых заголовков
+    start = nowNs();
+    for (int r = 0; r < repeats; r++)
+        for (int i = 0; i < files; i++)
+        {
+            snprintf(path, sizeof(path), "/file%d.js", i);
+            served += staticServe(path, strlen(path), gzip, sizeof(gzip) - 1, NULL, 0, &reply) == 200;
+        }
+    warm = (nowNs() - start) / ((double)files * repeats);
+
+    // Теплый кэш с If-None-Match: ответ 304 без обращения к файлу
+    start = nowNs();
+    for (int r = 0; r < repeats; r++)
+        for (int i = 0; i < files; i++)
+        {
+            snprintf(path, sizeof(path), "/file%d.js", i);
+            served += staticServe(path, strlen(path), gzip, sizeof(gzip) - 1,
+                                  etags[i], strlen(etags[i]), &reply) == 304;
+        }
+    notModified = (nowNs() - start) / ((double)files * repeats);
+
+    // Один файл под 400 записями пути: все они - одна запись кэша
+    fdsBefore = openFds();
+    for (int k = 0; k < 400; k++)
+    {
+        int n = snprintf(path, sizeof(path), "/");
+
+        for (int i = 0; i < k % 20; i++)
+            n += snprintf(path + n, sizeof(path) - n, "./");
+        for (int i = 0; i < k / 20; i++)
+            n += snprintf(path + n, sizeof(path) - n, "/");
+        snprintf(path + n, sizeof(path) - n, "file0.js");
+        served += staticServe(path, strlen(path), gzip, sizeof(gzip) - 1, NULL, 0, &reply) == 200;
+    }
+    spellingFds = openFds() - fdsBefore;
+
+    // Файлов больше, чем помещается в кэш: старые вытесняются
+    for (int r = 0; r < 3; r++)
+        for (int i = 0; i < files; i++)
+        {
+            snprintf(path, sizeof(path), "/file%d.js", i);
+            served += staticServe(path, strlen(path), gzip, sizeof(gzip) - 1, NULL, 0, &reply) == 200;
+        }
+    overflowFds = openFds();
+
+    printf("files %d  cold %.0f ns/req  warm 200 %.0f ns/req  warm 304 %.0f ns/req  (%ld ok)\n",
+           files, cold, warm, notModified, served);
+    printf("path spellings: %+d fds  open fds after %d files: %d\n", spellingFds, files, overflowFds);
+
+    staticFlush();
+    for (int i = 0; i < files; i++)
+    {
+        snprintf(name, sizeof(name), "%s/file%d.js", dir, i);
+        unlink(name);
+        snprintf(name, sizeof(name), "%s/file%d.js.gz", dir, i);
+        unlink(name);
+    }
+    rmdir(dir);
+    return 0;
+}
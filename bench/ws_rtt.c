@@ -0,0 +1,173 @@
+// Замер времени переключения реле: кадры WebSocket (/ws) против
+// запросов HTTP/1.1 keep-alive (/ON, /OFF) по одному соединению.
+// Сборка: gcc -O2 -o ws_rtt bench/ws_rtt.c
+// Запуск: BUTTON_RATE=0 BUTTON_CONN_RATE=0 BUTTON_WS_RATE=0 ./button > /dev/null & ./ws_rtt [переключений] [порт]
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connectTo(int portNum)
+{
+    struct sockaddr_in server_addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(portNum);
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        printf("=> Error connecting to port %d\n", portNum);
+        exit(1);
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool recvAll(int fd, void *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = recv(fd, (char *)buf + got, len - got, 0);
+        if (n <= 0)
+            return false;
+        got += n;
+    }
+    return true;
+}
+
+// Читает ответ HTTP целиком: заголовки до пустой строки и тело по Content-Length
+static bool recvResponse(int fd, char *buf, size_t cap)
+{
+    size_t got = 0;
+    char *end = NULL;
+
+    while (!end)
+    {
+        ssize_t n = recv(fd, buf + got, cap - 1 - got, 0);
+        if (n <= 0)
+            return false;
+        got += n;
+        buf[got] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+    }
+    char *cl = strstr(buf, "Content-Length:");
+    size_t body = cl ? strtoul(cl + 15, NULL, 10) : 0;
+    size_t total = end + 4 - buf + body;
+    return got >= total || recvAll(fd, buf + got, total - got);
+}
+
+// Читает заголовки побайтно, чтобы не захватить следующий за ними кадр
+static bool recvHeaders(int fd, char *buf, size_t cap)
+{
+    size_t got = 0;
+
+    while (got < 4 || memcmp(buf + got - 4, "\r\n\r\n", 4))
+    {
+        if (got == cap - 1 || recv(fd, buf + got, 1, 0) != 1)
+            return false;
+        got++;
+    }
+    buf[got] = '\0';
+    return true;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *rtt, int count)
+{
+    double sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += rtt[i];
+    qsort(rtt, count, sizeof(double), compareDouble);
+    printf("%-16s toggles %d  mean %.1f us  p50 %.1f us  p99 %.1f us  max %.1f us\n",
+           name, count, sum / count, rtt[count / 2], rtt[(int)(count * 0.99)], rtt[count - 1]);
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    int portNum = argc > 2 ? atoi(argv[2]) : 8000;
+    double *rtt = calloc(count, sizeof(double));
+    char buf[4096];
+    uint8_t state[12]; // кадр [WS_MSG_STATE, реле 0, маска реле]
+    int fd;
+
+    // WebSocket: рукопожатие, затем кадр-команда и ответный кадр состояния
+    fd = connectTo(portNum);
+    const char upgrade[] = "GET /ws HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                           "Sec-WebSocket-Version: 13\r\n"
+                           "\r\n";
+    send(fd, upgrade, sizeof(upgrade) - 1, 0);
+    if (!recvHeaders(fd, buf, sizeof(buf)) || strncmp(buf, "HTTP/1.1 101", 12) ||
+        !strstr(buf, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo="))
+    {
+        printf("=> WebSocket handshake failed\n");
+        return 1;
+    }
+    recvAll(fd, state, sizeof(state)); // текущее состояние при подписке
+    for (int i = 0; i < count; i++)
+    {
+        uint8_t cmd = !state[3];
+        uint8_t frame[7] = {0x82, 0x81, 0x12, 0x34, 0x56, 0x78, (uint8_t)(cmd ^ 0x12)};
+        double start = nowUs();
+
+        send(fd, frame, sizeof(frame), 0);
+        do
+        {
+            if (!recvAll(fd, state, sizeof(state)))
+            {
+                printf("=> WebSocket closed\n");
+                return 1;
+            }
+        } while (state[3] != cmd);
+        rtt[i] = nowUs() - start;
+    }
+    close(fd);
+    report("websocket", rtt, count);
+
+    // HTTP/1.1 keep-alive: полный запрос и ответ со страницей на каждое переключение
+    fd = connectTo(portNum);
+    for (int i = 0; i < count; i++)
+    {
+        const char *req = (i % 2) ? "GET /OFF HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                                  : "GET /ON HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        double start = nowUs();
+
+        send(fd, req, strlen(req), 0);
+        if (!recvResponse(fd, buf, sizeof(buf)))
+        {
+            printf("=> HTTP connection closed\n");
+            return 1;
+        }
+        rtt[i] = nowUs() - start;
+    }
+    close(fd);
+    report("http keep-alive", rtt, count);
+    return 0;
+}
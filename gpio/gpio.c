@@ -0,0 +1,90 @@
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include "gpio.h"
+
+static int lineFd = -1;          // запрос линий GPIO_V2_GET_LINE_IOCTL
+static int lineCount;
+static uint64_t allMask;
+static unsigned simulatedDelayUs;
+static _Atomic uint64_t state;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+bool gpioInit(const char *chip, const unsigned *lines, int count, unsigned delayUs)
+{
+    struct gpio_v2_line_request req;
+    int chipFd;
+
+    if (count < 1 || count > GPIO_MAX_LINES)
+        return false;
+    lineCount = count;
+    allMask = count == 64 ? ~0ULL : (1ULL << count) - 1;
+    simulatedDelayUs = delayUs;
+    if (!chip)
+        return true;
+
+    // Все линии запрашиваются одним запросом, чтобы писать их одним ioctl
+    memset(&req, 0, sizeof(req));
+    for (int i = 0; i < count; i++)
+        req.offsets[i] = lines[i];
+    req.num_lines = count;
+    snprintf(req.consumer, sizeof(req.consumer), "button");
+    req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+    req.config.num_attrs = 1;
+    req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+    req.config.attrs[0].attr.values = 0;
+    req.config.attrs[0].mask = allMask;
+
+    chipFd = open(chip, O_RDWR | O_CLOEXEC);
+    if (chipFd < 0)
+        return false;
+    if (ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req) < 0)
+    {
+        close(chipFd);
+        return false;
+    }
+    close(chipFd);
+    lineFd = req.fd;
+    return true;
+}
+
+int gpioCount(void)
+{
+    return lineCount;
+}
+
+bool gpioUpdate(uint64_t set, uint64_t clear)
+{
+    uint64_t old, next, changed;
+    bool ok = true;
+
+    pthread_mutex_lock(&lock);
+    old = atomic_load(&state);
+    next = ((old | set) & ~clear) & allMask;
+    changed = old ^ next;
+    if (lineFd >= 0 && changed)
+    {
+        struct gpio_v2_line_values values = {.bits = next, .mask = changed};
+        ok = ioctl(lineFd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) == 0;
+    }
+    else if (lineFd < 0 && simulatedDelayUs)
+    {
+        struct timespec delay = {simulatedDelayUs / 1000000, (simulatedDelayUs % 1000000) * 1000};
+        nanosleep(&delay, NULL);
+    }
+    if (ok)
+        atomic_store(&state, next);
+    pthread_mutex_unlock(&lock);
+    return ok;
+}
+
+uint64_t gpioState(void)
+{
+    return atomic_load(&state);
+}
@@ -0,0 +1,27 @@
+// Выходы реле: линии GPIO через символьное устройство (/dev/gpiochipN)
+// или имитация. Состояние всех выходов - битовая маска; изменение любого
+// набора реле выполняется одной записью порта (GPIO_V2_LINE_SET_VALUES).
+// Запись блокирующая и сериализуется внутри модуля, поэтому ее
+// вызывают из рабочих потоков, а не из цикла epoll.
+#ifndef GPIO_GPIO_H
+#define GPIO_GPIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GPIO_MAX_LINES 64
+
+// chip == NULL - имитация count выходов с задержкой delayUs на запись;
+// иначе lines[] - номера линий чипа chip
+bool gpioInit(const char *chip, const unsigned *lines, int count, unsigned delayUs);
+
+// Число выходов
+int gpioCount(void);
+
+// Включает биты set и выключает биты clear одной записью; false при ошибке
+bool gpioUpdate(uint64_t set, uint64_t clear);
+
+// Последнее записанное состояние
+uint64_t gpioState(void);
+
+#endif
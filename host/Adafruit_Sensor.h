@@ -0,0 +1,5 @@
+// Общий интерфейс датчиков Adafruit; прошивка им не пользуется.
+#ifndef HOST_ADAFRUIT_SENSOR_H
+#define HOST_ADAFRUIT_SENSOR_H
+
+#endif
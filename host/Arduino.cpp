@@ -0,0 +1,319 @@
+#include <malloc.h>
+#include <sys/random.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <new>
+#include "Arduino.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+#define HIST_SUB 16 // линейных ячеек на степень двойки
+#define HIST_BUCKETS (64 * HIST_SUB)
+
+static char **savedArgv;
+static uint8_t pinLevel[32];
+
+static bool virtualClock;
+static uint64_t virtualUs;
+static uint64_t delayedNs; // время в delay() за текущую итерацию loop()
+static uint64_t loopSpanMaxUs; // самая долгая итерация вместе с delay(), по часам прошивки
+
+static volatile sig_atomic_t stopRequested;
+// Распределение длительностей в гистограмме с шагом ~6%
+struct Timings
+{
+  uint64_t hist[HIST_BUCKETS];
+  uint64_t count, totalNs, maxNs;
+};
+
+static Timings loopTimes, handlerTimes;
+
+// Куча прошивки: String и контейнеры заглушек выделяют память через new
+static size_t heapLive, heapPeak;
+static size_t loopHeapPeak; // наибольший прирост кучи за итерацию loop()
+
+uint64_t hostNowNs()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static const uint64_t startNs = hostNowNs();
+
+static uint64_t nowUs()
+{
+  return virtualClock ? virtualUs : (hostNowNs() - startNs) / 1000;
+}
+
+unsigned long millis()
+{
+  return nowUs() / 1000;
+}
+
+unsigned long micros()
+{
+  return nowUs();
+}
+
+static void sleepUs(uint64_t us)
+{
+  uint64_t start = hostNowNs();
+  struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+
+  if (virtualClock)
+  {
+    virtualUs += us;
+    return;
+  }
+  nanosleep(&ts, NULL);
+  delayedNs += hostNowNs() - start;
+}
+
+// Работа системы между шагами прошивки - события соединений
+// (hostAsyncPoll()); ее время, как и сон, не входит во время loop()
+static void runSystem()
+{
+  uint64_t start = hostNowNs();
+
+  hostAsyncPoll();
+  delayedNs += hostNowNs() - start;
+}
+
+void delay(unsigned long ms)
+{
+  fflush(stdout);
+  runSystem();
+  sleepUs((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  sleepUs(us);
+}
+
+void hostBusy(unsigned long us)
+{
+  uint64_t end = hostNowNs() + (uint64_t)us * 1000;
+
+  // Процессор занят и на виртуальных часах: время прошивки тоже идет
+  while (hostNowNs() < end)
+    ;
+  if (virtualClock)
+    virtualUs += us;
+}
+
+void yield()
+{
+  runSystem();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin < sizeof(pinLevel))
+    pinLevel[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < sizeof(pinLevel) ? pinLevel[pin] : LOW;
+}
+
+int HardwareSerial::printf(const char *format, ...)
+{
+  va_list ap;
+  int n;
+
+  va_start(ap, format);
+  n = vprintf(format, ap);
+  va_end(ap);
+  return n;
+}
+
+// Аппаратный генератор случайных чисел модуля - здесь генератор ядра
+uint32_t EspClass::random()
+{
+  uint32_t value = 0;
+
+  getrandom(&value, sizeof(value), 0);
+  return value;
+}
+
+void EspClass::restart()
+{
+  char path[4096];
+  ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+
+  // Путь к файлу, а не /proc/self/exe, чтобы имя процесса не менялось
+  fflush(stdout);
+  if (len > 0)
+  {
+    path[len] = '\0';
+    execv(path, savedArgv);
+  }
+  _exit(1);
+}
+
+void *operator new(size_t size)
+{
+  void *p = malloc(size ? size : 1);
+
+  if (!p)
+    throw std::bad_alloc();
+  heapLive += malloc_usable_size(p);
+  if (heapLive > heapPeak)
+    heapPeak = heapLive;
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  if (!p)
+    return;
+  heapLive -= malloc_usable_size(p);
+  free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept
+{
+  (void)size;
+  operator delete(p);
+}
+
+static int histIndex(uint64_t v)
+{
+  int e;
+
+  if (v < HIST_SUB)
+    return v;
+  e = 63 - __builtin_clzll(v);
+  return (e - 3) * HIST_SUB + ((v >> (e - 4)) & (HIST_SUB - 1));
+}
+
+static uint64_t histLower(int index)
+{
+  int e = index / HIST_SUB + 3;
+
+  if (index < HIST_SUB)
+    return index;
+  return (uint64_t)(HIST_SUB + index % HIST_SUB) << (e - 4);
+}
+
+static void addTiming(Timings *t, uint64_t ns)
+{
+  t->hist[histIndex(ns)]++;
+  t->count++;
+  t->totalNs += ns;
+  if (ns > t->maxNs)
+    t->maxNs = ns;
+}
+
+void hostHandlerTime(uint64_t ns)
+{
+  addTiming(&handlerTimes, ns);
+}
+
+static uint64_t percentile(const Timings *t, double q)
+{
+  uint64_t rank = (uint64_t)(q * t->count), seen = 0;
+
+  for (int i = 0; i < HIST_BUCKETS; i++)
+  {
+    seen += t->hist[i];
+    if (seen > rank)
+      return histLower(i + 1 < HIST_BUCKETS ? i + 1 : i);
+  }
+  return t->maxNs;
+}
+
+// Строки "имя_mean_us значение" и процентили
+static void writeTimings(FILE *f, const char *prefix, const Timings *t)
+{
+  static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+  fprintf(f, "%smean_us %.3f\n", prefix, t->count ? t->totalNs / 1e3 / t->count : 0.0);
+  for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++)
+    fprintf(f, "%sp%g_us %.3f\n", prefix, quantiles[i] * 100, percentile(t, quantiles[i]) / 1e3);
+  fprintf(f, "%smax_us %.3f\n", prefix, t->maxNs / 1e3);
+}
+
+static void writeLoopStats(const char *path)
+{
+  FILE *f = fopen(path, "w");
+
+  if (!f)
+  {
+    perror(path);
+    return;
+  }
+  fprintf(f, "loops %llu\n", (unsigned long long)loopTimes.count);
+  fprintf(f, "virtual_ms %lu\n", millis());
+  writeTimings(f, "", &loopTimes);
+  fprintf(f, "span_max_us %llu\n", (unsigned long long)loopSpanMaxUs);
+  fprintf(f, "handlers %llu\n", (unsigned long long)handlerTimes.count);
+  writeTimings(f, "handler_", &handlerTimes);
+  fprintf(f, "heap_live_bytes %zu\n", heapLive);
+  fprintf(f, "heap_loop_peak_bytes %zu\n", loopHeapPeak);
+  fclose(f);
+}
+
+static void onStop(int sig)
+{
+  (void)sig;
+  stopRequested = 1;
+}
+
+int main(int argc, char **argv)
+{
+  const char *clock = getenv("HOST_CLOCK");
+  const char *statsPath = getenv("HOST_LOOP_STATS");
+  const char *loops = getenv("HOST_LOOPS");
+  uint64_t maxLoops = loops ? strtoull(loops, NULL, 10) : 0;
+
+  (void)argc;
+  savedArgv = argv;
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  virtualClock = clock && !strcmp(clock, "virtual");
+  if (statsPath)
+  {
+    signal(SIGINT, onStop);
+    signal(SIGTERM, onStop);
+  }
+  setup();
+  if (!statsPath)
+    for (;;)
+    {
+      loop();
+      runSystem();
+    }
+
+  while (!stopRequested && (!maxLoops || loopTimes.count < maxLoops))
+  {
+    uint64_t start = hostNowNs(), spanStart = nowUs(), busy;
+    size_t heapStart = heapLive;
+
+    delayedNs = 0;
+    heapPeak = heapLive;
+    loop();
+    runSystem();
+    if (heapPeak - heapStart > loopHeapPeak)
+      loopHeapPeak = heapPeak - heapStart;
+    busy = hostNowNs() - start - delayedNs;
+    addTiming(&loopTimes, busy);
+    if (nowUs() - spanStart > loopSpanMaxUs)
+      loopSpanMaxUs = nowUs() - spanStart;
+  }
+  writeLoopStats(statsPath);
+  return 0;
+}
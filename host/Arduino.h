@@ -0,0 +1,120 @@
+// Ядро Arduino для сборки прошивки под Linux: время, выводы, Serial и
+// перезапуск. Программа - обычный процесс: main() из Arduino.cpp
+// вызывает setup() и затем loop() без конца, Serial пишет в stdout,
+// выводы только запоминают уровень.
+// Переменные окружения:
+//   HOST_CLOCK=virtual - виртуальные millis(): время идет только в delay()
+//                        и delayMicroseconds(), без сна, так что loop()
+//                        крутится с полной скоростью, а таймеры прошивки
+//                        срабатывают по ее собственному счету времени;
+//   HOST_LOOP_STATS=файл - время работы каждого вызова loop() без времени
+//                        в delay(); по SIGINT/SIGTERM или после HOST_LOOPS
+//                        итераций в файл пишутся число итераций и
+//                        процентили (строки "имя значение"), самая
+//                        долгая итерация вместе с delay() - сколько
+//                        прошивка не отвечала, - то же для
+//                        обработчиков запросов веб-сервера, объем кучи
+//                        прошивки (operator new) и наибольший ее прирост
+//                        за одну итерацию.
+// Остальные заглушки: EEPROM.h (файл), LittleFS.h (каталог), DHT.h
+// (сценарий показаний), ESP8266WiFi.h (сокеты), ESPAsyncTCP.h (сокеты
+// без ожидания).
+// Сборка прошивки main.c:
+//   gcc -O2 -c httpd/*.c
+//   g++ -O2 -pthread -Ihost -o esp_relay -x c++ main.c -x none host/*.cpp *.o
+// Запуск: HOST_HTTP_PORT=8080 ./esp_relay
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "pgmspace.h"
+#include "WString.h"
+#include "IPAddress.h"
+
+typedef uint8_t byte;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+
+// Выводы NodeMCU
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+
+void setup();
+void loop();
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// Для заглушек: время на часах хоста, а не прошивки, и занятость
+// процессора на us микросекунд (как блокирующий обмен с датчиком)
+uint64_t hostNowNs();
+void hostBusy(unsigned long us);
+// Время обработчика запроса для HOST_LOOP_STATS
+void hostHandlerTime(uint64_t ns);
+// События соединений ESPAsyncTCP (ESPAsyncTCP.cpp): на устройстве их
+// раздает система между шагами loop() и в delay()/yield()
+void hostAsyncPoll();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+class HardwareSerial
+{
+public:
+  void begin(unsigned long baud) { (void)baud; }
+
+  size_t print(const char *s) { return fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+  size_t print(const IPAddress &ip) { return print(ip.toString()); }
+  size_t print(char c) { return putchar(c) != EOF; }
+  size_t print(int n) { return print(String(n)); }
+  size_t print(unsigned int n) { return print(String(n)); }
+  size_t print(long n) { return print(String(n)); }
+  size_t print(unsigned long n) { return print(String(n)); }
+  size_t print(double n, int digits = 2) { return print(String(n, digits)); }
+
+  template <typename T> size_t println(const T &value)
+  {
+    size_t n = print(value);
+    return n + println();
+  }
+  size_t println() { return print("\r\n"); }
+
+  int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+  // Процесс запускается заново с теми же аргументами
+  void restart();
+  void reset() { restart(); }
+  uint32_t random();
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,123 @@
+// Датчик DHT в сборке для Linux. Показания берутся из сценария
+// HOST_DHT_SCRIPT - файла со строками "мс температура влажность" по часам
+// прошивки (millis()); между точками значения меняются линейно, после
+// последней остаются ее значениями, nan - ошибка чтения. Без сценария -
+// постоянные 21.5 °C и 40 %.
+// Чтение ведет себя как у библиотеки Adafruit: опрос датчика занимает
+// процессор на HOST_DHT_READ_US микросекунд (по умолчанию 5000 - стартовый
+// импульс и 40 бит с запрещенными прерываниями), а повторный запрос раньше
+// чем через 2 с без force возвращает прошлый результат.
+#ifndef HOST_DHT_H
+#define HOST_DHT_H
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT
+{
+public:
+  static const uint32_t MIN_INTERVAL = 2000;
+
+  DHT(uint8_t pin, uint8_t type)
+  {
+    (void)pin;
+    (void)type;
+  }
+  void begin()
+  {
+    const char *script = getenv("HOST_DHT_SCRIPT");
+    const char *cost = getenv("HOST_DHT_READ_US");
+    FILE *f = script ? fopen(script, "r") : NULL;
+    char line[128];
+
+    readUs = cost ? strtoul(cost, NULL, 10) : 5000;
+    points.clear();
+    while (f && fgets(line, sizeof(line), f))
+    {
+      Point p;
+
+      if (line[0] != '#' && sscanf(line, "%lu %f %f", &p.ms, &p.temperature, &p.humidity) == 3)
+        points.push_back(p);
+    }
+    if (f)
+    {
+      fclose(f);
+      printf("=> DHT: %zu points from %s\n", points.size(), script);
+    }
+    else if (script)
+      printf("=> DHT: cannot open %s\n", script);
+    lastReadTime = millis() - MIN_INTERVAL;
+  }
+  float readTemperature(bool fahrenheit = false, bool force = false)
+  {
+    read(force);
+    return fahrenheit ? temperature * 1.8f + 32 : temperature;
+  }
+  float readHumidity(bool force = false)
+  {
+    read(force);
+    return humidity;
+  }
+
+  // Число настоящих опросов датчика (для замеров)
+  unsigned long reads = 0;
+
+private:
+  struct Point
+  {
+    unsigned long ms;
+    float temperature, humidity;
+  };
+
+  std::vector<Point> points;
+  unsigned long readUs = 5000;
+  uint32_t lastReadTime = 0;
+  float temperature = NAN, humidity = NAN;
+
+  bool read(bool force)
+  {
+    uint32_t now = millis();
+
+    if (!force && now - lastReadTime < MIN_INTERVAL)
+      return !isnan(temperature);
+    lastReadTime = now;
+    hostBusy(readUs);
+    reads++;
+    sample(millis());
+    return !isnan(temperature);
+  }
+
+  void sample(unsigned long now)
+  {
+    size_t i = 0;
+
+    if (points.empty())
+    {
+      temperature = 21.5f;
+      humidity = 40.0f;
+      return;
+    }
+    while (i < points.size() && points[i].ms <= now)
+      i++;
+    if (i == 0 || i == points.size())
+    {
+      const Point &p = points[i ? i - 1 : 0];
+
+      temperature = p.temperature;
+      humidity = p.humidity;
+      return;
+    }
+    const Point &a = points[i - 1], &b = points[i];
+    float k = (float)(now - a.ms) / (b.ms - a.ms);
+
+    temperature = a.temperature + (b.temperature - a.temperature) * k;
+    humidity = a.humidity + (b.humidity - a.humidity) * k;
+  }
+};
+
+#endif
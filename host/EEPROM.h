@@ -0,0 +1,78 @@
+// Эмуляция EEPROM в сборке для Linux: область в памяти процесса, которую
+// begin() читает из файла (HOST_EEPROM, по умолчанию eeprom.bin в текущем
+// каталоге), а commit() записывает обратно - настройки переживают
+// перезапуск, как на устройстве. Без файла область, как у только что
+// стертой флэш-памяти, заполнена 0xFF.
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <stdlib.h>
+#include <vector>
+#include "Arduino.h"
+
+class EEPROMClass
+{
+public:
+  void begin(size_t size)
+  {
+    FILE *f = fopen(path(), "rb");
+
+    data.assign(size, 0xFF);
+    if (f)
+    {
+      size_t n = fread(data.data(), 1, size, f);
+
+      fclose(f);
+      printf("=> EEPROM: %zu bytes from %s\n", n, path());
+    }
+  }
+  uint8_t read(int address) const { return (size_t)address < data.size() ? data[address] : 0; }
+  void write(int address, uint8_t value)
+  {
+    if ((size_t)address < data.size())
+      data[address] = value;
+  }
+  template <typename T> T &get(int address, T &t)
+  {
+    if (address + sizeof(T) <= data.size())
+      memcpy(&t, &data[address], sizeof(T));
+    return t;
+  }
+  template <typename T> const T &put(int address, const T &t)
+  {
+    if (address + sizeof(T) <= data.size())
+      memcpy(&data[address], &t, sizeof(T));
+    return t;
+  }
+  // Через временный файл и rename: прерванная запись не портит настройки
+  bool commit()
+  {
+    String tmp = String(path()) + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    bool ok = f && fwrite(data.data(), 1, data.size(), f) == data.size();
+
+    if (f && fclose(f))
+      ok = false;
+    if (ok)
+      ok = rename(tmp.c_str(), path()) == 0;
+    if (!ok)
+      printf("=> EEPROM: error writing %s\n", path());
+    return ok;
+  }
+  void end() {}
+  size_t length() const { return data.size(); }
+
+private:
+  std::vector<uint8_t> data;
+
+  static const char *path()
+  {
+    const char *p = getenv("HOST_EEPROM");
+
+    return p ? p : "eeprom.bin";
+  }
+};
+
+inline EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,17 @@
+// Обновление по воздуху в сборке для Linux невозможно: /update отвечает 501.
+#ifndef HOST_ESP8266HTTPUPDATESERVER_H
+#define HOST_ESP8266HTTPUPDATESERVER_H
+
+#include "ESP8266WebServer.h"
+
+class ESP8266HTTPUpdateServer
+{
+public:
+  void setup(ESP8266WebServer *server, const char *path = "/update")
+  {
+    server->on(path, [server]()
+               { server->send(501, "text/plain", "OTA update is not available on host"); });
+  }
+};
+
+#endif
@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include "ESP8266WebServer.h"
+
+static const char *const methodNames[] = {NULL, "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS"};
+
+static String fieldValue(const HttpField *field)
+{
+  String value;
+
+  value.concat(field->value, field->valueLen);
+  return value;
+}
+
+ESP8266WebServer::ESP8266WebServer(int port) : port(port)
+{
+  serverInit(&server, this);
+  notFound.owner = this;
+}
+
+ESP8266WebServer::~ESP8266WebServer()
+{
+  close();
+}
+
+void ESP8266WebServer::begin()
+{
+  const char *env = getenv("HOST_HTTP_PORT");
+
+  begin(env ? atoi(env) : port);
+}
+
+// Повторный begin() при работающем сервере ничего не делает, как в библиотеке
+void ESP8266WebServer::begin(uint16_t port)
+{
+  if (server.fd >= 0)
+    return;
+  this->port = port;
+  if (!serverBegin(&server, port))
+    printf("=> Error binding HTTP server to port %u\n", port);
+}
+
+void ESP8266WebServer::close()
+{
+  serverStop(&server);
+}
+
+void ESP8266WebServer::handleClient()
+{
+  serverPoll(&server, 0);
+}
+
+void ESP8266WebServer::on(const String &uri, HTTPMethod method, THandlerFunction fn)
+{
+  Handler *h;
+
+  if (server.router.count == ROUTER_MAX_ROUTES)
+    return;
+  h = &handlers[server.router.count];
+  h->owner = this;
+  h->uri = uri;
+  h->fn = fn;
+  routerAdd(&server.router, methodNames[method], h->uri.c_str(), false, dispatch, h);
+}
+
+void ESP8266WebServer::onNotFound(THandlerFunction fn)
+{
+  notFound.fn = fn;
+  server.router.notFound.handler = dispatch;
+  server.router.notFound.arg = &notFound;
+}
+
+// Обработчик маршрута: вызов функции прошивки с текущим запросом
+int ESP8266WebServer::dispatch(void *ctx, const HttpRequest *req)
+{
+  HttpExchange *x = (HttpExchange *)ctx;
+  Handler *h = (Handler *)x->route->arg;
+  ESP8266WebServer *self = h->owner;
+  uint64_t start;
+
+  (void)req;
+  self->current = x;
+  self->contentLength = CONTENT_LENGTH_NOT_SET;
+  self->headers.clear();
+  start = hostNowNs();
+  h->fn();
+  hostHandlerTime(hostNowNs() - start);
+  self->current = NULL;
+  // Ответ позже ядро допускает, а библиотека - нет: обработчик, который не
+  // ответил и не забрал соединение, получает 500
+  if (!x->reply.status && !x->reply.ended)
+    serverSend(x, 500, "text/plain", "Internal Server Error", 21);
+  return x->reply.status;
+}
+
+String ESP8266WebServer::uri() const
+{
+  return current ? String(current->req->path) : String();
+}
+
+HTTPMethod ESP8266WebServer::method() const
+{
+  if (current)
+  {
+    for (int i = HTTP_GET; i <= HTTP_OPTIONS; i++)
+    {
+      if (!strcmp(current->req->method, methodNames[i]))
+        return (HTTPMethod)i;
+    }
+  }
+  return HTTP_ANY;
+}
+
+String ESP8266WebServer::arg(const String &name) const
+{
+  const char *value;
+  size_t len;
+
+  if (!current)
+    return String();
+  // Тело запроса целиком, как в библиотеке ESP8266
+  if (name == "plain")
+  {
+    String body;
+    body.concat(current->req->body, current->req->bodyLen);
+    return body;
+  }
+  value = httpField(current->req->args, current->req->argCount, name.c_str(), &len);
+  return value ? String(value) : String();
+}
+
+String ESP8266WebServer::arg(int i) const
+{
+  return current && i >= 0 && i < current->req->argCount ? fieldValue(&current->req->args[i]) : String();
+}
+
+String ESP8266WebServer::argName(int i) const
+{
+  String name;
+
+  if (current && i >= 0 && i < current->req->argCount)
+    name.concat(current->req->args[i].name, current->req->args[i].nameLen);
+  return name;
+}
+
+int ESP8266WebServer::args() const
+{
+  return current ? current->req->argCount : 0;
+}
+
+bool ESP8266WebServer::hasArg(const String &name) const
+{
+  size_t len;
+
+  return current && httpField(current->req->args, current->req->argCount, name.c_str(), &len);
+}
+
+String ESP8266WebServer::header(const String &name) const
+{
+  const char *value;
+  size_t len;
+  String result;
+
+  if (current && (value = httpField(current->req->headers, current->req->headerCount, name.c_str(), &len)))
+    result.concat(value, len);
+  return result;
+}
+
+bool ESP8266WebServer::hasHeader(const String &name) const
+{
+  size_t len;
+
+  return current && httpField(current->req->headers, current->req->headerCount, name.c_str(), &len);
+}
+
+void ESP8266WebServer::sendHeader(const String &name, const String &value, bool first)
+{
+  if (first)
+    headers.insert(headers.begin(), std::make_pair(name, value));
+  else
+    headers.push_back(std::make_pair(name, value));
+}
+
+void ESP8266WebServer::send(int code, const char *contentType, const String &content)
+{
+  send(code, contentType, content.c_str(), content.length());
+}
+
+// Заголовки и тело; при известной длине ответ сразу завершается, как в
+// библиотеке ESP8266, чтобы обработчик мог, например, перезапустить модуль
+void ESP8266WebServer::send(int code, const char *contentType, const char *content, size_t len)
+{
+  size_t length = contentLength == CONTENT_LENGTH_NOT_SET ? len : contentLength;
+
+  if (!current || current->reply.status)
+    return;
+  // У 304 нет ни тела, ни Content-Length: длина была бы длиной 200
+  if (code == 304)
+    current->reply.noBody = true;
+  replyStart(&current->reply, code, contentType,
+             length == CONTENT_LENGTH_UNKNOWN || code == 304 ? REPLY_LENGTH_UNKNOWN : length);
+  for (const auto &h : headers)
+    replyHeader(&current->reply, h.first.c_str(), h.second.c_str());
+  headers.clear();
+  replyWrite(&current->reply, content, len);
+  if (length != CONTENT_LENGTH_UNKNOWN)
+    replyEnd(&current->reply);
+}
+
+// Пустой кусок в ответе неизвестной длины завершает его, как в библиотеке
+void ESP8266WebServer::sendContent(const char *content, size_t len)
+{
+  if (!current || !current->reply.status)
+    return;
+  if (!len && current->reply.chunked)
+    replyEnd(&current->reply);
+  else
+    replyWrite(&current->reply, content, len);
+}
+
+WiFiClient ESP8266WebServer::client()
+{
+  if (!current || current->reply.status || current->reply.ended)
+    return WiFiClient();
+  return WiFiClient(serverDetach(current));
+}
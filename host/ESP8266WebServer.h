@@ -0,0 +1,109 @@
+// ESP8266WebServer для сборки прошивки под Linux поверх httpd/server -
+// того же цикла epoll и соединений conn.c, на которых работает hw3.3_button.
+// Интерфейс тот же, что у библиотеки ядра ESP8266, в объеме, нужном
+// прошивке: маршруты on()/onNotFound(), аргументы и заголовки запроса,
+// send()/send_P() и ответ кусками через setContentLength(
+// CONTENT_LENGTH_UNKNOWN) и sendContent(). Маршрут - запись таблицы
+// HttpRouter, обработчик которой вызывает std::function из адаптера.
+// Порт можно переопределить переменной окружения HOST_HTTP_PORT:
+// порт 80 прошивки требует прав root. client() отдает соединение
+// запроса обработчику (для потоков событий): в отличие от библиотеки,
+// сервер после этого соединение не трогает и на запрос не отвечает.
+#ifndef HOST_ESP8266WEBSERVER_H
+#define HOST_ESP8266WEBSERVER_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+extern "C"
+{
+#include "../httpd/server.h"
+}
+
+typedef enum
+{
+  HTTP_ANY,
+  HTTP_GET,
+  HTTP_HEAD,
+  HTTP_POST,
+  HTTP_PUT,
+  HTTP_PATCH,
+  HTTP_DELETE,
+  HTTP_OPTIONS
+} HTTPMethod;
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+class ESP8266WebServer
+{
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit ESP8266WebServer(int port = 80);
+  ~ESP8266WebServer();
+
+  void begin();
+  void begin(uint16_t port);
+  void close();
+  void stop() { close(); }
+  void handleClient();
+
+  void on(const String &uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void on(const String &uri, HTTPMethod method, THandlerFunction fn);
+  void onNotFound(THandlerFunction fn);
+
+  String uri() const;
+  HTTPMethod method() const;
+  String arg(const String &name) const;
+  String arg(int i) const;
+  String argName(int i) const;
+  int args() const;
+  bool hasArg(const String &name) const;
+  String header(const String &name) const;
+  bool hasHeader(const String &name) const;
+  // Библиотека хранит только перечисленные заголовки запроса, здесь
+  // доступны все
+  void collectHeaders(const char *[], size_t) {}
+
+  void send(int code, const char *contentType = NULL, const String &content = String());
+  void send(int code, const String &contentType, const String &content)
+  {
+    send(code, contentType.c_str(), content);
+  }
+  void send(int code, const char *contentType, const char *content, size_t len);
+  void send_P(int code, PGM_P contentType, PGM_P content) { send(code, contentType, content, strlen_P(content)); }
+  void send_P(int code, PGM_P contentType, PGM_P content, size_t len) { send(code, contentType, content, len); }
+
+  void sendHeader(const String &name, const String &value, bool first = false);
+  void setContentLength(size_t len) { contentLength = len; }
+  void sendContent(const String &content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char *content, size_t len);
+  void sendContent_P(PGM_P content) { sendContent(content, strlen_P(content)); }
+  void sendContent_P(PGM_P content, size_t len) { sendContent(content, len); }
+
+  WiFiClient client();
+
+private:
+  struct Handler
+  {
+    ESP8266WebServer *owner;
+    String uri;
+    THandlerFunction fn;
+  };
+
+  static int dispatch(void *ctx, const HttpRequest *req);
+
+  HttpServer server;
+  uint16_t port;
+  Handler handlers[ROUTER_MAX_ROUTES];
+  Handler notFound;
+  HttpExchange *current = NULL;    // запрос, на который отвечает обработчик
+  size_t contentLength = CONTENT_LENGTH_NOT_SET;
+  std::vector<std::pair<String, String>> headers; // sendHeader до send
+};
+
+#endif
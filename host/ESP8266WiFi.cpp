@@ -0,0 +1,180 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include "ESP8266WiFi.h"
+
+// Неблокирующий connect и ожидание готовности не дольше timeoutMs
+static int connectTimeout(const struct addrinfo *ai, unsigned long timeoutMs)
+{
+  int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, ai->ai_protocol);
+  struct pollfd pfd = {fd, POLLOUT, 0};
+  int err = 0;
+  socklen_t len = sizeof(err);
+
+  if (fd < 0)
+    return -1;
+  if (connect(fd, ai->ai_addr, ai->ai_addrlen) < 0 &&
+      (errno != EINPROGRESS || poll(&pfd, 1, timeoutMs) <= 0 ||
+       getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err))
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Сокет делается блокирующим: запись, как на устройстве, ждет места в
+// буфере не дольше timeoutMs
+static void setBlocking(int fd, unsigned long timeoutMs)
+{
+  struct timeval tv = {(time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000) * 1000};
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+WiFiClient::WiFiClient(int fd) : fd(fd)
+{
+  if (fd >= 0)
+    setBlocking(fd, timeoutMs);
+}
+
+WiFiClient &WiFiClient::operator=(const WiFiClient &other)
+{
+  if (this != &other)
+  {
+    stop();
+    fd = other.fd >= 0 ? fcntl(other.fd, F_DUPFD_CLOEXEC, 0) : -1;
+    outbound = other.outbound;
+    timeoutMs = other.timeoutMs;
+  }
+  return *this;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+  struct addrinfo hints = {}, *res, *ai;
+  char service[8];
+
+  stop();
+  if (WiFi.status() != WL_CONNECTED)
+    return 0;
+  outbound = true;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &res))
+    return 0;
+  for (ai = res; ai && fd < 0; ai = ai->ai_next)
+    fd = connectTimeout(ai, timeoutMs);
+  freeaddrinfo(res);
+  if (fd < 0)
+    return 0;
+  setBlocking(fd, timeoutMs);
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size)
+{
+  size_t sent = 0;
+
+  while (fd >= 0 && sent < size)
+  {
+    ssize_t n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+
+    if (n > 0)
+      sent += n;
+    else if (n < 0 && errno == EINTR)
+      continue;
+    else
+    {
+      stop();
+      break;
+    }
+  }
+  return sent;
+}
+
+int WiFiClient::available()
+{
+  int n = 0;
+
+  if (fd < 0 || ioctl(fd, FIONREAD, &n) < 0)
+    return 0;
+  return n;
+}
+
+int WiFiClient::read()
+{
+  uint8_t b;
+
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size)
+{
+  ssize_t n;
+
+  if (fd < 0)
+    return -1;
+  n = recv(fd, buf, size, MSG_DONTWAIT);
+  return n > 0 ? (int)n : -1;
+}
+
+int WiFiClient::peek()
+{
+  uint8_t b;
+
+  if (fd < 0 || recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT) != 1)
+    return -1;
+  return b;
+}
+
+void WiFiClient::stop()
+{
+  if (fd >= 0)
+    close(fd);
+  fd = -1;
+}
+
+// Соединение живо, пока есть непрочитанные данные или собеседник его не закрыл
+uint8_t WiFiClient::connected()
+{
+  uint8_t b;
+  ssize_t n;
+
+  if (fd < 0)
+    return 0;
+  if (outbound && WiFi.status() != WL_CONNECTED)
+  {
+    stop();
+    return 0;
+  }
+  n = recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)))
+    return 1;
+  return 0;
+}
+
+void WiFiClient::setNoDelay(bool nodelay)
+{
+  int on = nodelay;
+
+  if (fd >= 0)
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+bool WiFiClient::waitAvailable(unsigned long ms)
+{
+  struct pollfd pfd = {fd, POLLIN, 0};
+
+  if (available())
+    return true;
+  return fd >= 0 && poll(&pfd, 1, ms) > 0 && (pfd.revents & POLLIN);
+}
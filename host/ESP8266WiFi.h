@@ -0,0 +1,189 @@
+// Wi-Fi в сборке для Linux: сеть уже есть у хоста, поэтому подключение к
+// точке доступа только изображается, адрес - 127.0.0.1 (или заданный
+// config()). Переменные окружения (время - по millis() прошивки):
+//   HOST_WIFI_CONNECT_MS - ассоциация с точкой доступа (по умолчанию 0);
+//   HOST_WIFI_SCAN_MS    - поиск точки доступа, если begin() не передан ее
+//                          канал и BSSID (по умолчанию 0);
+//   HOST_WIFI_DHCP_MS    - получение адреса, если не задан config()
+//                          (по умолчанию 0);
+//   HOST_WIFI_CHANNEL    - канал точки доступа (по умолчанию 6): с другим
+//                          каналом в begin() подключения нет;
+//   HOST_WIFI_DOWN=от-до - с какой по какую мс точки доступа нет:
+//                          подключение рвется и не удается.
+// Станция подключена, когда после begin() или появления точки доступа
+// прошло время ассоциации, поиска и DHCP.
+#ifndef HOST_ESP8266WIFI_H
+#define HOST_ESP8266WIFI_H
+
+#include <stdlib.h>
+#include "Arduino.h"
+
+typedef enum
+{
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3
+} WiFiMode_t;
+
+typedef enum
+{
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+class ESP8266WiFiClass
+{
+public:
+  bool mode(WiFiMode_t m)
+  {
+    if (!(m & WIFI_STA))
+      begun = false;
+    wifiMode = m;
+    return true;
+  }
+  WiFiMode_t getMode() const { return wifiMode; }
+  void persistent(bool persistent) { (void)persistent; }
+  bool setAutoReconnect(bool autoReconnect)
+  {
+    (void)autoReconnect;
+    return true;
+  }
+
+  // channel и bssid - подключение к известной точке доступа без поиска
+  wl_status_t begin(const char *ssid, const char *passphrase = NULL, int32_t channel = 0,
+                    const uint8_t *bssid = NULL, bool connect = true)
+  {
+    (void)ssid;
+    (void)passphrase;
+    directed = channel && bssid;
+    directedChannel = channel;
+    begun = connect;
+    beginTime = millis();
+    return status();
+  }
+  // Постоянный адрес вместо DHCP; нулевой local возвращает DHCP
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress())
+  {
+    staticIP = local;
+    staticGateway = gateway;
+    staticMask = subnet;
+    staticDns = dns1;
+    return true;
+  }
+  bool disconnect()
+  {
+    begun = false;
+    return true;
+  }
+  // Станция, как на устройстве, переподключается сама, когда точка
+  // доступа снова появится
+  wl_status_t status() const
+  {
+    const char *down = getenv("HOST_WIFI_DOWN");
+    unsigned long now = millis(), since = beginTime, from = 0, to = 0, cost = envMs("HOST_WIFI_CONNECT_MS", 0);
+
+    if (!begun || !(wifiMode & WIFI_STA))
+      return WL_DISCONNECTED;
+    if (directed && directedChannel != (int32_t)envMs("HOST_WIFI_CHANNEL", 6))
+      return WL_NO_SSID_AVAIL;
+    if (down && sscanf(down, "%lu-%lu", &from, &to) == 2)
+    {
+      if (now >= from && now < to)
+        return WL_NO_SSID_AVAIL;
+      if (now >= to && to > since)
+        since = to;
+    }
+    if (!directed)
+      cost += envMs("HOST_WIFI_SCAN_MS", 0);
+    if (!staticIP.isSet())
+      cost += envMs("HOST_WIFI_DHCP_MS", 0);
+    return now - since >= cost ? WL_CONNECTED : WL_DISCONNECTED;
+  }
+  IPAddress localIP() const { return staticIP.isSet() ? staticIP : IPAddress(127, 0, 0, 1); }
+  IPAddress gatewayIP() const { return staticIP.isSet() ? staticGateway : IPAddress(127, 0, 0, 1); }
+  IPAddress subnetMask() const { return staticIP.isSet() ? staticMask : IPAddress(255, 0, 0, 0); }
+  IPAddress dnsIP(uint8_t n = 0) const { return n ? IPAddress() : staticIP.isSet() ? staticDns : IPAddress(127, 0, 0, 1); }
+  uint8_t *BSSID()
+  {
+    static uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+    return bssid;
+  }
+  int32_t channel() const { return envMs("HOST_WIFI_CHANNEL", 6); }
+
+  bool softAP(const char *ssid, const char *passphrase = NULL)
+  {
+    (void)ssid;
+    (void)passphrase;
+    return true;
+  }
+  IPAddress softAPIP() const { return IPAddress(127, 0, 0, 1); }
+
+private:
+  WiFiMode_t wifiMode = WIFI_OFF;
+  bool begun = false;               // станция подключается или подключена
+  bool directed = false;            // begin() с каналом и BSSID
+  int32_t directedChannel = 0;
+  unsigned long beginTime = 0;
+  IPAddress staticIP, staticGateway, staticMask, staticDns;
+
+  static unsigned long envMs(const char *name, unsigned long fallback)
+  {
+    const char *value = getenv(name);
+
+    return value ? strtoul(value, NULL, 10) : fallback;
+  }
+};
+
+inline ESP8266WiFiClass WiFi;
+
+// Клиент TCP поверх сокета хоста с интерфейсом Client из ядра ESP8266.
+// Подключение блокирующее с ограничением по времени (setTimeout, по
+// умолчанию 5 с, как на устройстве); чтение не ждет - его предваряет
+// available(). Время ожидания идет по часам хоста, а не прошивки: сеть
+// настоящая и при виртуальных millis(). Копии, как на устройстве,
+// работают с одним соединением (здесь - через dup()). Исходящие
+// соединения рвутся, когда станция теряет сеть (HOST_WIFI_DOWN).
+class WiFiClient
+{
+public:
+  WiFiClient() {}
+  // Только в сборке для Linux: принятый сервером сокет
+  explicit WiFiClient(int fd);
+  ~WiFiClient() { stop(); }
+  WiFiClient(const WiFiClient &other) { *this = other; }
+  WiFiClient &operator=(const WiFiClient &other);
+
+  int connect(const char *host, uint16_t port);
+  int connect(const IPAddress &ip, uint16_t port) { return connect(ip.toString().c_str(), port); }
+  size_t write(uint8_t b) { return write(&b, 1); }
+  size_t write(const uint8_t *buf, size_t size);
+  size_t write(const char *buf, size_t size) { return write(reinterpret_cast<const uint8_t *>(buf), size); }
+  size_t print(const char *s) { return write(s, strlen(s)); }
+  size_t print(const String &s) { return write(s.c_str(), s.length()); }
+  size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+  int available();
+  int read();
+  int read(uint8_t *buf, size_t size);
+  int peek();
+  void flush() {}
+  void stop();
+  uint8_t connected();
+  operator bool() { return connected(); }
+  void setTimeout(unsigned long ms) { timeoutMs = ms; }
+  void setNoDelay(bool nodelay);
+
+  // Только в сборке для Linux: ждет данных до ms миллисекунд
+  bool waitAvailable(unsigned long ms);
+
+private:
+  int fd = -1;
+  bool outbound = false; // соединение станции: живет, пока станция подключена
+  unsigned long timeoutMs = 5000;
+};
+
+#endif
@@ -0,0 +1,26 @@
+// mDNS в сборке для Linux не объявляется: имя узла задает хост.
+#ifndef HOST_ESP8266MDNS_H
+#define HOST_ESP8266MDNS_H
+
+#include "Arduino.h"
+
+class MDNSResponder
+{
+public:
+  bool begin(const char *hostname)
+  {
+    (void)hostname;
+    return true;
+  }
+  void addService(const char *service, const char *proto, uint16_t port)
+  {
+    (void)service;
+    (void)proto;
+    (void)port;
+  }
+  void update() {}
+};
+
+inline MDNSResponder MDNS;
+
+#endif
@@ -0,0 +1,177 @@
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "ESP8266WiFi.h"
+#include "ESPAsyncTCP.h"
+
+static AsyncClient *clients;
+
+void hostAsyncPoll()
+{
+  AsyncClient::pollAll();
+}
+
+AsyncClient::AsyncClient() : next(clients)
+{
+  clients = this;
+}
+
+AsyncClient::~AsyncClient()
+{
+  AsyncClient **p = &clients;
+
+  if (fd >= 0)
+    ::close(fd);
+  while (*p != this)
+    p = &(*p)->next;
+  *p = next;
+}
+
+// Адрес разрешается сразу (на устройстве - запросом DNS без ожидания),
+// подключение завершается в pollAll()
+bool AsyncClient::connect(const char *host, uint16_t port)
+{
+  struct addrinfo hints = {}, *res;
+  char service[8];
+
+  if (state != CLOSED || WiFi.status() != WL_CONNECTED)
+    return false;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &res))
+    return false;
+  fd = socket(res->ai_family, res->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, res->ai_protocol);
+  if (fd >= 0 && ::connect(fd, res->ai_addr, res->ai_addrlen) < 0 && errno != EINPROGRESS)
+  {
+    ::close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0)
+    return false;
+  txLen = 0;
+  state = CONNECTING;
+  return true;
+}
+
+void AsyncClient::close(bool now)
+{
+  (void)now;
+  if (state != CLOSED)
+    closed();
+}
+
+size_t AsyncClient::add(const char *data, size_t size, uint8_t apiflags)
+{
+  (void)apiflags;
+  if (size > space())
+    size = space();
+  memcpy(tx + txLen, data, size);
+  txLen += size;
+  return size;
+}
+
+bool AsyncClient::send()
+{
+  size_t sent = 0;
+
+  if (state != CONNECTED)
+    return false;
+  while (sent < txLen)
+  {
+    ssize_t n = ::send(fd, tx + sent, txLen - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if (n > 0)
+      sent += n;
+    else if (n < 0 && errno == EINTR)
+      continue;
+    else
+      break;
+  }
+  memmove(tx, tx + sent, txLen - sent);
+  txLen -= sent;
+  return true;
+}
+
+void AsyncClient::setNoDelay(bool nodelay)
+{
+  int on = nodelay;
+
+  if (fd >= 0)
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+void AsyncClient::pollAll()
+{
+  for (AsyncClient *c = clients; c; c = c->next)
+    c->poll();
+}
+
+void AsyncClient::poll()
+{
+  char buf[1460];
+
+  if (state == CLOSED)
+    return;
+  if (WiFi.status() != WL_CONNECTED)
+  {
+    fail(ERR_ABRT);
+    return;
+  }
+  if (state == CONNECTING)
+  {
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    int err = 0;
+    socklen_t len = sizeof(err);
+
+    if (::poll(&pfd, 1, 0) <= 0)
+      return;
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err)
+    {
+      fail(ERR_CONN);
+      return;
+    }
+    state = CONNECTED;
+    if (connectCb)
+      connectCb(connectArg, this);
+  }
+  send();
+  while (state == CONNECTED)
+  {
+    ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+
+    if (n > 0)
+    {
+      if (dataCb)
+        dataCb(dataArg, this, buf, n);
+    }
+    else if (!n)
+      closed();
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      fail(ERR_RST);
+    else
+      break;
+  }
+}
+
+void AsyncClient::fail(int8_t error)
+{
+  if (errorCb)
+    errorCb(errorArg, this, error);
+  closed();
+}
+
+void AsyncClient::closed()
+{
+  ::close(fd);
+  fd = -1;
+  txLen = 0;
+  state = CLOSED;
+  if (disconnectCb)
+    disconnectCb(disconnectArg, this);
+}
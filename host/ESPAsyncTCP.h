@@ -0,0 +1,86 @@
+// AsyncClient из ESPAsyncTCP для сборки прошивки под Linux: соединение
+// TCP без ожидания поверх неблокирующего сокета. connect() только
+// начинает подключение, add() копирует данные в буфер отправки (его
+// размер, как TCP_SND_BUF у lwIP, - 2 * 1460 байт, свободное место -
+// space()), send() отдает буфер сокету, сколько тот примет. События -
+// подключение, данные, ошибка, разрыв - на устройстве приходят из стека
+// lwIP между шагами loop() и в delay()/yield(); здесь их раздает
+// hostAsyncPoll(), которую ядро (Arduino.cpp) вызывает там же. Как на
+// устройстве, после onError приходит и onDisconnect, а close() вызывает
+// onDisconnect сразу. Соединения рвутся, когда станция теряет сеть
+// (HOST_WIFI_DOWN).
+#ifndef HOST_ESPASYNCTCP_H
+#define HOST_ESPASYNCTCP_H
+
+#include <functional>
+#include "Arduino.h"
+
+// Коды ошибок lwIP (err_t), которые передает onError
+#define ERR_CONN -11
+#define ERR_ABRT -13
+#define ERR_RST -14
+
+class AsyncClient;
+
+typedef std::function<void(void *, AsyncClient *)> AcConnectHandler;
+typedef std::function<void(void *, AsyncClient *, void *data, size_t len)> AcDataHandler;
+typedef std::function<void(void *, AsyncClient *, int8_t error)> AcErrorHandler;
+
+class AsyncClient
+{
+public:
+  AsyncClient();
+  ~AsyncClient();
+  AsyncClient(const AsyncClient &) = delete;
+  AsyncClient &operator=(const AsyncClient &) = delete;
+
+  bool connect(const char *host, uint16_t port);
+  bool connect(IPAddress ip, uint16_t port) { return connect(ip.toString().c_str(), port); }
+  void close(bool now = false);
+  bool connecting() const { return state == CONNECTING; }
+  bool connected() const { return state == CONNECTED; }
+  bool freeable() const { return state == CLOSED; }
+
+  size_t space() const { return state == CONNECTED ? sizeof(tx) - txLen : 0; }
+  size_t add(const char *data, size_t size, uint8_t apiflags = 0);
+  bool send();
+  size_t write(const char *data, size_t size)
+  {
+    size_t n = add(data, size);
+
+    send();
+    return n;
+  }
+  void setNoDelay(bool nodelay);
+
+  void onConnect(AcConnectHandler cb, void *arg = NULL) { connectCb = cb, connectArg = arg; }
+  void onDisconnect(AcConnectHandler cb, void *arg = NULL) { disconnectCb = cb, disconnectArg = arg; }
+  void onData(AcDataHandler cb, void *arg = NULL) { dataCb = cb, dataArg = arg; }
+  void onError(AcErrorHandler cb, void *arg = NULL) { errorCb = cb, errorArg = arg; }
+
+  // Только в сборке для Linux: события всех соединений
+  static void pollAll();
+
+private:
+  enum
+  {
+    CLOSED,
+    CONNECTING,
+    CONNECTED
+  } state = CLOSED;
+  int fd = -1;
+  char tx[2 * 1460];
+  size_t txLen = 0;
+  AsyncClient *next; // список для pollAll()
+
+  AcConnectHandler connectCb, disconnectCb;
+  AcDataHandler dataCb;
+  AcErrorHandler errorCb;
+  void *connectArg = NULL, *disconnectArg = NULL, *dataArg = NULL, *errorArg = NULL;
+
+  void poll();
+  void fail(int8_t error);
+  void closed();
+};
+
+#endif
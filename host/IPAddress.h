@@ -0,0 +1,37 @@
+// Адрес IPv4 в сборке для Linux.
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include <stdint.h>
+#include "WString.h"
+
+class IPAddress
+{
+public:
+  IPAddress() : bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+  // Как в ядре ESP8266: адрес в порядке байтов сети
+  IPAddress(uint32_t addr) { memcpy(bytes, &addr, sizeof(bytes)); }
+
+  operator uint32_t() const
+  {
+    uint32_t addr;
+
+    memcpy(&addr, bytes, sizeof(addr));
+    return addr;
+  }
+  uint8_t operator[](int i) const { return bytes[i]; }
+  bool isSet() const { return (uint32_t)*this != 0; }
+
+  String toString() const
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return String(buf);
+  }
+
+private:
+  uint8_t bytes[4];
+};
+
+#endif
@@ -0,0 +1,110 @@
+// Эмуляция LittleFS в сборке для Linux: файлы прошивки лежат в каталоге
+// HOST_FS (по умолчанию littlefs в текущем каталоге) и переживают
+// перезапуск, как во флеше устройства. Интерфейс - подмножество fs::FS и
+// fs::File ядра ESP8266, нужное прошивке: open() с режимами fopen(),
+// чтение, запись, seek(), exists() и remove().
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "Arduino.h"
+
+enum SeekMode
+{
+  SeekSet = SEEK_SET,
+  SeekCur = SEEK_CUR,
+  SeekEnd = SEEK_END
+};
+
+class File
+{
+public:
+  File() {}
+  explicit File(FILE *f) : f(f) {}
+  ~File() { close(); }
+  File(File &&other) : f(other.f) { other.f = NULL; }
+  File &operator=(File &&other)
+  {
+    if (this != &other)
+    {
+      close();
+      f = other.f;
+      other.f = NULL;
+    }
+    return *this;
+  }
+
+  explicit operator bool() const { return f != NULL; }
+  size_t read(uint8_t *buf, size_t size) { return f ? fread(buf, 1, size, f) : 0; }
+  size_t write(const uint8_t *buf, size_t size) { return f ? fwrite(buf, 1, size, f) : 0; }
+  bool seek(uint32_t pos, SeekMode mode = SeekSet) { return f && fseek(f, pos, mode) == 0; }
+  size_t position() const { return f ? ftell(f) : 0; }
+  size_t size() const
+  {
+    struct stat st;
+
+    return f && fflush(f) == 0 && fstat(fileno(f), &st) == 0 ? st.st_size : 0;
+  }
+  void flush()
+  {
+    if (f)
+      fflush(f);
+  }
+  void close()
+  {
+    if (f)
+      fclose(f);
+    f = NULL;
+  }
+
+private:
+  FILE *f = NULL;
+};
+
+class FS
+{
+public:
+  bool begin()
+  {
+    if (mkdir(root(), 0755) < 0 && errno != EEXIST)
+    {
+      printf("=> LittleFS: cannot create %s\n", root());
+      return false;
+    }
+    printf("=> LittleFS: %s\n", root());
+    return true;
+  }
+  void end() {}
+  File open(const char *path, const char *mode) { return File(fopen(hostPath(path).c_str(), mode)); }
+  File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+  bool exists(const char *path)
+  {
+    struct stat st;
+
+    return stat(hostPath(path).c_str(), &st) == 0;
+  }
+  bool remove(const char *path) { return ::remove(hostPath(path).c_str()) == 0; }
+
+private:
+  static const char *root()
+  {
+    const char *p = getenv("HOST_FS");
+
+    return p ? p : "littlefs";
+  }
+  static String hostPath(const char *path)
+  {
+    String full(root());
+
+    if (*path != '/')
+      full += '/';
+    full += path;
+    return full;
+  }
+};
+
+inline FS LittleFS;
+
+#endif
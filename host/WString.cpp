@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include "WString.h"
+
+// Число в системе счисления base, как в ядре Arduino
+static std::string formatNumber(unsigned long value, bool negative, unsigned char base)
+{
+  char buf[8 * sizeof(long) + 2], *p = buf + sizeof(buf);
+
+  if (base < 2 || base > 36)
+    base = 10;
+  *--p = '\0';
+  do
+  {
+    unsigned digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+  if (negative)
+    *--p = '-';
+  return p;
+}
+
+String::String(unsigned char value, unsigned char base) : s(formatNumber(value, false, base)) {}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(unsigned int value, unsigned char base) : s(formatNumber(value, false, base)) {}
+
+String::String(long value, unsigned char base)
+    : s(base == 10 && value < 0 ? formatNumber(-(unsigned long)value, true, base) : formatNumber(value, false, base))
+{
+}
+
+String::String(unsigned long value, unsigned char base) : s(formatNumber(value, false, base)) {}
+
+String::String(float value, unsigned char decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned char decimals)
+{
+  char buf[48];
+
+  snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+  s = buf;
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+  size_t pos = s.find(c, from);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int from) const
+{
+  size_t pos = s.find(str.s, from);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  String result;
+
+  if (from > to)
+    std::swap(from, to);
+  if (to > s.length())
+    to = s.length();
+  if (from < to)
+    result.s = s.substr(from, to - from);
+  return result;
+}
+
+long String::toInt() const
+{
+  return strtol(s.c_str(), NULL, 10);
+}
+
+float String::toFloat() const
+{
+  return strtof(s.c_str(), NULL);
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+String operator+(const String &lhs, const __FlashStringHelper *rhs)
+{
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+  String result(lhs);
+  result += rhs;
+  return result;
+}
@@ -0,0 +1,83 @@
+// Строка Arduino в сборке для Linux поверх std::string: только то, чем
+// пользуется прошивка.
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stdio.h>
+#include <string>
+#include "pgmspace.h"
+
+class String
+{
+public:
+  String() {}
+  String(const char *cstr) : s(cstr ? cstr : "") {}
+  String(const __FlashStringHelper *str) : s(reinterpret_cast<const char *>(str)) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimals = 2);
+  explicit String(double value, unsigned char decimals = 2);
+
+  unsigned int length() const { return s.length(); }
+  const char *c_str() const { return s.c_str(); }
+  bool reserve(unsigned int size)
+  {
+    s.reserve(size);
+    return true;
+  }
+
+  char operator[](unsigned int i) const { return i < s.length() ? s[i] : 0; }
+  char &operator[](unsigned int i) { return s[i]; }
+
+  bool concat(const char *cstr, unsigned int length)
+  {
+    s.append(cstr, length);
+    return true;
+  }
+  String &operator+=(const String &rhs)
+  {
+    s += rhs.s;
+    return *this;
+  }
+  String &operator+=(const char *cstr)
+  {
+    s += cstr;
+    return *this;
+  }
+  String &operator+=(const __FlashStringHelper *str) { return *this += reinterpret_cast<const char *>(str); }
+  String &operator+=(char c)
+  {
+    s += c;
+    return *this;
+  }
+
+  bool equals(const String &rhs) const { return s == rhs.s; }
+  bool equals(const char *cstr) const { return s == cstr; }
+  bool operator==(const String &rhs) const { return s == rhs.s; }
+  bool operator==(const char *cstr) const { return s == cstr; }
+  bool operator!=(const String &rhs) const { return s != rhs.s; }
+  bool operator!=(const char *cstr) const { return s != cstr; }
+
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const String &str, unsigned int from = 0) const;
+  String substring(unsigned int from) const { return substring(from, s.length()); }
+  String substring(unsigned int from, unsigned int to) const;
+  bool startsWith(const String &prefix) const { return !s.compare(0, prefix.s.length(), prefix.s); }
+
+  long toInt() const;
+  float toFloat() const;
+
+private:
+  std::string s;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const String &lhs, const __FlashStringHelper *rhs);
+String operator+(const char *lhs, const String &rhs);
+
+#endif
@@ -0,0 +1,22 @@
+// Память программ ESP8266 в сборке для Linux: обычная память, макросы
+// доступа сводятся к прямому чтению.
+#ifndef HOST_PGMSPACE_H
+#define HOST_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+
+class __FlashStringHelper;
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define F(s) FPSTR(s)
+
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+
+#endif
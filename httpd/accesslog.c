@@ -0,0 +1,210 @@
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "accesslog.h"
+
+#define RING_SIZE 4096          // записей в кольце потока, степень двойки
+#define WRITE_BUF_SIZE 65536    // буфер форматирования фонового потока
+#define FLUSH_INTERVAL_NS 20000000 // пауза фонового потока, если записей нет
+
+typedef struct AccessRing AccessRing;
+
+struct AccessRing
+{
+    _Alignas(64) _Atomic uint32_t head; // следующая запись, двигает поток запросов
+    _Alignas(64) _Atomic uint32_t tail; // следующее чтение, двигает фоновый поток
+    _Atomic uint64_t dropped;
+    unsigned sampleCounter;
+    AccessRing *next;
+    AccessRecord rec[RING_SIZE];
+};
+
+static _Atomic(AccessRing *) rings;     // кольца всех потоков
+static _Atomic unsigned sampling;       // 1 из N, 0 - выключено
+static _Atomic bool running;
+static __thread AccessRing *localRing;
+static pthread_t writer;
+static int logFd = -1;
+
+static uint64_t clockNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t accessLogNow(void)
+{
+    return clockNs(CLOCK_MONOTONIC);
+}
+
+// Кольцо текущего потока создается при первой записи
+static AccessRing *ringForThread(void)
+{
+    AccessRing *ring = localRing;
+
+    if (ring)
+        return ring;
+    ring = calloc(1, sizeof(AccessRing));
+    if (!ring)
+        return NULL;
+    ring->next = atomic_load(&rings);
+    while (!atomic_compare_exchange_weak(&rings, &ring->next, ring))
+        ;
+    return localRing = ring;
+}
+
+void accessLog(uint32_t addr, const char *method, const char *path, size_t pathLen,
+               int status, size_t bytes, uint64_t startNs)
+{
+    unsigned rate = atomic_load_explicit(&sampling, memory_order_relaxed);
+    AccessRing *ring;
+    AccessRecord *rec;
+    uint32_t head, tail;
+    uint64_t elapsedNs;
+
+    if (!rate || !(ring = ringForThread()) || ++ring->sampleCounter < rate)
+        return;
+    ring->sampleCounter = 0;
+
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == RING_SIZE)
+    {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    // Метка строки - настенное время начала: сейчас минус длительность
+    elapsedNs = accessLogNow() - startNs;
+    rec = &ring->rec[head & (RING_SIZE - 1)];
+    rec->timeNs = clockNs(CLOCK_REALTIME) - elapsedNs;
+    rec->addr = addr;
+    rec->bytes = bytes;
+    rec->durationUs = elapsedNs / 1000;
+    rec->status = status;
+    strncpy(rec->method, method, sizeof(rec->method));
+    rec->pathLen = pathLen < sizeof(rec->path) ? pathLen : sizeof(rec->path);
+    memcpy(rec->path, path, rec->pathLen);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static void writeAll(const char *buf, size_t len)
+{
+    while (len)
+    {
+        ssize_t n = write(logFd, buf, len);
+        if (n <= 0)
+            return;
+        buf += n;
+        len -= n;
+    }
+}
+
+// Форматирует записи всех колец; метка времени пересчитывается раз в секунду
+static size_t drainRings(char *out, size_t *outLen)
+{
+    static time_t stampSecond = -1;
+    static char stamp[32];
+    size_t count = 0;
+
+    for (AccessRing *ring = atomic_load(&rings); ring; ring = ring->next)
+    {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        for (; tail != head; tail++, count++)
+        {
+            const AccessRecord *rec = &ring->rec[tail & (RING_SIZE - 1)];
+            time_t second = rec->timeNs / 1000000000ULL;
+            struct in_addr addr = {rec->addr};
+            char ip[INET_ADDRSTRLEN];
+
+            if (*outLen > WRITE_BUF_SIZE - 160)
+            {
+                writeAll(out, *outLen);
+                *outLen = 0;
+            }
+            if (second != stampSecond)
+            {
+                struct tm tm;
+                gmtime_r(&second, &tm);
+                strftime(stamp, sizeof(stamp), "%d/%b/%Y:%H:%M:%S +0000", &tm);
+                stampSecond = second;
+            }
+            inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+            *outLen += sprintf(out + *outLen, "%s - - [%s] \"%.*s %.*s\" %u %u %uus\n",
+                               ip, stamp, (int)strnlen(rec->method, sizeof(rec->method)), rec->method,
+                               rec->pathLen, rec->path, rec->status, rec->bytes, rec->durationUs);
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    return count;
+}
+
+static void *writerThread(void *arg)
+{
+    char *out = malloc(WRITE_BUF_SIZE);
+    size_t outLen = 0;
+    struct timespec pause = {0, FLUSH_INTERVAL_NS};
+
+    (void)arg;
+    if (!out)
+        return NULL;
+    for (;;)
+    {
+        bool stop = !atomic_load(&running);
+        size_t count = drainRings(out, &outLen);
+
+        if (outLen)
+        {
+            writeAll(out, outLen);
+            outLen = 0;
+        }
+        if (stop)
+            break;
+        if (!count)
+            nanosleep(&pause, NULL);
+    }
+    free(out);
+    return NULL;
+}
+
+bool accessLogStart(int fd, unsigned sampleRate)
+{
+    logFd = fd;
+    atomic_store(&sampling, sampleRate);
+    atomic_store(&running, true);
+    if (pthread_create(&writer, NULL, writerThread, NULL))
+    {
+        atomic_store(&running, false);
+        return false;
+    }
+    return true;
+}
+
+void accessLogStop(void)
+{
+    if (!atomic_exchange(&running, false))
+        return;
+    pthread_join(writer, NULL);
+}
+
+void accessLogSetSampling(unsigned sampleRate)
+{
+    atomic_store(&sampling, sampleRate);
+}
+
+uint64_t accessLogDropped(void)
+{
+    uint64_t dropped = 0;
+
+    for (AccessRing *ring = atomic_load(&rings); ring; ring = ring->next)
+        dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    return dropped;
+}
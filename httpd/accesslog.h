@@ -0,0 +1,44 @@
+// Асинхронный журнал доступа.
+// Поток обработки запросов кладет компактную двоичную запись в свое
+// кольцо (один писатель, один читатель, без блокировок), а фоновый поток
+// форматирует записи пачками и сбрасывает их одним write(). При
+// переполнении кольца запись теряется и учитывается в счетчике потерь.
+#ifndef HTTPD_ACCESSLOG_H
+#define HTTPD_ACCESSLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint64_t timeNs;     // начало обработки, CLOCK_REALTIME - только для метки в строке
+    uint32_t addr;       // IPv4 клиента в сетевом порядке
+    uint32_t bytes;      // размер ответа
+    uint32_t durationUs; // время обработки
+    uint16_t status;
+    uint8_t pathLen;
+    char method[7];
+    char path[34];       // начало пути, длиннее обрезается
+} AccessRecord;
+
+// Запускает фоновый поток записи в fd; sampleRate - писать 1 из N запросов, 0 - выключено
+bool accessLogStart(int fd, unsigned sampleRate);
+
+// Сбрасывает оставшиеся записи и останавливает фоновый поток
+void accessLogStop(void);
+
+void accessLogSetSampling(unsigned sampleRate);
+
+// Начало обработки для accessLog, нс CLOCK_MONOTONIC: длительность не
+// искажается, когда NTP или пользователь переводят часы
+uint64_t accessLogNow(void);
+
+// Учитывает запрос; вызывается из любого потока
+void accessLog(uint32_t addr, const char *method, const char *path, size_t pathLen,
+               int status, size_t bytes, uint64_t startNs);
+
+// Сколько записей потеряно из-за переполнения колец
+uint64_t accessLogDropped(void);
+
+#endif
@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+
+struct ArenaBlock
+{
+    ArenaBlock *next;
+    _Alignas(ARENA_ALIGN) char data[];
+};
+
+static ArenaStats stats;
+
+void arenaInit(Arena *a, void *mem, size_t size)
+{
+    a->base = mem;
+    a->size = size;
+    a->used = 0;
+    a->overflow = NULL;
+}
+
+void *arenaAlloc(Arena *a, size_t len)
+{
+    size_t start = (a->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaBlock *block;
+
+    stats.allocs++;
+    stats.bytes += len;
+    if (start + len <= a->size)
+    {
+        a->used = start + len;
+        if (a->used > stats.peak)
+            stats.peak = a->used;
+        return a->base + start;
+    }
+
+    // Запрос не поместился в блок соединения
+    stats.overflows++;
+    if (!(block = malloc(sizeof(ArenaBlock) + len)))
+        return NULL;
+    block->next = a->overflow;
+    a->overflow = block;
+    return block->data;
+}
+
+char *arenaCopy(Arena *a, const char *s, size_t len)
+{
+    char *copy = arenaAlloc(a, len + 1);
+
+    if (copy)
+    {
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+void arenaReset(Arena *a)
+{
+    while (a->overflow)
+    {
+        ArenaBlock *next = a->overflow->next;
+        free(a->overflow);
+        a->overflow = next;
+    }
+    if (a->used)
+        stats.resets++;
+    a->used = 0;
+}
+
+const ArenaStats *arenaStats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,45 @@
+// Линейная арена памяти запроса.
+// Разобранные заголовки, аргументы и собранные фрагменты ответа берутся
+// из блока внутри соединения простым сдвигом указателя; когда ответы
+// отправлены, арена сбрасывается за O(1). Если блока не хватило, память
+// добирается из кучи и освобождается при сбросе - это видно в счетчиках.
+#ifndef HTTPD_ARENA_H
+#define HTTPD_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct
+{
+    char *base;
+    size_t size;
+    size_t used;
+    ArenaBlock *overflow; // блоки из кучи сверх base
+} Arena;
+
+// Счетчики всех арен (только поток ввода-вывода)
+typedef struct
+{
+    uint64_t allocs;    // выделений из арен
+    uint64_t bytes;     // выделено байт
+    uint64_t resets;
+    uint64_t overflows; // выделений, ушедших в кучу
+    size_t peak;        // наибольшая заполненность одной арены
+} ArenaStats;
+
+void arenaInit(Arena *a, void *mem, size_t size);
+
+// Выровненный блок len байт; NULL при нехватке памяти
+void *arenaAlloc(Arena *a, size_t len);
+
+// Копия строки с завершающим нулем
+char *arenaCopy(Arena *a, const char *s, size_t len);
+
+// Освобождает все выделенное разом
+void arenaReset(Arena *a);
+
+const ArenaStats *arenaStats(void);
+
+#endif
@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "buf.h"
+
+#define SMALL_CAP 256   // буферы до этого размера переиспользуются
+#define SMALL_KEEP 256  // сколько свободных буферов держать
+
+static SharedBuf *smallFree; // следующий свободный хранится в data
+static int smallFreeCount;
+static uint64_t heapAllocs;
+
+SharedBuf *sharedBufNew(size_t cap)
+{
+    SharedBuf *buf;
+
+    if (cap <= SMALL_CAP && smallFree)
+    {
+        buf = smallFree;
+        smallFree = *(SharedBuf **)buf->data;
+        smallFreeCount--;
+    }
+    else
+    {
+        if (cap <= SMALL_CAP)
+            cap = SMALL_CAP;
+        if (!(buf = malloc(sizeof(SharedBuf) + cap)))
+            return NULL;
+        buf->cap = cap;
+        heapAllocs++;
+    }
+    buf->refs = 1;
+    buf->len = 0;
+    buf->fd = -1;
+    return buf;
+}
+
+SharedBuf *sharedBufRef(SharedBuf *buf)
+{
+    if (buf)
+        buf->refs++;
+    return buf;
+}
+
+void sharedBufUnref(SharedBuf *buf)
+{
+    if (buf && --buf->refs == 0)
+    {
+        if (buf->fd >= 0)
+            close(buf->fd);
+        if (buf->cap == SMALL_CAP && smallFreeCount < SMALL_KEEP)
+        {
+            *(SharedBuf **)buf->data = smallFree;
+            smallFree = buf;
+            smallFreeCount++;
+            return;
+        }
+        free(buf);
+    }
+}
+
+uint64_t sharedBufHeapAllocs(void)
+{
+    return heapAllocs;
+}
@@ -0,0 +1,32 @@
+// Разделяемый буфер со счетчиком ссылок.
+// Одно сообщение (например событие SSE) сериализуется один раз и
+// ставится в очередь отправки всем подписчикам без копирования.
+// Небольшие буферы после освобождения остаются в списке и переиспользуются,
+// поэтому рассылка событий не обращается к куче.
+#ifndef HTTPD_BUF_H
+#define HTTPD_BUF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    int refs;     // число владельцев (только поток ввода-вывода)
+    size_t len;   // занятая длина данных
+    size_t cap;   // размер области data
+    int fd;       // файл, закрываемый вместе с буфером, или -1
+    char data[];
+} SharedBuf;
+
+// Новый буфер с одной ссылкой, NULL при нехватке памяти
+SharedBuf *sharedBufNew(size_t cap);
+
+SharedBuf *sharedBufRef(SharedBuf *buf);
+
+// Освобождает буфер, когда уходит последняя ссылка
+void sharedBufUnref(SharedBuf *buf);
+
+// Сколько раз буферы выделялись из кучи
+uint64_t sharedBufHeapAllocs(void);
+
+#endif
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include "channel.h"
+
+// Удаление подписчика: последний элемент переносится на место удаляемого
+static void channelDrop(Connection *c)
+{
+    Channel *ch = c->subOwner;
+    Connection *moved = ch->subs[--ch->count];
+
+    ch->subs[c->subIndex] = moved;
+    moved->subIndex = c->subIndex;
+    c->subIndex = -1;
+    c->subOwner = NULL;
+    c->onClose = NULL;
+}
+
+bool channelInit(Channel *ch, int cap)
+{
+    ch->subs = calloc(cap, sizeof(Connection *));
+    ch->count = 0;
+    ch->cap = cap;
+    ch->seq = 0;
+    ch->last = NULL;
+    return ch->subs != NULL;
+}
+
+bool channelSubscribe(Channel *ch, Connection *c)
+{
+    if (ch->count == ch->cap)
+        return false;
+
+    c->subOwner = ch;
+    c->subIndex = ch->count;
+    c->onClose = channelDrop;
+    ch->subs[ch->count++] = c;
+
+    if (ch->last)
+        connQueue(c, ch->last->data, ch->last->len, ch->last);
+    return true;
+}
+
+int channelPublish(Channel *ch, SharedBuf *msg)
+{
+    int i, delivered = 0;
+
+    sharedBufUnref(ch->last);
+    ch->last = msg;
+    ch->seq++;
+
+    // Обход с конца: закрытие подписчика переносит на его место уже обработанный
+    for (i = ch->count - 1; i >= 0; i--)
+    {
+        Connection *c = ch->subs[i];
+
+        if (!connQueue(c, msg->data, msg->len, msg) || connFlush(c) < 0)
+        {
+            connClose(c);
+            continue;
+        }
+        delivered++;
+    }
+    return delivered;
+}
@@ -0,0 +1,25 @@
+// Канал рассылки: набор подписчиков и последнее сообщение.
+// Сообщение сериализуется один раз в SharedBuf и ставится в очередь
+// всем подписчикам; медленный подписчик с полной очередью отключается.
+#ifndef HTTPD_CHANNEL_H
+#define HTTPD_CHANNEL_H
+
+#include "conn.h"
+
+typedef struct
+{
+    Connection **subs;  // подписчики, порядок не важен
+    int count, cap;
+    unsigned long seq;  // номер последнего сообщения
+    SharedBuf *last;    // последнее сообщение для новых подписчиков
+} Channel;
+
+bool channelInit(Channel *ch, int cap);
+
+// Добавляет подписчика и ставит ему в очередь последнее сообщение
+bool channelSubscribe(Channel *ch, Connection *c);
+
+// Рассылает сообщение (забирает ссылку на msg), возвращает число получателей
+int channelPublish(Channel *ch, SharedBuf *msg);
+
+#endif
@@ -0,0 +1,305 @@
+#include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "conn.h"
+
+static int epollFd = -1;
+static Connection *freeList;   // закрытые соединения для повторного использования
+static Connection *closedList; // закрытые в текущей итерации цикла
+static int openCount;
+static Connection *waitHead, *waitTail; // ждущие запрос, от старых к новым
+static int waitCount, waitLimit;
+static unsigned long timedOut, evicted;
+
+void connInit(int epfd, int maxWaiting)
+{
+    epollFd = epfd;
+    waitLimit = maxWaiting;
+}
+
+static void waitUnlink(Connection *c)
+{
+    if (c->wait == CONN_WAIT_NONE)
+        return;
+    if (c->waitPrev)
+        c->waitPrev->waitNext = c->waitNext;
+    else
+        waitHead = c->waitNext;
+    if (c->waitNext)
+        c->waitNext->waitPrev = c->waitPrev;
+    else
+        waitTail = c->waitPrev;
+    c->waitPrev = c->waitNext = NULL;
+    waitCount--;
+}
+
+static void connTimeout(Timer *t)
+{
+    Connection *c = (Connection *)((char *)t - offsetof(Connection, deadline));
+
+    timedOut++;
+    connClose(c);
+}
+
+void connWait(Connection *c, int wait)
+{
+    static const unsigned timeouts[] = {0, CONN_IDLE_TIMEOUT_MS, CONN_HEADER_TIMEOUT_MS, CONN_BODY_TIMEOUT_MS};
+
+    if (c->wait == wait)
+        return;
+    waitUnlink(c);
+    c->wait = wait;
+    if (wait == CONN_WAIT_NONE)
+    {
+        timerCancel(&c->deadline);
+        return;
+    }
+
+    // Места нет - освобождаем его за счет дольше всех ждущего
+    if (waitCount >= waitLimit && waitHead)
+    {
+        evicted++;
+        connClose(waitHead);
+    }
+    c->waitPrev = waitTail;
+    c->waitNext = NULL;
+    if (waitTail)
+        waitTail->waitNext = c;
+    else
+        waitHead = c;
+    waitTail = c;
+    waitCount++;
+    timerAdd(&c->deadline, timerNow() + timeouts[wait]);
+}
+
+static void connEvents(Connection *c)
+{
+    struct epoll_event ev;
+
+    ev.events = (c->readPaused ? 0 : EPOLLIN) | (c->wantWrite ? EPOLLOUT : 0);
+    ev.data.ptr = c;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void connWatch(Connection *c, bool wantWrite)
+{
+    if (c->wantWrite == wantWrite)
+        return;
+    c->wantWrite = wantWrite;
+    connEvents(c);
+}
+
+void connPauseRead(Connection *c, bool pause)
+{
+    if (c->readPaused == pause)
+        return;
+    c->readPaused = pause;
+    connEvents(c);
+}
+
+Connection *connOpen(int fd, const struct sockaddr_in *addr)
+{
+    struct epoll_event ev;
+    Connection *c = freeList;
+
+    if (c)
+        freeList = c->nextFree;
+    else if (!(c = malloc(sizeof(Connection))))
+        return NULL;
+    else
+        c->gen = 0;
+
+    c->fd = fd;
+    c->kind = CONN_HTTP;
+    c->gen++;
+    c->busy = false;
+    c->closeAfterWrite = false;
+    c->wantWrite = false;
+    c->readPaused = false;
+    c->subIndex = -1;
+    c->subOwner = NULL;
+    c->onClose = NULL;
+    c->h2 = NULL;
+    c->stream = 0;
+    c->streamBytes = 0;
+    c->owner = NULL;
+    c->addr = *addr;
+    c->inLen = 0;
+    c->outHead = c->outCount = 0;
+    c->outOff = 0;
+    c->queuedBytes = 0;
+    arenaInit(&c->arena, c->arenaMem, sizeof(c->arenaMem));
+    c->wait = CONN_WAIT_NONE;
+    c->deadline.prev = c->deadline.next = NULL;
+    c->deadline.fire = connTimeout;
+    c->waitPrev = c->waitNext = NULL;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        c->nextFree = freeList;
+        freeList = c;
+        return NULL;
+    }
+    openCount++;
+    connWait(c, CONN_WAIT_HEADERS);
+    return c;
+}
+
+int connDetach(Connection *c)
+{
+    int fd = c->fd;
+
+    if (c->onClose)
+        c->onClose(c);
+    connWait(c, CONN_WAIT_NONE);
+    while (c->outCount)
+    {
+        sharedBufUnref(c->out[c->outHead].owner);
+        c->outHead = (c->outHead + 1) % CONN_OUTQ_SIZE;
+        c->outCount--;
+    }
+    arenaReset(&c->arena);
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    c->fd = -1;
+    openCount--;
+    c->nextFree = closedList;
+    closedList = c;
+    return fd;
+}
+
+void connClose(Connection *c)
+{
+    close(connDetach(c));
+}
+
+void connReap(void)
+{
+    while (closedList)
+    {
+        Connection *c = closedList;
+        closedList = c->nextFree;
+        c->nextFree = freeList;
+        freeList = c;
+    }
+}
+
+bool connQueue(Connection *c, const char *data, size_t len, SharedBuf *owner)
+{
+    OutChunk *chunk;
+
+    if (c->outCount == CONN_OUTQ_SIZE)
+        return false;
+    chunk = &c->out[(c->outHead + c->outCount) % CONN_OUTQ_SIZE];
+    chunk->data = data;
+    chunk->len = len;
+    chunk->fileOff = 0;
+    chunk->owner = sharedBufRef(owner);
+    c->outCount++;
+    c->queuedBytes += len;
+    return true;
+}
+
+bool connQueueFile(Connection *c, SharedBuf *owner, off_t off, size_t len)
+{
+    OutChunk *chunk;
+
+    if (!connQueue(c, NULL, len, owner))
+        return false;
+    chunk = &c->out[(c->outHead + c->outCount - 1) % CONN_OUTQ_SIZE];
+    chunk->fileOff = off;
+    return true;
+}
+
+int connFlush(Connection *c)
+{
+    struct iovec iov[CONN_OUTQ_SIZE];
+
+    while (c->outCount)
+    {
+        OutChunk *head = &c->out[c->outHead];
+        unsigned i;
+        ssize_t sent;
+
+        if (!head->data)
+        {
+            // Файл уходит из кэша страниц напрямую в сокет
+            off_t off = head->fileOff + c->outOff;
+            sent = sendfile(c->fd, head->owner->fd, &off, head->len - c->outOff);
+            if (sent == 0)
+                return -1; // файл укоротился во время отправки
+        }
+        else
+        {
+            // Фрагменты в памяти до первого файла отправляются одним writev
+            for (i = 0; i < c->outCount; i++)
+            {
+                OutChunk *chunk = &c->out[(c->outHead + i) % CONN_OUTQ_SIZE];
+                if (!chunk->data)
+                    break;
+                iov[i].iov_base = (char *)chunk->data;
+                iov[i].iov_len = chunk->len;
+            }
+            iov[0].iov_base = (char *)iov[0].iov_base + c->outOff;
+            iov[0].iov_len -= c->outOff;
+            sent = writev(c->fd, iov, i);
+        }
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                connWatch(c, true);
+                return 0;
+            }
+            return -1;
+        }
+
+        // Снимаем с очереди полностью отправленные фрагменты
+        while (c->outCount && (size_t)sent >= c->out[c->outHead].len - c->outOff)
+        {
+            OutChunk *chunk = &c->out[c->outHead];
+            sent -= chunk->len - c->outOff;
+            c->outOff = 0;
+            sharedBufUnref(chunk->owner);
+            c->outHead = (c->outHead + 1) % CONN_OUTQ_SIZE;
+            c->outCount--;
+        }
+        c->outOff += sent;
+    }
+    connWatch(c, false);
+    arenaReset(&c->arena); // ответы ушли, их память больше не нужна
+    return 1;
+}
+
+int connCount(void)
+{
+    return openCount;
+}
+
+int connWaiting(void)
+{
+    return waitCount;
+}
+
+unsigned long connTimedOut(void)
+{
+    return timedOut;
+}
+
+unsigned long connEvicted(void)
+{
+    return evicted;
+}
@@ -0,0 +1,126 @@
+// Неблокирующие соединения для цикла epoll.
+// Каждое соединение хранит буфер приема запроса и очередь фрагментов
+// на отправку; фрагменты отправляются одним writev. Память разбора
+// запросов и собранных ответов берется из арены соединения и
+// сбрасывается, когда очередь отправки опустела.
+// Пока соединение ждет запрос, у него идет срок чтения заголовков, тела
+// или простоя keep-alive; число таких соединений ограничено, при
+// переполнении закрывается дольше всех ждущее.
+#ifndef HTTPD_CONN_H
+#define HTTPD_CONN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include "arena.h"
+#include "buf.h"
+#include "timer.h"
+
+#define CONN_INBUF_SIZE 1024 // размер буфера приема запроса
+#define CONN_OUTQ_SIZE 8     // максимум фрагментов в очереди отправки
+#define CONN_ARENA_SIZE 1024 // арена запросов внутри соединения
+
+#define CONN_HEADER_TIMEOUT_MS 10000 // заголовки запроса с первого байта или accept
+#define CONN_BODY_TIMEOUT_MS 10000   // тело запроса после заголовков
+#define CONN_IDLE_TIMEOUT_MS 15000   // keep-alive между запросами
+
+enum
+{
+    CONN_HTTP = 1, // обычный запрос/ответ
+    CONN_SSE,      // подписчик потока событий
+    CONN_WS,       // соединение WebSocket
+    CONN_H2        // сессия HTTP/2
+};
+
+// Чего ждет соединение от клиента
+enum
+{
+    CONN_WAIT_NONE,    // запрос обрабатывается или это подписчик
+    CONN_WAIT_IDLE,    // следующего запроса keep-alive
+    CONN_WAIT_HEADERS, // конца заголовков
+    CONN_WAIT_BODY     // тела по Content-Length
+};
+
+typedef struct
+{
+    const char *data; // начало фрагмента или NULL для файла owner->fd
+    size_t len;       // длина фрагмента
+    off_t fileOff;    // смещение в файле
+    SharedBuf *owner; // владелец данных или NULL для статических строк
+} OutChunk;
+
+typedef struct Connection Connection;
+typedef struct H2Session H2Session;
+
+struct Connection
+{
+    int fd;
+    int kind;
+    unsigned gen;                    // номер открытия, меняется при повторном использовании
+    bool busy;                       // ответ готовится в пуле потоков
+    bool closeAfterWrite;            // закрыть после отправки очереди
+    bool wantWrite;                  // в epoll взведен EPOLLOUT
+    bool readPaused;                 // EPOLLIN снят: буфер приема полон
+    int subIndex;                    // позиция в списке подписчиков
+    void *subOwner;                  // канал, на который подписано соединение
+    void (*onClose)(Connection *c);  // вызывается перед закрытием
+    H2Session *h2;                   // состояние HTTP/2 или NULL
+    unsigned stream;                 // HTTP/2: поток, которому готовится ответ
+    size_t streamBytes;              // HTTP/2: тело последнего ответа потока (для журнала)
+    void *owner;                     // сервер, принявший соединение
+    struct sockaddr_in addr;
+    size_t inLen;
+    char in[CONN_INBUF_SIZE + 1];
+    unsigned outHead, outCount;
+    size_t outOff; // сколько уже отправлено из первого фрагмента
+    size_t queuedBytes; // всего байт поставлено в очередь
+    OutChunk out[CONN_OUTQ_SIZE];
+    Arena arena;
+    int wait;                          // CONN_WAIT_*
+    Timer deadline;                    // срок текущего ожидания
+    Connection *waitPrev, *waitNext;   // список ждущих, от старых к новым
+    _Alignas(16) char arenaMem[CONN_ARENA_SIZE];
+    Connection *nextFree;
+};
+
+// Регистрирует дескриптор epoll, в котором живут все соединения;
+// maxWaiting - сколько соединений могут одновременно ждать запрос
+void connInit(int epfd, int maxWaiting);
+
+// Принимает сокет клиента: неблокирующий режим и ожидание EPOLLIN
+Connection *connOpen(int fd, const struct sockaddr_in *addr);
+
+// Закрывает соединение; структура остается доступной (fd == -1) до connReap
+void connClose(Connection *c);
+
+// Как connClose, но сокет не закрывается, а возвращается вызывающему
+int connDetach(Connection *c);
+
+// Возвращает закрытые соединения в пул; вызывать после обработки событий epoll
+void connReap(void);
+
+// Ставит фрагмент в очередь; false, если очередь заполнена
+bool connQueue(Connection *c, const char *data, size_t len, SharedBuf *owner);
+
+// Ставит в очередь len байт файла owner->fd со смещения off (sendfile)
+bool connQueueFile(Connection *c, SharedBuf *owner, off_t off, size_t len);
+
+// Отправляет очередь: 1 - все отправлено, 0 - ждем EPOLLOUT, -1 - ошибка
+int connFlush(Connection *c);
+
+// Снимает или возвращает EPOLLIN, пока буфер приема полон и ждет разбора
+void connPauseRead(Connection *c, bool pause);
+
+// Меняет ожидание соединения; срок отсчитывается заново только при смене
+void connWait(Connection *c, int wait);
+
+// Количество открытых соединений
+int connCount(void);
+
+// Соединения, ждущие запрос; закрытые по сроку; вытесненные при переполнении
+int connWaiting(void);
+unsigned long connTimedOut(void);
+unsigned long connEvicted(void);
+
+#endif
@@ -0,0 +1,531 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "deflate.h"
+
+#define WINDOW_SIZE 32768
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define HASH_BITS 15
+#define MAX_CHAIN 1024       // кандидатов на одно сопоставление
+#define BLOCK_TOKENS 16384   // литералов и совпадений в блоке
+#define STORED_MAX 65535     // байт в блоке без сжатия
+
+#define LIT_CODES 286
+#define DIST_CODES 30
+#define CL_CODES 19
+#define MAX_SYMBOLS LIT_CODES
+
+static const uint16_t lenBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                     31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t lenExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+                                      513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                      6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Порядок длин кодов длин в заголовке динамического блока
+static const uint8_t clOrder[CL_CODES] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// Литерал (dist == 0, байт в len) или совпадение длины len на расстоянии dist
+typedef struct
+{
+    uint16_t len;
+    uint16_t dist;
+} Token;
+
+typedef struct
+{
+    uint8_t *out;
+    size_t pos;
+    uint64_t bits;
+    int count;
+} BitWriter;
+
+typedef struct
+{
+    uint8_t len[MAX_SYMBOLS];
+    uint16_t code[MAX_SYMBOLS]; // биты в обратном порядке, как они пишутся
+} HuffCode;
+
+uint32_t crc32Update(uint32_t crc, const void *data, size_t len)
+{
+    static uint32_t table[256];
+    const uint8_t *p = data;
+
+    if (!table[1])
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+    crc = ~crc;
+    while (len--)
+        crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+size_t gzipBound(size_t len)
+{
+    // Худший случай - хранение: 5 байт на каждые 64 КБ и на каждый блок
+    return len + 5 * (len / STORED_MAX + len / BLOCK_TOKENS + 2) + 18;
+}
+
+// Биты пишутся начиная с младшего
+static void putBits(BitWriter *w, uint32_t value, int n)
+{
+    w->bits |= (uint64_t)value << w->count;
+    w->count += n;
+    while (w->count >= 8)
+    {
+        w->out[w->pos++] = (uint8_t)w->bits;
+        w->bits >>= 8;
+        w->count -= 8;
+    }
+}
+
+static void alignByte(BitWriter *w)
+{
+    if (w->count)
+        putBits(w, 0, 8 - w->count);
+}
+
+static int lenCode(int len)
+{
+    int i = 28;
+    while (lenBase[i] > len)
+        i--;
+    return i;
+}
+
+static int distCode(int dist)
+{
+    int i = 29;
+    while (distBase[i] > dist)
+        i--;
+    return i;
+}
+
+// Длины кодов Хаффмана для n символов; возвращает наибольшую длину.
+// Дерево строится слиянием двух самых редких узлов: символов не больше 286,
+// так что квадратичный поиск здесь проще кучи
+static int huffmanLengths(const uint32_t *freq, int n, uint8_t *len)
+{
+    uint32_t weight[2 * MAX_SYMBOLS];
+    int parent[2 * MAX_SYMBOLS], active[MAX_SYMBOLS], activeCount = 0, nodes = n, maxLen = 0;
+
+    memset(len, 0, n);
+    for (int i = 0; i < n; i++)
+    {
+        weight[i] = freq[i];
+        parent[i] = -1;
+        if (freq[i])
+            active[activeCount++] = i;
+    }
+    if (!activeCount)
+        return 0;
+    // Один символ - код из двух длиной 1, чтобы набор кодов был полным
+    if (activeCount == 1)
+    {
+        len[active[0]] = 1;
+        len[active[0] ? 0 : 1] = 1;
+        return 1;
+    }
+
+    while (activeCount > 1)
+    {
+        int a = 0, b = 1;
+
+        if (weight[active[b]] < weight[active[a]])
+            a = 1, b = 0;
+        for (int i = 2; i < activeCount; i++)
+        {
+            if (weight[active[i]] < weight[active[a]])
+                b = a, a = i;
+            else if (weight[active[i]] < weight[active[b]])
+                b = i;
+        }
+        weight[nodes] = weight[active[a]] + weight[active[b]];
+        parent[nodes] = -1;
+        parent[active[a]] = parent[active[b]] = nodes;
+        // Новый узел встает на место a, место b занимает последний
+        active[a] = nodes++;
+        active[b] = active[--activeCount];
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        int depth = 0;
+
+        if (!freq[i])
+            continue;
+        for (int node = i; parent[node] >= 0; node = parent[node])
+            depth++;
+        len[i] = depth;
+        if (depth > maxLen)
+            maxLen = depth;
+    }
+    return maxLen;
+}
+
+// Длины не длиннее limit: редкие символы становятся чаще, пока дерево
+// не уложится в предел
+static void limitedLengths(const uint32_t *freq, int n, int limit, uint8_t *len)
+{
+    uint32_t scaled[MAX_SYMBOLS];
+
+    memcpy(scaled, freq, n * sizeof(uint32_t));
+    while (huffmanLengths(scaled, n, len) > limit)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            if (scaled[i])
+                scaled[i] = (scaled[i] >> 1) | 1;
+        }
+    }
+}
+
+// Канонические коды по длинам (RFC 1951, 3.2.2)
+static void canonicalCodes(HuffCode *h, int n)
+{
+    int count[16] = {0}, next[16];
+    int code = 0;
+
+    for (int i = 0; i < n; i++)
+        count[h->len[i]]++;
+    count[0] = 0;
+    for (int bits = 1; bits < 16; bits++)
+    {
+        code = (code + count[bits - 1]) << 1;
+        next[bits] = code;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        int reversed = 0, value;
+
+        if (!h->len[i])
+            continue;
+        value = next[h->len[i]]++;
+        for (int k = 0; k < h->len[i]; k++)
+            reversed |= ((value >> k) & 1) << (h->len[i] - 1 - k);
+        h->code[i] = reversed;
+    }
+}
+
+static void fixedCodes(HuffCode *lit, HuffCode *dist)
+{
+    memset(lit, 0, sizeof(*lit));
+    memset(dist, 0, sizeof(*dist));
+    for (int i = 0; i < LIT_CODES; i++)
+        lit->len[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    for (int i = 0; i < DIST_CODES; i++)
+        dist->len[i] = 5;
+    canonicalCodes(lit, LIT_CODES);
+    canonicalCodes(dist, DIST_CODES);
+}
+
+// Биты данных блока в кодах lit и dist
+static size_t dataBits(const uint32_t *litFreq, const uint32_t *distFreq, const HuffCode *lit, const HuffCode *dist)
+{
+    size_t bits = 0;
+
+    for (int i = 0; i < LIT_CODES; i++)
+        bits += (size_t)litFreq[i] * (lit->len[i] + (i > 256 ? lenExtra[i - 257] : 0));
+    for (int i = 0; i < DIST_CODES; i++)
+        bits += (size_t)distFreq[i] * (dist->len[i] + distExtra[i]);
+    return bits;
+}
+
+// Длины кодов литералов и расстояний подряд, сжатые повторами 16-18:
+// символ кода длин в младших 5 битах, дополнительные биты - выше
+static int encodeLengths(const uint8_t *lens, int total, uint16_t *out, uint32_t *clFreq)
+{
+    int count = 0;
+
+    for (int i = 0; i < total;)
+    {
+        int cur = lens[i], run = 1;
+
+        while (i + run < total && lens[i + run] == cur)
+            run++;
+        i += run;
+        if (!cur)
+        {
+            while (run >= 11)
+            {
+                int r = run < 138 ? run : 138;
+                out[count++] = 18 | (r - 11) << 5;
+                clFreq[18]++;
+                run -= r;
+            }
+            if (run >= 3)
+            {
+                out[count++] = 17 | (run - 3) << 5;
+                clFreq[17]++;
+                run = 0;
+            }
+        }
+        else
+        {
+            out[count++] = cur;
+            clFreq[cur]++;
+            run--;
+            while (run >= 3)
+            {
+                int r = run < 6 ? run : 6;
+                out[count++] = 16 | (r - 3) << 5;
+                clFreq[16]++;
+                run -= r;
+            }
+        }
+        while (run-- > 0)
+        {
+            out[count++] = cur;
+            clFreq[cur]++;
+        }
+    }
+    return count;
+}
+
+static void writeTokens(BitWriter *w, const Token *tokens, size_t count, const HuffCode *lit, const HuffCode *dist)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const Token *t = &tokens[i];
+
+        if (!t->dist)
+        {
+            putBits(w, lit->code[t->len], lit->len[t->len]);
+            continue;
+        }
+        int lc = lenCode(t->len), dc = distCode(t->dist);
+        putBits(w, lit->code[257 + lc], lit->len[257 + lc]);
+        putBits(w, t->len - lenBase[lc], lenExtra[lc]);
+        putBits(w, dist->code[dc], dist->len[dc]);
+        putBits(w, t->dist - distBase[dc], distExtra[dc]);
+    }
+    putBits(w, lit->code[256], lit->len[256]);
+}
+
+static void writeStored(BitWriter *w, const uint8_t *data, size_t len, bool last)
+{
+    do
+    {
+        size_t n = len < STORED_MAX ? len : STORED_MAX;
+
+        putBits(w, (last && n == len) ? 1 : 0, 3); // BFINAL, BTYPE = 00
+        alignByte(w);
+        putBits(w, n, 16);
+        putBits(w, ~n & 0xFFFF, 16);
+        memcpy(w->out + w->pos, data, n);
+        w->pos += n;
+        data += n;
+        len -= n;
+    } while (len);
+}
+
+// Блок tokens, покрывающий байты raw; выбирается самый короткий способ
+static void writeBlock(BitWriter *w, const Token *tokens, size_t count, const uint8_t *raw, size_t rawLen, bool last)
+{
+    static HuffCode fixedLit, fixedDist;
+    uint32_t litFreq[LIT_CODES] = {0}, distFreq[DIST_CODES] = {0}, clFreq[CL_CODES] = {0};
+    uint8_t lens[LIT_CODES + DIST_CODES];
+    uint16_t clSyms[LIT_CODES + DIST_CODES];
+    HuffCode lit, dist, cl;
+    int hlit = 257, hdist = 1, hclen = 4, clCount;
+    size_t dynamicBits, fixedBits, storedBits;
+    bool matches = false;
+
+    if (!fixedLit.len[0])
+        fixedCodes(&fixedLit, &fixedDist);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!tokens[i].dist)
+        {
+            litFreq[tokens[i].len]++;
+            continue;
+        }
+        litFreq[257 + lenCode(tokens[i].len)]++;
+        distFreq[distCode(tokens[i].dist)]++;
+        matches = true;
+    }
+    litFreq[256] = 1;
+
+    memset(&lit, 0, sizeof(lit));
+    memset(&dist, 0, sizeof(dist));
+    memset(&cl, 0, sizeof(cl));
+    limitedLengths(litFreq, LIT_CODES, 15, lit.len);
+    limitedLengths(distFreq, DIST_CODES, 15, dist.len);
+    if (!matches)
+        dist.len[0] = dist.len[1] = 1; // совпадений нет: два кода длиной 1 вместо пустого набора
+    canonicalCodes(&lit, LIT_CODES);
+    canonicalCodes(&dist, DIST_CODES);
+
+    for (int i = 0; i < LIT_CODES; i++)
+        if (lit.len[i])
+            hlit = i + 1 > hlit ? i + 1 : hlit;
+    for (int i = 0; i < DIST_CODES; i++)
+        if (dist.len[i])
+            hdist = i + 1;
+    memcpy(lens, lit.len, hlit);
+    memcpy(lens + hlit, dist.len, hdist);
+    clCount = encodeLengths(lens, hlit + hdist, clSyms, clFreq);
+    limitedLengths(clFreq, CL_CODES, 7, cl.len);
+    canonicalCodes(&cl, CL_CODES);
+    for (int i = 0; i < CL_CODES; i++)
+        if (cl.len[clOrder[i]])
+            hclen = i + 1 > hclen ? i + 1 : hclen;
+
+    dynamicBits = 3 + 14 + 3 * hclen + dataBits(litFreq, distFreq, &lit, &dist);
+    for (int i = 0; i < CL_CODES; i++)
+        dynamicBits += (size_t)clFreq[i] * (cl.len[i] + (i == 16 ? 2 : i == 17 ? 3 : i == 18 ? 7 : 0));
+    fixedBits = 3 + dataBits(litFreq, distFreq, &fixedLit, &fixedDist);
+    storedBits = (rawLen / STORED_MAX + 1) * (3 + 7 + 32) + 8 * rawLen;
+
+    if (storedBits <= dynamicBits && storedBits <= fixedBits)
+    {
+        writeStored(w, raw, rawLen, last);
+    }
+    else if (fixedBits <= dynamicBits)
+    {
+        putBits(w, last | 1 << 1, 3);
+        writeTokens(w, tokens, count, &fixedLit, &fixedDist);
+    }
+    else
+    {
+        putBits(w, last | 2 << 1, 3);
+        putBits(w, hlit - 257, 5);
+        putBits(w, hdist - 1, 5);
+        putBits(w, hclen - 4, 4);
+        for (int i = 0; i < hclen; i++)
+            putBits(w, cl.len[clOrder[i]], 3);
+        for (int i = 0; i < clCount; i++)
+        {
+            int sym = clSyms[i] & 31, extra = clSyms[i] >> 5;
+
+            putBits(w, cl.code[sym], cl.len[sym]);
+            if (sym == 16)
+                putBits(w, extra, 2);
+            else if (sym == 17)
+                putBits(w, extra, 3);
+            else if (sym == 18)
+                putBits(w, extra, 7);
+        }
+        writeTokens(w, tokens, count, &lit, &dist);
+    }
+}
+
+static inline uint32_t hash3(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u >> (32 - HASH_BITS);
+}
+
+// Самое длинное совпадение для pos среди прежних позиций с тем же хэшем
+static int longestMatch(const uint8_t *in, size_t len, size_t pos, const int32_t *head, const int32_t *prev, int *dist)
+{
+    int best = 0, limit = len - pos < MAX_MATCH ? (int)(len - pos) : MAX_MATCH, chain = MAX_CHAIN;
+
+    if (limit < MIN_MATCH)
+        return 0;
+    for (int32_t cand = head[hash3(in + pos)]; cand >= 0 && pos - cand <= WINDOW_SIZE && chain--; cand = prev[cand])
+    {
+        const uint8_t *a = in + cand, *b = in + pos;
+        int n = 0;
+
+        if (a[best] != b[best])
+            continue;
+        while (n < limit && a[n] == b[n])
+            n++;
+        if (n > best)
+        {
+            best = n;
+            *dist = pos - cand;
+            if (n == limit)
+                break;
+        }
+    }
+    return best >= MIN_MATCH ? best : 0;
+}
+
+size_t gzipCompress(const void *data, size_t len, void *out)
+{
+    const uint8_t *in = data;
+    int32_t *head = malloc((1 << HASH_BITS) * sizeof(int32_t));
+    int32_t *prev = malloc((len ? len : 1) * sizeof(int32_t));
+    Token *tokens = malloc(BLOCK_TOKENS * sizeof(Token));
+    BitWriter w = {out, 0, 0, 0};
+    size_t pos = 0, blockStart = 0, count = 0;
+    uint32_t crc = crc32Update(0, in, len);
+
+    if (!head || !prev || !tokens)
+    {
+        free(head);
+        free(prev);
+        free(tokens);
+        return 0;
+    }
+    memset(head, 0xFF, (1 << HASH_BITS) * sizeof(int32_t));
+
+    // Заголовок gzip: deflate, без имени и времени, наибольшее сжатие, Unix
+    static const uint8_t gzipHead[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 2, 3};
+    memcpy(w.out, gzipHead, sizeof(gzipHead));
+    w.pos = sizeof(gzipHead);
+
+#define INSERT(p)                                        \
+    do                                                   \
+    {                                                    \
+        if ((p) + MIN_MATCH <= len)                      \
+        {                                                \
+            uint32_t h = hash3(in + (p));                \
+            prev[p] = head[h];                           \
+            head[h] = (p);                               \
+        }                                                \
+    } while (0)
+
+    while (pos < len)
+    {
+        int dist = 0, nextDist = 0;
+        int match = longestMatch(in, len, pos, head, prev, &dist);
+
+        INSERT(pos);
+        // Ленивое сопоставление: если со следующего байта совпадение
+        // длиннее, текущий байт уходит литералом
+        if (match && match < MAX_MATCH && pos + 1 < len &&
+            longestMatch(in, len, pos + 1, head, prev, &nextDist) > match)
+            match = 0;
+        if (match)
+        {
+            tokens[count++] = (Token){(uint16_t)match, (uint16_t)dist};
+            for (int k = 1; k < match; k++)
+                INSERT(pos + k);
+            pos += match;
+        }
+        else
+        {
+            tokens[count++] = (Token){in[pos], 0};
+            pos++;
+        }
+        if (count == BLOCK_TOKENS)
+        {
+            writeBlock(&w, tokens, count, in + blockStart, pos - blockStart, pos == len);
+            blockStart = pos;
+            count = 0;
+        }
+    }
+#undef INSERT
+    if (count || !len)
+        writeBlock(&w, tokens, count, in + blockStart, pos - blockStart, true);
+    alignByte(&w);
+
+    for (int i = 0; i < 4; i++)
+        w.out[w.pos++] = crc >> (8 * i);
+    for (int i = 0; i < 4; i++)
+        w.out[w.pos++] = (uint32_t)len >> (8 * i);
+    free(head);
+    free(prev);
+    free(tokens);
+    return w.pos;
+}
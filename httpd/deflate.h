@@ -0,0 +1,23 @@
+// Сжатие deflate (RFC 1951) в обертке gzip (RFC 1952).
+// Нужно для сжатия ответов при сборке, поэтому выбирается размер, а не
+// скорость: LZ77 по цепочкам хэшей во всем окне 32 КБ с ленивым
+// сопоставлением, затем для каждого блока - меньший из вариантов:
+// динамические коды Хаффмана, постоянные коды или хранение без сжатия.
+// Рабочие массивы берутся из кучи на время вызова.
+#ifndef HTTPD_DEFLATE_H
+#define HTTPD_DEFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Наибольший размер результата gzipCompress для len байт
+size_t gzipBound(size_t len);
+
+// Сжимает len байт in в out (не меньше gzipBound(len) байт); возвращает
+// длину результата или 0 при нехватке памяти
+size_t gzipCompress(const void *in, size_t len, void *out);
+
+// CRC-32 (многочлен 0xEDB88320), crc - значение предыдущей части или 0
+uint32_t crc32Update(uint32_t crc, const void *data, size_t len);
+
+#endif
@@ -0,0 +1,910 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include "h2.h"
+#include "head.h"
+#include "hpack.h"
+
+#define FRAME_HEAD 9
+#define DEFAULT_WINDOW 65535
+#define MAX_WINDOW 0x7fffffffL
+#define MAX_FRAME 16384      // наш SETTINGS_MAX_FRAME_SIZE (по умолчанию)
+#define HEAD_RESERVE 1024    // место под кадр HEADERS ответа или служебные кадры
+#define DATA_MIN 1024        // меньший кусок тела не стоит отдельного кадра в конце буфера
+
+static const char preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+static const char switching[] =
+    "HTTP/1.1 101 Switching Protocols\r\n"
+    "Connection: Upgrade\r\n"
+    "Upgrade: h2c\r\n"
+    "\r\n";
+
+enum
+{
+    FRAME_DATA,
+    FRAME_HEADERS,
+    FRAME_PRIORITY,
+    FRAME_RST_STREAM,
+    FRAME_SETTINGS,
+    FRAME_PUSH_PROMISE,
+    FRAME_PING,
+    FRAME_GOAWAY,
+    FRAME_WINDOW_UPDATE,
+    FRAME_CONTINUATION
+};
+
+enum
+{
+    FLAG_END_STREAM = 0x01,
+    FLAG_ACK = 0x01,
+    FLAG_END_HEADERS = 0x04,
+    FLAG_PADDED = 0x08,
+    FLAG_PRIORITY = 0x20
+};
+
+enum
+{
+    ERR_NO_ERROR,
+    ERR_PROTOCOL,
+    ERR_INTERNAL,
+    ERR_FLOW_CONTROL,
+    ERR_SETTINGS_TIMEOUT,
+    ERR_STREAM_CLOSED,
+    ERR_FRAME_SIZE,
+    ERR_REFUSED_STREAM,
+    ERR_CANCEL,
+    ERR_COMPRESSION,
+    ERR_CONNECT,
+    ERR_ENHANCE_YOUR_CALM
+};
+
+enum
+{
+    SETTINGS_HEADER_TABLE_SIZE = 1,
+    SETTINGS_ENABLE_PUSH,
+    SETTINGS_MAX_CONCURRENT_STREAMS,
+    SETTINGS_INITIAL_WINDOW_SIZE,
+    SETTINGS_MAX_FRAME_SIZE,
+    SETTINGS_MAX_HEADER_LIST_SIZE
+};
+
+typedef struct
+{
+    unsigned id;         // 0 - слот свободен
+    long window;         // окно отправки; после SETTINGS может уйти в минус
+    bool replied;        // ответ задан h2Respond
+    bool headSent;       // кадр HEADERS ушел в буфер
+    const char *head;
+    size_t headLen;
+    const char *data;    // тело в памяти или NULL для файла owner->fd
+    size_t off, len;     // отправлено и всего байт тела
+    SharedBuf *owner;
+} H2Stream;
+
+struct H2Session
+{
+    H2Handler handler;
+    bool preface;            // преамбула клиента еще не принята
+    bool inInput;            // идет h2Input: буфер кадров ставится в очередь в конце
+    unsigned lastStream;     // наибольший номер потока клиента
+    int streamCount;
+    int next;                // с какого слота начинать обход потоков
+    long connWindow;         // окно отправки соединения
+    long initialWindow;      // SETTINGS_INITIAL_WINDOW_SIZE собеседника
+    size_t maxFrame;         // наибольшее тело DATA: предел собеседника и буфера кадров
+    size_t skip;             // остаток большого кадра DATA, пропускаемый без разбора
+    unsigned blockStream;    // поток, чьи CONTINUATION ждем, или 0
+    bool blockEnd;           // у начавшего блок HEADERS был END_STREAM
+    size_t blockLen;
+    SharedBuf *out[2];       // буферы кадров, пишется out[cur]
+    int cur;
+    size_t committed;        // сколько байт out[cur] уже в очереди соединения
+    H2Session *nextFree;
+    H2Stream streams[H2_MAX_STREAMS];
+    HpackTable decoder, encoder;
+    uint8_t block[H2_HEADER_BLOCK];
+};
+
+static H2Session *freeSessions;
+static int sessionCount;
+
+static void put16(uint8_t *p, unsigned v)
+{
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static void frameHead(uint8_t *p, size_t len, int type, int flags, unsigned stream)
+{
+    p[0] = len >> 16;
+    p[1] = len >> 8;
+    p[2] = len;
+    p[3] = type;
+    p[4] = flags;
+    put32(p + 5, stream & 0x7fffffff);
+}
+
+// Отдает очереди соединения еще не поставленную часть текущего буфера
+static bool commit(Connection *c)
+{
+    H2Session *s = c->h2;
+    SharedBuf *buf = s->out[s->cur];
+
+    if (buf->len == s->committed)
+        return true;
+    if (!connQueue(c, buf->data + s->committed, buf->len - s->committed, buf))
+        return false;
+    s->committed = buf->len;
+    return true;
+}
+
+// Место под n байт в буфере кадров; NULL, если оба буфера еще отправляются
+static uint8_t *reserve(Connection *c, size_t n)
+{
+    H2Session *s = c->h2;
+    SharedBuf *buf = s->out[s->cur], *other = s->out[!s->cur];
+
+    if (buf->cap - buf->len >= n)
+        return (uint8_t *)buf->data + buf->len;
+    if (other->refs > 1 || other->cap < n || !commit(c))
+        return NULL;
+    s->cur = !s->cur;
+    s->committed = 0;
+    other->len = 0;
+    return (uint8_t *)other->data;
+}
+
+static size_t space(const H2Session *s)
+{
+    return s->out[s->cur]->cap - s->out[s->cur]->len;
+}
+
+static bool writeFrame(Connection *c, int type, int flags, unsigned stream, const void *payload, size_t len)
+{
+    uint8_t *p = reserve(c, FRAME_HEAD + len);
+
+    if (!p)
+        return false;
+    frameHead(p, len, type, flags, stream);
+    memcpy(p + FRAME_HEAD, payload, len);
+    c->h2->out[c->h2->cur]->len += FRAME_HEAD + len;
+    return true;
+}
+
+static void windowUpdate(Connection *c, unsigned stream, uint32_t increment)
+{
+    uint8_t payload[4];
+
+    put32(payload, increment);
+    writeFrame(c, FRAME_WINDOW_UPDATE, 0, stream, payload, sizeof(payload));
+}
+
+static void resetStream(Connection *c, unsigned stream, uint32_t code)
+{
+    uint8_t payload[4];
+
+    put32(payload, code);
+    writeFrame(c, FRAME_RST_STREAM, 0, stream, payload, sizeof(payload));
+}
+
+// Ошибка соединения: GOAWAY и закрытие после отправки очереди
+static void goAway(Connection *c, uint32_t code)
+{
+    uint8_t payload[8];
+
+    put32(payload, c->h2->lastStream);
+    put32(payload + 4, code);
+    writeFrame(c, FRAME_GOAWAY, 0, 0, payload, sizeof(payload));
+    c->closeAfterWrite = true;
+}
+
+static H2Stream *findStream(H2Session *s, unsigned id)
+{
+    for (int i = 0; i < H2_MAX_STREAMS; i++)
+        if (s->streams[i].id == id)
+            return &s->streams[i];
+    return NULL;
+}
+
+static void freeStream(H2Session *s, H2Stream *st)
+{
+    sharedBufUnref(st->owner);
+    memset(st, 0, sizeof(*st));
+    s->streamCount--;
+}
+
+static H2Stream *openStream(H2Session *s, unsigned id)
+{
+    H2Stream *st = findStream(s, 0);
+
+    st->id = id;
+    st->window = s->initialWindow;
+    s->streamCount++;
+    return st;
+}
+
+// Оценка сверху кадра HEADERS: поля не длиннее строк HTTP/1.1 плюс
+// :status, date и content-length
+static size_t headBound(const H2Stream *st)
+{
+    return FRAME_HEAD + 4 * st->headLen + 160;
+}
+
+// Кадр HEADERS ответа: заголовки HTTP/1.1 в HPACK, имена в нижнем регистре
+static bool sendHeaders(Connection *c, H2Stream *st)
+{
+    static const char *const skipped[] = {"connection", "keep-alive", "proxy-connection", "transfer-encoding", "upgrade"};
+    H2Session *s = c->h2;
+    size_t bound = headBound(st);
+    const char *line, *headEnd = st->head + st->headLen;
+    char date[HEAD_DATE_LEN], name[64];
+    bool hasLength = false;
+    uint8_t *p, *q, *end;
+    int status;
+
+    if (st->headLen < 12 || bound > H2_OUT_SIZE)
+        return false;
+    if (!(p = reserve(c, bound)))
+        return false;
+    q = p + FRAME_HEAD;
+    end = p + bound;
+    status = atoi(st->head + 9);
+    q += hpackEncode(&s->encoder, q, end - q, ":status", 7, st->head + 9, 3, true);
+
+    for (line = memchr(st->head, '\n', st->headLen); line && ++line < headEnd;)
+    {
+        const char *eol = memchr(line, '\n', headEnd - line);
+        const char *colon, *value, *valueEnd;
+        size_t nameLen;
+        bool skip = false, length;
+
+        if (!eol)
+            eol = headEnd;
+        colon = memchr(line, ':', eol - line);
+        nameLen = colon ? (size_t)(colon - line) : 0;
+        if (nameLen && nameLen < sizeof(name))
+        {
+            for (size_t i = 0; i < nameLen; i++)
+                name[i] = line[i] >= 'A' && line[i] <= 'Z' ? line[i] + 32 : line[i];
+            for (size_t i = 0; i < sizeof(skipped) / sizeof(skipped[0]); i++)
+                skip = skip || (strlen(skipped[i]) == nameLen && !memcmp(skipped[i], name, nameLen));
+            value = colon + 1;
+            valueEnd = eol;
+            while (value < valueEnd && *value == ' ')
+                value++;
+            while (valueEnd > value && (valueEnd[-1] == '\r' || valueEnd[-1] == ' '))
+                valueEnd--;
+            length = nameLen == 14 && !memcmp(name, "content-length", 14);
+            hasLength = hasLength || length;
+            // Меняющиеся от ответа к ответу значения не засоряют таблицу
+            if (!skip)
+                q += hpackEncode(&s->encoder, q, end - q, name, nameLen, value, valueEnd - value,
+                                 !length && !(nameLen == 4 && !memcmp(name, "etag", 4)) &&
+                                 !(nameLen == 13 && !memcmp(name, "last-modified", 13)));
+        }
+        line = eol;
+    }
+
+    headDate(date);
+    q += hpackEncode(&s->encoder, q, end - q, "date", 4, date + 6, HEAD_DATE_LEN - 8, true);
+    if (!hasLength && status != 304 && status != 204)
+    {
+        char length[24];
+        q += hpackEncode(&s->encoder, q, end - q, "content-length", 14, length,
+                         sprintf(length, "%zu", st->len), false);
+    }
+    frameHead(p, q - p - FRAME_HEAD, FRAME_HEADERS, FLAG_END_HEADERS | (st->len ? 0 : FLAG_END_STREAM), st->id);
+    s->out[s->cur]->len += q - p;
+    st->headSent = true;
+    return true;
+}
+
+// Заголовки и тела ответов: по кадру на поток за проход, пока есть окна и место
+static void pump(Connection *c)
+{
+    H2Session *s = c->h2;
+    bool progress = true;
+
+    while (progress && !c->closeAfterWrite)
+    {
+        progress = false;
+        for (int k = 0; k < H2_MAX_STREAMS; k++)
+        {
+            H2Stream *st = &s->streams[(s->next + k) % H2_MAX_STREAMS];
+            size_t n;
+            uint8_t *p;
+
+            if (!st->id || !st->replied)
+                continue;
+            if (!st->headSent)
+            {
+                if (!sendHeaders(c, st))
+                {
+                    if (st->headLen >= 12 && headBound(st) <= H2_OUT_SIZE)
+                        return; // ждем места в буфере
+                    resetStream(c, st->id, ERR_INTERNAL);
+                    freeStream(s, st);
+                    continue;
+                }
+                progress = true;
+            }
+            if (st->off == st->len)
+            {
+                freeStream(s, st);
+                continue;
+            }
+            if (st->window <= 0 || s->connWindow <= 0)
+                continue;
+
+            n = st->len - st->off;
+            if ((long)n > st->window)
+                n = st->window;
+            if ((long)n > s->connWindow)
+                n = s->connWindow;
+            if (n > s->maxFrame)
+                n = s->maxFrame;
+            // Хвост буфера заполняем, если в него влезает заметный кусок
+            if (space(s) < FRAME_HEAD + n && space(s) >= FRAME_HEAD + DATA_MIN)
+                n = space(s) - FRAME_HEAD;
+            if (!(p = reserve(c, FRAME_HEAD + n)))
+                return;
+            if (st->data)
+            {
+                memcpy(p + FRAME_HEAD, st->data + st->off, n);
+            }
+            else if (pread(st->owner->fd, p + FRAME_HEAD, n, st->off) != (ssize_t)n)
+            {
+                resetStream(c, st->id, ERR_INTERNAL); // файл укоротился
+                freeStream(s, st);
+                continue;
+            }
+            st->off += n;
+            st->window -= n;
+            s->connWindow -= n;
+            frameHead(p, n, FRAME_DATA, st->off == st->len ? FLAG_END_STREAM : 0, st->id);
+            s->out[s->cur]->len += FRAME_HEAD + n;
+            progress = true;
+            if (st->off == st->len)
+                freeStream(s, st);
+        }
+        s->next = (s->next + 1) % H2_MAX_STREAMS;
+    }
+}
+
+static void finish(Connection *c)
+{
+    pump(c);
+    commit(c);
+}
+
+static void applySettings(Connection *c, const uint8_t *p, size_t len)
+{
+    H2Session *s = c->h2;
+
+    for (; len >= 6; p += 6, len -= 6)
+    {
+        unsigned id = p[0] << 8 | p[1];
+        uint32_t value = get32(p + 2);
+
+        if (id == SETTINGS_HEADER_TABLE_SIZE)
+        {
+            hpackResize(&s->encoder, value);
+        }
+        else if (id == SETTINGS_INITIAL_WINDOW_SIZE)
+        {
+            if (value > MAX_WINDOW)
+            {
+                goAway(c, ERR_FLOW_CONTROL);
+                return;
+            }
+            // Окна открытых потоков сдвигаются на разницу
+            for (int i = 0; i < H2_MAX_STREAMS; i++)
+                if (s->streams[i].id)
+                    s->streams[i].window += (long)value - s->initialWindow;
+            s->initialWindow = value;
+        }
+        else if (id == SETTINGS_MAX_FRAME_SIZE)
+        {
+            if (value < MAX_FRAME || value > 0xffffff)
+            {
+                goAway(c, ERR_PROTOCOL);
+                return;
+            }
+            s->maxFrame = value < H2_OUT_SIZE - FRAME_HEAD ? value : H2_OUT_SIZE - FRAME_HEAD;
+        }
+    }
+}
+
+static H2Session *newSession(void)
+{
+    H2Session *s = freeSessions;
+
+    if (sessionCount == H2_MAX_SESSIONS)
+        return NULL;
+    if (s)
+    {
+        freeSessions = s->nextFree;
+    }
+    else
+    {
+        if (!(s = malloc(sizeof(H2Session))))
+            return NULL;
+        s->out[0] = sharedBufNew(H2_OUT_SIZE);
+        s->out[1] = sharedBufNew(H2_OUT_SIZE);
+        if (!s->out[0] || !s->out[1])
+        {
+            sharedBufUnref(s->out[0]);
+            sharedBufUnref(s->out[1]);
+            free(s);
+            return NULL;
+        }
+    }
+    s->preface = true;
+    s->inInput = false;
+    s->lastStream = 0;
+    s->streamCount = 0;
+    s->next = 0;
+    s->connWindow = DEFAULT_WINDOW;
+    s->initialWindow = DEFAULT_WINDOW;
+    s->maxFrame = H2_OUT_SIZE - FRAME_HEAD; // кадр с заголовком целиком в буфере
+    s->skip = 0;
+    s->blockStream = 0;
+    s->blockLen = 0;
+    s->out[0]->len = s->out[1]->len = 0;
+    s->cur = 0;
+    s->committed = 0;
+    memset(s->streams, 0, sizeof(s->streams));
+    hpackInit(&s->decoder, HPACK_TABLE_SIZE);
+    hpackInit(&s->encoder, HPACK_TABLE_SIZE);
+    sessionCount++;
+    return s;
+}
+
+static void h2Close(Connection *c)
+{
+    H2Session *s = c->h2;
+
+    for (int i = 0; i < H2_MAX_STREAMS; i++)
+        sharedBufUnref(s->streams[i].owner);
+    c->h2 = NULL;
+    c->onClose = NULL;
+    s->nextFree = freeSessions;
+    freeSessions = s;
+    sessionCount--;
+}
+
+// Подключает сессию к соединению и ставит наши SETTINGS
+static void attach(Connection *c, H2Session *s, H2Handler handler)
+{
+    uint8_t settings[12];
+
+    s->handler = handler;
+    c->h2 = s;
+    c->kind = CONN_H2;
+    c->onClose = h2Close;
+    c->closeAfterWrite = false;
+    put16(settings, SETTINGS_MAX_CONCURRENT_STREAMS);
+    put32(settings + 2, H2_MAX_STREAMS);
+    put16(settings + 6, SETTINGS_MAX_HEADER_LIST_SIZE);
+    put32(settings + 8, H2_HEADER_BLOCK);
+    writeFrame(c, FRAME_SETTINGS, 0, 0, settings, sizeof(settings));
+}
+
+int h2Preface(const char *in, size_t len)
+{
+    size_t n = len < sizeof(preface) - 1 ? len : sizeof(preface) - 1;
+
+    if (memcmp(in, preface, n))
+        return -1;
+    return n == sizeof(preface) - 1;
+}
+
+bool h2Start(Connection *c, H2Handler handler)
+{
+    H2Session *s = newSession();
+
+    if (!s)
+        return false;
+    attach(c, s, handler);
+    return true;
+}
+
+// Раскодирует HTTP2-Settings (base64url без выравнивания)
+static size_t base64UrlDecode(const char *in, size_t len, uint8_t *out, size_t cap)
+{
+    uint32_t acc = 0;
+    size_t n = 0;
+    int bits = 0;
+
+    for (size_t i = 0; i < len && in[i] != '='; i++)
+    {
+        char ch = in[i];
+        int v = ch >= 'A' && ch <= 'Z' ? ch - 'A' : ch >= 'a' && ch <= 'z' ? ch - 'a' + 26 :
+                ch >= '0' && ch <= '9' ? ch - '0' + 52 : ch == '-' || ch == '+' ? 62 :
+                ch == '_' || ch == '/' ? 63 : -1;
+
+        if (v < 0)
+            return (size_t)-1;
+        acc = acc << 6 | v;
+        bits += 6;
+        if (bits >= 8)
+        {
+            if (n == cap)
+                return (size_t)-1;
+            bits -= 8;
+            out[n++] = acc >> bits;
+        }
+    }
+    return n;
+}
+
+bool h2Upgrade(Connection *c, const HttpRequest *req, H2Handler handler)
+{
+    const char *upgrade, *connection, *settings;
+    size_t upgradeLen, connectionLen, settingsLen, n;
+    uint8_t payload[96];
+    H2Session *s;
+
+    upgrade = httpField(req->headers, req->headerCount, "Upgrade", &upgradeLen);
+    connection = httpField(req->headers, req->headerCount, "Connection", &connectionLen);
+    settings = httpField(req->headers, req->headerCount, "HTTP2-Settings", &settingsLen);
+    if (!upgrade || !httpHasToken(upgrade, upgradeLen, "h2c") || !connection ||
+        !httpHasToken(connection, connectionLen, "HTTP2-Settings") || !settings || req->bodyLen)
+        return false;
+    n = base64UrlDecode(settings, settingsLen, payload, sizeof(payload));
+    if (n == (size_t)-1 || n % 6 || !(s = newSession()))
+        return false;
+
+    connQueue(c, switching, sizeof(switching) - 1, NULL);
+    attach(c, s, handler);
+    applySettings(c, payload, n); // 101 служит подтверждением, SETTINGS ACK не нужен
+    s->lastStream = 1;
+    openStream(s, 1);
+    s->handler(c, 1, req);
+    finish(c);
+    return true;
+}
+
+// Полный блок заголовков запроса: раскодировать и отдать обработчику
+static bool headerBlock(Connection *c, unsigned id, const uint8_t *block, size_t len)
+{
+    H2Session *s = c->h2;
+    HttpField fields[H2_MAX_FIELDS];
+    const char *path = NULL;
+    size_t pathLen = 0;
+    HttpRequest req;
+    int count, regular = 0;
+
+    // Таблицу декодера обновляют все блоки, даже отвергнутые ниже
+    if (!hpackDecode(&s->decoder, &c->arena, block, len, fields, H2_MAX_FIELDS, &count))
+    {
+        goAway(c, ERR_COMPRESSION);
+        return false;
+    }
+    if (id <= s->lastStream)
+        return true; // трейлеры или поток, который уже закрыт
+    s->lastStream = id;
+    if (s->streamCount == H2_MAX_STREAMS)
+    {
+        resetStream(c, id, ERR_REFUSED_STREAM);
+        return true;
+    }
+
+    memset(&req, 0, sizeof(req));
+    for (int i = 0; i < count; i++)
+    {
+        const HttpField *f = &fields[i];
+
+        if (f->nameLen == 7 && !memcmp(f->name, ":method", 7))
+            req.method = (char *)f->value;
+        else if (f->nameLen == 5 && !memcmp(f->name, ":path", 5))
+            path = f->value, pathLen = f->valueLen;
+        else if (f->name[0] != ':')
+            regular++;
+    }
+    if (!req.method || !path || !httpParseTarget(&c->arena, path, pathLen, &req) ||
+        (regular && !(req.headers = arenaAlloc(&c->arena, regular * sizeof(HttpField)))))
+    {
+        resetStream(c, id, ERR_PROTOCOL);
+        return true;
+    }
+    for (int i = 0; i < count; i++)
+        if (fields[i].name[0] != ':')
+            req.headers[req.headerCount++] = fields[i];
+    req.keepAlive = true;
+
+    openStream(s, id);
+    s->handler(c, id, &req);
+    return true;
+}
+
+// Принятые байты тела сразу возвращаются в окна: тела запросов не нужны
+static void dataReceived(Connection *c, unsigned id, size_t len)
+{
+    if (!len)
+        return;
+    windowUpdate(c, 0, len);
+    if (findStream(c->h2, id))
+        windowUpdate(c, id, len);
+}
+
+// Один кадр целиком; false - дальше не разбирать
+static bool frame(Connection *c, int type, int flags, unsigned id, const uint8_t *p, size_t len)
+{
+    H2Session *s = c->h2;
+    H2Stream *st;
+
+    if (s->blockStream && type != FRAME_CONTINUATION)
+    {
+        goAway(c, ERR_PROTOCOL);
+        return false;
+    }
+
+    switch (type)
+    {
+    case FRAME_DATA:
+        if (!id)
+        {
+            goAway(c, ERR_PROTOCOL);
+            return false;
+        }
+        dataReceived(c, id, len);
+        break;
+
+    case FRAME_HEADERS:
+        if (!id || !(id & 1))
+        {
+            goAway(c, ERR_PROTOCOL);
+            return false;
+        }
+        if (flags & FLAG_PADDED)
+        {
+            if (!len || p[0] >= len)
+            {
+                goAway(c, ERR_PROTOCOL);
+                return false;
+            }
+            len -= 1 + p[0];
+            p++;
+        }
+        if (flags & FLAG_PRIORITY)
+        {
+            if (len < 5)
+            {
+                goAway(c, ERR_FRAME_SIZE);
+                return false;
+            }
+            p += 5;
+            len -= 5;
+        }
+        if (flags & FLAG_END_HEADERS)
+            return headerBlock(c, id, p, len);
+        if (len > sizeof(s->block))
+        {
+            goAway(c, ERR_ENHANCE_YOUR_CALM);
+            return false;
+        }
+        memcpy(s->block, p, len);
+        s->blockLen = len;
+        s->blockStream = id;
+        s->blockEnd = flags & FLAG_END_STREAM;
+        break;
+
+    case FRAME_CONTINUATION:
+        if (id != s->blockStream)
+        {
+            goAway(c, ERR_PROTOCOL);
+            return false;
+        }
+        if (s->blockLen + len > sizeof(s->block))
+        {
+            goAway(c, ERR_ENHANCE_YOUR_CALM);
+            return false;
+        }
+        memcpy(s->block + s->blockLen, p, len);
+        s->blockLen += len;
+        if (flags & FLAG_END_HEADERS)
+        {
+            s->blockStream = 0;
+            return headerBlock(c, id, s->block, s->blockLen);
+        }
+        break;
+
+    case FRAME_RST_STREAM:
+        if ((st = findStream(s, id)))
+            freeStream(s, st);
+        break;
+
+    case FRAME_SETTINGS:
+        if (id || len % 6 || ((flags & FLAG_ACK) && len))
+        {
+            goAway(c, id ? ERR_PROTOCOL : ERR_FRAME_SIZE);
+            return false;
+        }
+        if (!(flags & FLAG_ACK))
+        {
+            applySettings(c, p, len);
+            writeFrame(c, FRAME_SETTINGS, FLAG_ACK, 0, NULL, 0);
+        }
+        break;
+
+    case FRAME_PING:
+        if (id || len != 8)
+        {
+            goAway(c, id ? ERR_PROTOCOL : ERR_FRAME_SIZE);
+            return false;
+        }
+        if (!(flags & FLAG_ACK))
+            writeFrame(c, FRAME_PING, FLAG_ACK, 0, p, 8);
+        break;
+
+    case FRAME_WINDOW_UPDATE:
+    {
+        long increment = len == 4 ? (long)(get32(p) & 0x7fffffff) : -1;
+
+        if (increment <= 0)
+        {
+            goAway(c, increment < 0 ? ERR_FRAME_SIZE : ERR_PROTOCOL);
+            return false;
+        }
+        if (!id && s->connWindow + increment > MAX_WINDOW)
+        {
+            goAway(c, ERR_FLOW_CONTROL);
+            return false;
+        }
+        if (!id)
+            s->connWindow += increment;
+        else if ((st = findStream(s, id)))
+            st->window += increment;
+        break;
+    }
+
+    case FRAME_PUSH_PROMISE:
+        goAway(c, ERR_PROTOCOL);
+        return false;
+
+    default:
+        break; // PRIORITY, GOAWAY и неизвестные типы не требуют ответа
+    }
+    return !c->closeAfterWrite;
+}
+
+size_t h2Input(Connection *c)
+{
+    H2Session *s = c->h2;
+    const uint8_t *in = (const uint8_t *)c->in;
+    size_t pos = 0;
+
+    s->inInput = true;
+    if (s->preface)
+    {
+        int result = h2Preface(c->in, c->inLen);
+
+        if (result < 0)
+        {
+            goAway(c, ERR_PROTOCOL);
+            pos = c->inLen;
+        }
+        else if (result > 0)
+        {
+            pos = sizeof(preface) - 1;
+            s->preface = false;
+        }
+    }
+
+    while (!s->preface && !c->closeAfterWrite && pos < c->inLen)
+    {
+        size_t len;
+        int type;
+
+        if (s->skip)
+        {
+            size_t n = c->inLen - pos < s->skip ? c->inLen - pos : s->skip;
+            pos += n;
+            s->skip -= n;
+            continue;
+        }
+        if (c->inLen - pos < FRAME_HEAD)
+            break;
+        len = (size_t)in[pos] << 16 | in[pos + 1] << 8 | in[pos + 2];
+        type = in[pos + 3];
+        if (len > MAX_FRAME)
+        {
+            goAway(c, ERR_FRAME_SIZE);
+            break;
+        }
+        // Новые ответы и служебные кадры - только при месте в буфере кадров
+        if (!reserve(c, HEAD_RESERVE))
+            break;
+        if (FRAME_HEAD + len > CONN_INBUF_SIZE)
+        {
+            // В буфер приема не поместится; телам запросов он и не нужен
+            if (type != FRAME_DATA || s->blockStream)
+            {
+                goAway(c, ERR_ENHANCE_YOUR_CALM);
+                break;
+            }
+            dataReceived(c, get32(in + pos + 5) & 0x7fffffff, len);
+            s->skip = len;
+            pos += FRAME_HEAD;
+            continue;
+        }
+        if (c->inLen - pos < FRAME_HEAD + len)
+            break;
+        if (!frame(c, type, in[pos + 4], get32(in + pos + 5) & 0x7fffffff, in + pos + FRAME_HEAD, len))
+        {
+            pos = c->inLen;
+            break;
+        }
+        pos += FRAME_HEAD + len;
+    }
+    if (c->closeAfterWrite)
+        pos = c->inLen;
+    s->inInput = false;
+    finish(c);
+    return pos;
+}
+
+bool h2Respond(Connection *c, unsigned stream, const char *head, size_t headLen,
+               const char *data, size_t len, SharedBuf *owner)
+{
+    H2Session *s = c->h2;
+    H2Stream *st = s ? findStream(s, stream) : NULL;
+
+    if (!st || st->replied)
+        return false;
+    if (data && !owner && len)
+    {
+        // Тело из арены или стека переживет только копией
+        if (!(owner = sharedBufNew(len)))
+        {
+            resetStream(c, stream, ERR_INTERNAL);
+            freeStream(s, st);
+            return false;
+        }
+        memcpy(owner->data, data, len);
+        owner->len = len;
+        data = owner->data;
+    }
+    else
+    {
+        sharedBufRef(owner);
+    }
+    st->replied = true;
+    st->head = head;
+    st->headLen = headLen;
+    st->data = data;
+    st->len = len;
+    st->owner = owner;
+    if (!s->inInput)
+        finish(c);
+    return true;
+}
+
+void h2Pump(Connection *c)
+{
+    if (c->h2 && !c->h2->inInput)
+        finish(c);
+}
+
+bool h2Idle(const Connection *c)
+{
+    return !c->h2 || !c->h2->streamCount;
+}
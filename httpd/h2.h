@@ -0,0 +1,54 @@
+// HTTP/2 без TLS (h2c, RFC 9113).
+// Соединение переходит на HTTP/2, если начинается с преамбулы клиента
+// (знание заранее) или после запроса HTTP/1.1 с Upgrade: h2c. Кадры
+// разбираются из буфера приема соединения, заголовки запросов
+// раскодируются HPACK в арену, и каждый запрос отдается обработчику со
+// своим номером потока. Ответы копятся в буфере кадров сессии и уходят
+// через очередь соединения одним фрагментом; тела режутся на кадры DATA
+// по кругу между потоками в пределах окон управления потоком.
+#ifndef HTTPD_H2_H
+#define HTTPD_H2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "conn.h"
+#include "http.h"
+
+#define H2_MAX_STREAMS 32    // одновременных потоков (SETTINGS_MAX_CONCURRENT_STREAMS)
+#define H2_MAX_SESSIONS 256  // соединений HTTP/2 одновременно
+#define H2_HEADER_BLOCK 2048 // блок заголовков запроса вместе с CONTINUATION
+#define H2_MAX_FIELDS 48     // полей в заголовках запроса
+#define H2_OUT_SIZE 16384    // буфер кадров; у сессии их два, пока один отправляется
+
+// Запрос потока stream; ответ - h2Respond сразу или позже (из пула)
+typedef void (*H2Handler)(Connection *c, unsigned stream, const HttpRequest *req);
+
+// Начинается ли in с преамбулы клиента: 1 - да, 0 - данных пока мало, -1 - нет
+int h2Preface(const char *in, size_t len);
+
+// Переводит соединение на HTTP/2; преамбула остается в буфере приема.
+// false - нет свободной сессии
+bool h2Start(Connection *c, H2Handler handler);
+
+// Если req - запрос HTTP/1.1 с Upgrade: h2c, отвечает 101, переводит
+// соединение на HTTP/2 и отдает req обработчику как поток 1
+bool h2Upgrade(Connection *c, const HttpRequest *req, H2Handler handler);
+
+// Разбирает кадры из буфера приема, возвращает число разобранных байт.
+// Останавливается, если в очереди соединения нет места под ответы
+size_t h2Input(Connection *c);
+
+// Ответ в поток. head - строка статуса и заголовки в виде HTTP/1.1 без
+// пустой строки; Date и Content-Length (если его нет) добавляются. Тело -
+// len байт data или файла owner->fd при data == NULL; head и data живут
+// вместе с owner, а без owner тело копируется. false - поток уже закрыт
+bool h2Respond(Connection *c, unsigned stream, const char *head, size_t headLen,
+               const char *data, size_t len, SharedBuf *owner);
+
+// Досылает тела потоков; вызывать, когда очередь соединения отправлена
+void h2Pump(Connection *c);
+
+// Нет ни одного потока, ждущего ответа
+bool h2Idle(const Connection *c);
+
+#endif
@@ -0,0 +1,137 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include "head.h"
+
+#define TAIL_MAX (HEAD_DATE_LEN + 64) // Date, Content-Length и Connection: close
+
+typedef struct
+{
+    const char *data;
+    size_t len;
+} HeadBlock;
+
+#define BLOCK(text) {text, sizeof(text) - 1}
+
+static const HeadBlock blocks[HEAD_COUNT] = {
+    [HEAD_OK_HTML] = BLOCK("HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/html; charset=utf-8\r\n"
+                           "Vary: Accept-Encoding\r\n"),
+    [HEAD_OK_HTML_GZIP] = BLOCK("HTTP/1.1 200 OK\r\n"
+                                "Content-Type: text/html; charset=utf-8\r\n"
+                                "Content-Encoding: gzip\r\n"
+                                "Vary: Accept-Encoding\r\n"),
+    [HEAD_OK_JSON] = BLOCK("HTTP/1.1 200 OK\r\n"
+                           "Content-Type: application/json\r\n"),
+    [HEAD_OK_METRICS] = BLOCK("HTTP/1.1 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"),
+    [HEAD_BAD_REQUEST] = BLOCK("HTTP/1.1 400 Bad Request\r\n"),
+    [HEAD_FORBIDDEN] = BLOCK("HTTP/1.1 403 Forbidden\r\n"),
+    [HEAD_NOT_FOUND] = BLOCK("HTTP/1.1 404 Not Found\r\n"),
+    [HEAD_TOO_LARGE] = BLOCK("HTTP/1.1 413 Payload Too Large\r\n"),
+    [HEAD_TOO_MANY] = BLOCK("HTTP/1.1 429 Too Many Requests\r\n"
+                            "Retry-After: 1\r\n"),
+    [HEAD_INTERNAL_ERROR] = BLOCK("HTTP/1.1 500 Internal Server Error\r\n"),
+    [HEAD_UNAVAILABLE] = BLOCK("HTTP/1.1 503 Service Unavailable\r\n"),
+};
+
+const char *headBlock(int head, size_t *len)
+{
+    *len = blocks[head].len;
+    return blocks[head].data;
+}
+
+// Строка Date под seqlock: нечетный dateSeq - строка переписывается
+static char dateLine[HEAD_DATE_LEN];
+static _Atomic unsigned dateSeq;
+static _Atomic long long dateSecond = -1;
+static pthread_mutex_t dateLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void dateRefresh(time_t now)
+{
+    char line[HEAD_DATE_LEN + 1];
+    struct tm tm;
+
+    pthread_mutex_lock(&dateLock);
+    if (atomic_load(&dateSecond) != now) // другой поток мог успеть раньше
+    {
+        gmtime_r(&now, &tm);
+        strftime(line, sizeof(line), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+        atomic_fetch_add_explicit(&dateSeq, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        memcpy(dateLine, line, HEAD_DATE_LEN);
+        atomic_fetch_add_explicit(&dateSeq, 1, memory_order_release);
+        atomic_store_explicit(&dateSecond, now, memory_order_release);
+    }
+    pthread_mutex_unlock(&dateLock);
+}
+
+void headDate(char *out)
+{
+    struct timespec ts;
+    unsigned seq;
+
+    // Грубые часы читаются из vDSO без системного вызова
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    if (atomic_load_explicit(&dateSecond, memory_order_acquire) != ts.tv_sec)
+        dateRefresh(ts.tv_sec);
+    do
+    {
+        seq = atomic_load_explicit(&dateSeq, memory_order_acquire);
+        memcpy(out, dateLine, HEAD_DATE_LEN);
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&dateSeq, memory_order_relaxed));
+}
+
+// Десятичная запись value, возвращает конец
+static char *putDecimal(char *p, size_t value)
+{
+    char digits[20];
+    int n = 0;
+
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (n)
+        *p++ = digits[--n];
+    return p;
+}
+
+static bool queueTail(Connection *c, bool withLength, size_t bodyLen)
+{
+    char *tail = arenaAlloc(&c->arena, TAIL_MAX);
+    char *p;
+
+    if (!tail)
+        return false;
+    headDate(tail);
+    p = tail + HEAD_DATE_LEN;
+    if (withLength)
+    {
+        memcpy(p, "Content-Length: ", 16);
+        p = putDecimal(p + 16, bodyLen);
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+    if (c->closeAfterWrite)
+    {
+        memcpy(p, "Connection: close\r\n", 19);
+        p += 19;
+    }
+    *p++ = '\r';
+    *p++ = '\n';
+    return connQueue(c, tail, p - tail, NULL);
+}
+
+bool headQueue(Connection *c, int head, size_t bodyLen)
+{
+    return connQueue(c, blocks[head].data, blocks[head].len, NULL) && queueTail(c, true, bodyLen);
+}
+
+bool headQueueEnd(Connection *c)
+{
+    return queueTail(c, false, 0);
+}
@@ -0,0 +1,46 @@
+// Заголовки ответов.
+// Строка статуса с постоянными заголовками заранее собрана для частых
+// ответов и ставится в очередь как есть; для каждого ответа в арене
+// собирается только хвост: Date, Content-Length и Connection. Строка Date
+// форматируется раз в секунду и общая для всех потоков. Блок, хвост и
+// тело уходят одним writev.
+#ifndef HTTPD_HEAD_H
+#define HTTPD_HEAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "conn.h"
+
+#define HEAD_DATE_LEN 37 // "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+
+// Готовые блоки: строка статуса и Content-Type
+enum
+{
+    HEAD_OK_HTML,
+    HEAD_OK_HTML_GZIP,
+    HEAD_OK_JSON,
+    HEAD_OK_METRICS,
+    HEAD_BAD_REQUEST,
+    HEAD_FORBIDDEN,
+    HEAD_NOT_FOUND,
+    HEAD_TOO_LARGE,
+    HEAD_TOO_MANY,
+    HEAD_INTERNAL_ERROR,
+    HEAD_UNAVAILABLE,
+    HEAD_COUNT
+};
+
+// Готовый блок head и его длина (без хвоста), например для перевода в HTTP/2
+const char *headBlock(int head, size_t *len);
+
+// Копирует в out строку "Date: ...\r\n" текущей секунды (HEAD_DATE_LEN байт)
+void headDate(char *out);
+
+// Заголовки ответа: блок head, Date, Content-Length: bodyLen и
+// Connection: close, если c->closeAfterWrite; false при нехватке памяти
+bool headQueue(Connection *c, int head, size_t bodyLen);
+
+// Завершает заголовки, поставленные вызывающим: Date и Connection
+bool headQueueEnd(Connection *c);
+
+#endif
@@ -0,0 +1,450 @@
+#include <pthread.h>
+#include <string.h>
+#include "hpack.h"
+
+typedef struct
+{
+    const char *name;
+    const char *value;
+    uint8_t nameLen;
+    uint8_t valueLen;
+} StaticEntry;
+
+#define E(name, value) {name, value, sizeof(name) - 1, sizeof(value) - 1}
+
+// RFC 7541, приложение A; индексы с 1
+static const StaticEntry staticTable[] = {
+    E(":authority", ""), E(":method", "GET"), E(":method", "POST"), E(":path", "/"),
+    E(":path", "/index.html"), E(":scheme", "http"), E(":scheme", "https"), E(":status", "200"),
+    E(":status", "204"), E(":status", "206"), E(":status", "304"), E(":status", "400"),
+    E(":status", "404"), E(":status", "500"), E("accept-charset", ""), E("accept-encoding", "gzip, deflate"),
+    E("accept-language", ""), E("accept-ranges", ""), E("accept", ""), E("access-control-allow-origin", ""),
+    E("age", ""), E("allow", ""), E("authorization", ""), E("cache-control", ""),
+    E("content-disposition", ""), E("content-encoding", ""), E("content-language", ""), E("content-length", ""),
+    E("content-location", ""), E("content-range", ""), E("content-type", ""), E("cookie", ""),
+    E("date", ""), E("etag", ""), E("expect", ""), E("expires", ""),
+    E("from", ""), E("host", ""), E("if-match", ""), E("if-modified-since", ""),
+    E("if-none-match", ""), E("if-range", ""), E("if-unmodified-since", ""), E("last-modified", ""),
+    E("link", ""), E("location", ""), E("max-forwards", ""), E("proxy-authenticate", ""),
+    E("proxy-authorization", ""), E("range", ""), E("referer", ""), E("refresh", ""),
+    E("retry-after", ""), E("server", ""), E("set-cookie", ""), E("strict-transport-security", ""),
+    E("transfer-encoding", ""), E("user-agent", ""), E("vary", ""), E("via", ""),
+    E("www-authenticate", ""),
+};
+
+#define STATIC_COUNT (int)(sizeof(staticTable) / sizeof(staticTable[0]))
+
+// Код Хаффмана символов 0..255 (RFC 7541, приложение B); EOS - 30 единиц
+static const struct
+{
+    uint32_t code;
+    uint8_t bits;
+} huffman[256] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28}, {0xfffffe4, 28}, {0xfffffe5, 28},
+    {0xfffffe6, 28}, {0xfffffe7, 28}, {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28}, {0xfffffed, 28}, {0xfffffee, 28},
+    {0xfffffef, 28}, {0xffffff0, 28}, {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28}, {0xffffff8, 28}, {0xffffff9, 28},
+    {0xffffffa, 28}, {0xffffffb, 28}, {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11}, {0x3fa, 10}, {0x3fb, 10},
+    {0xf9, 8}, {0x7fb, 11}, {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6}, {0x1a, 6}, {0x1b, 6},
+    {0x1c, 6}, {0x1d, 6}, {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10}, {0x1ffa, 13}, {0x21, 6},
+    {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7}, {0x68, 7},
+    {0x69, 7}, {0x6a, 7}, {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7}, {0xfc, 8}, {0x73, 7},
+    {0xfd, 8}, {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5},
+    {0x25, 6}, {0x26, 6}, {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5}, {0x2b, 6}, {0x76, 7},
+    {0x2c, 6}, {0x8, 5}, {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14},
+    {0x1ffd, 13}, {0xffffffc, 28}, {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23}, {0x3fffd6, 22}, {0x7fffda, 23},
+    {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24}, {0x7fffe1, 23},
+    {0x7fffe2, 23}, {0x7fffe3, 23}, {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24}, {0x3fffda, 22}, {0x1fffdd, 21},
+    {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21}, {0x3fffdf, 22},
+    {0x7fffeb, 23}, {0x7fffec, 23}, {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23}, {0xfffea, 20}, {0x3fffe2, 22},
+    {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22}, {0x7ffff2, 23},
+    {0x3fffe8, 22}, {0x1ffffec, 25}, {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25}, {0x7fff2, 19}, {0x1fffe3, 21},
+    {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28}, {0x7ffffe3, 27},
+    {0x7ffffe4, 27}, {0x7ffffe5, 27}, {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23}, {0x3fffea, 22}, {0x3fffeb, 22},
+    {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27}, {0x7ffffe8, 27},
+    {0x7ffffe9, 27}, {0x7ffffea, 27}, {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+};
+
+// Дерево декодера: узел - пара потомков; >= 0 - узел, < 0 - символ -(s + 1)
+static int16_t tree[256][2];
+static int treeNodes = 1;
+static pthread_once_t treeOnce = PTHREAD_ONCE_INIT;
+
+static void buildTree(void)
+{
+    for (int sym = 0; sym < 256; sym++)
+    {
+        int node = 0;
+
+        for (int bit = huffman[sym].bits - 1; bit > 0; bit--)
+        {
+            int b = huffman[sym].code >> bit & 1;
+            if (!tree[node][b])
+                tree[node][b] = treeNodes++;
+            node = tree[node][b];
+        }
+        tree[node][huffman[sym].code & 1] = -(sym + 1);
+    }
+}
+
+// Декодирует строку Хаффмана; out вмещает len * 8 / 5 байт
+static bool huffmanDecode(const uint8_t *in, size_t len, char *out, size_t *outLen)
+{
+    int node = 0, depth = 0; // depth - бит с последнего символа
+    bool ones = true;        // все эти биты - единицы
+    size_t n = 0;
+
+    pthread_once(&treeOnce, buildTree);
+    for (size_t i = 0; i < len; i++)
+    {
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            int b = in[i] >> bit & 1;
+            int next = tree[node][b];
+
+            if (next < 0)
+            {
+                out[n++] = (char)(-next - 1);
+                node = depth = 0;
+                ones = true;
+            }
+            else if (!next)
+            {
+                return false; // EOS внутри строки
+            }
+            else
+            {
+                node = next;
+                depth++;
+                ones = ones && b;
+            }
+        }
+    }
+    // Хвост - не больше 7 бит начала EOS, то есть единицы
+    if (depth > 7 || !ones)
+        return false;
+    *outLen = n;
+    return true;
+}
+
+static size_t huffmanLen(const char *s, size_t len)
+{
+    size_t bits = 0;
+
+    for (size_t i = 0; i < len; i++)
+        bits += huffman[(uint8_t)s[i]].bits;
+    return (bits + 7) / 8;
+}
+
+static size_t huffmanEncode(const char *s, size_t len, uint8_t *out)
+{
+    uint64_t acc = 0;
+    int bits = 0;
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        acc = acc << huffman[(uint8_t)s[i]].bits | huffman[(uint8_t)s[i]].code;
+        bits += huffman[(uint8_t)s[i]].bits;
+        while (bits >= 8)
+        {
+            bits -= 8;
+            out[n++] = (uint8_t)(acc >> bits);
+        }
+    }
+    if (bits)
+        out[n++] = (uint8_t)(acc << (8 - bits) | 0xff >> bits);
+    return n;
+}
+
+void hpackInit(HpackTable *t, size_t limit)
+{
+    t->limit = t->maxSize = limit < HPACK_TABLE_SIZE ? limit : HPACK_TABLE_SIZE;
+    t->size = 0;
+    t->resized = false;
+    t->first = t->count = 0;
+    t->used = 0;
+}
+
+// Вытесняет старые записи, пока новой записи размера room нет места
+static void evict(HpackTable *t, size_t room)
+{
+    while (t->count && t->size + room > t->maxSize)
+    {
+        HpackEntry *e = &t->entries[t->first];
+
+        t->size -= e->nameLen + e->valueLen + 32;
+        t->first = (t->first + 1) % HPACK_MAX_ENTRIES;
+        t->count--;
+    }
+    if (!t->count)
+        t->used = 0;
+}
+
+// Строки не должны указывать внутрь t->data
+static void insert(HpackTable *t, const char *name, size_t nameLen, const char *value, size_t valueLen)
+{
+    size_t len = nameLen + valueLen;
+    HpackEntry *e;
+
+    if (len + 32 > t->maxSize)
+    {
+        evict(t, t->maxSize + 1); // запись больше таблицы очищает ее
+        return;
+    }
+    evict(t, len + 32);
+    if (t->used + len > sizeof(t->data))
+    {
+        // Живые записи лежат подряд от самой старой; сдвигаем их в начало
+        size_t start = t->entries[t->first].off;
+
+        memmove(t->data, t->data + start, t->used - start);
+        for (int i = 0; i < t->count; i++)
+            t->entries[(t->first + i) % HPACK_MAX_ENTRIES].off -= start;
+        t->used -= start;
+    }
+    e = &t->entries[(t->first + t->count) % HPACK_MAX_ENTRIES];
+    e->off = t->used;
+    e->nameLen = nameLen;
+    e->valueLen = valueLen;
+    memcpy(t->data + t->used, name, nameLen);
+    memcpy(t->data + t->used + nameLen, value, valueLen);
+    t->used += len;
+    t->size += len + 32;
+    t->count++;
+}
+
+void hpackResize(HpackTable *t, size_t limit)
+{
+    t->limit = limit < HPACK_TABLE_SIZE ? limit : HPACK_TABLE_SIZE;
+    if (t->maxSize != t->limit)
+    {
+        t->maxSize = t->limit;
+        evict(t, 0);
+        t->resized = true;
+    }
+}
+
+// Запись по индексу: сначала статическая таблица, затем динамическая от новых к старым
+static bool lookup(const HpackTable *t, size_t index, const char **name, size_t *nameLen,
+                   const char **value, size_t *valueLen)
+{
+    const HpackEntry *e;
+
+    if (index == 0)
+        return false;
+    if (index <= STATIC_COUNT)
+    {
+        *name = staticTable[index - 1].name;
+        *nameLen = staticTable[index - 1].nameLen;
+        *value = staticTable[index - 1].value;
+        *valueLen = staticTable[index - 1].valueLen;
+        return true;
+    }
+    index -= STATIC_COUNT;
+    if (index > (size_t)t->count)
+        return false;
+    e = &t->entries[(t->first + t->count - index) % HPACK_MAX_ENTRIES];
+    *name = t->data + e->off;
+    *nameLen = e->nameLen;
+    *value = t->data + e->off + e->nameLen;
+    *valueLen = e->valueLen;
+    return true;
+}
+
+// Целое с префиксом prefix бит (RFC 7541, 5.1)
+static bool getInt(const uint8_t **p, const uint8_t *end, int prefix, size_t *value)
+{
+    size_t mask = (1u << prefix) - 1;
+    size_t v;
+
+    if (*p >= end)
+        return false;
+    v = *(*p)++ & mask;
+    for (int shift = 0; v >= mask; shift += 7)
+    {
+        uint8_t b;
+
+        if (*p >= end || shift > 21)
+            return false;
+        b = *(*p)++;
+        v += (size_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            break;
+    }
+    *value = v;
+    return true;
+}
+
+static size_t putInt(uint8_t *out, int prefix, uint8_t flags, size_t value)
+{
+    size_t mask = (1u << prefix) - 1;
+    size_t n = 1;
+
+    if (value < mask)
+    {
+        out[0] = flags | value;
+        return 1;
+    }
+    out[0] = flags | mask;
+    for (value -= mask; value >= 0x80; value >>= 7)
+        out[n++] = 0x80 | (value & 0x7f);
+    out[n++] = value;
+    return n;
+}
+
+// Строка в арену с нулем в конце
+static char *getString(Arena *a, const uint8_t **p, const uint8_t *end, size_t *len)
+{
+    bool huff = *p < end && (**p & 0x80);
+    size_t n;
+    char *s;
+
+    if (!getInt(p, end, 7, &n) || n > (size_t)(end - *p))
+        return NULL;
+    if (!huff)
+        s = arenaCopy(a, (const char *)*p, n);
+    else if ((s = arenaAlloc(a, n * 8 / 5 + 1)) && huffmanDecode(*p, n, s, len))
+        s[*len] = '\0';
+    else
+        s = NULL;
+    if (s && !huff)
+        *len = n;
+    *p += n;
+    return s;
+}
+
+static size_t putString(uint8_t *out, const char *s, size_t len)
+{
+    size_t huffLen = huffmanLen(s, len);
+    size_t n;
+
+    if (huffLen < len)
+    {
+        n = putInt(out, 7, 0x80, huffLen);
+        return n + huffmanEncode(s, len, out + n);
+    }
+    n = putInt(out, 7, 0, len);
+    memcpy(out + n, s, len);
+    return n + len;
+}
+
+bool hpackDecode(HpackTable *t, Arena *a, const uint8_t *in, size_t len,
+                 HttpField *fields, int max, int *count)
+{
+    const uint8_t *p = in, *end = in + len;
+
+    *count = 0;
+    while (p < end)
+    {
+        uint8_t b = *p;
+        size_t index;
+        HttpField *f;
+
+        if ((b & 0xe0) == 0x20)
+        {
+            // Новый размер таблицы от кодера собеседника
+            if (!getInt(&p, end, 5, &index) || index > t->limit)
+                return false;
+            t->maxSize = index;
+            evict(t, 0);
+            continue;
+        }
+        if (*count == max)
+            return false;
+        f = &fields[(*count)++];
+
+        if (b & 0x80)
+        {
+            const char *name, *value;
+
+            if (!getInt(&p, end, 7, &index) || !lookup(t, index, &name, &f->nameLen, &value, &f->valueLen))
+                return false;
+            // Запись динамической таблицы может уйти при следующей вставке
+            if (!(f->name = arenaCopy(a, name, f->nameLen)) || !(f->value = arenaCopy(a, value, f->valueLen)))
+                return false;
+            continue;
+        }
+
+        // Литерал: 01 - с добавлением в таблицу, 0000 - без, 0001 - никогда не индексировать
+        bool add = (b & 0xc0) == 0x40;
+
+        if (!getInt(&p, end, add ? 6 : 4, &index))
+            return false;
+        if (index)
+        {
+            const char *name, *value;
+            size_t valueLen;
+
+            if (!lookup(t, index, &name, &f->nameLen, &value, &valueLen) ||
+                !(f->name = arenaCopy(a, name, f->nameLen)))
+                return false;
+        }
+        else if (!(f->name = getString(a, &p, end, &f->nameLen)))
+        {
+            return false;
+        }
+        if (!(f->value = getString(a, &p, end, &f->valueLen)))
+            return false;
+        if (add)
+            insert(t, f->name, f->nameLen, f->value, f->valueLen);
+    }
+    return true;
+}
+
+size_t hpackEncode(HpackTable *t, uint8_t *out, size_t cap, const char *name, size_t nameLen,
+                   const char *value, size_t valueLen, bool index)
+{
+    size_t n = 0, nameIndex = 0;
+
+    if (cap < hpackEncodedMax(nameLen, valueLen))
+        return 0;
+    if (t->resized)
+    {
+        n += putInt(out, 5, 0x20, t->maxSize);
+        t->resized = false;
+    }
+
+    // Полное совпадение - одно число; иначе запоминаем первое совпадение имени
+    for (size_t i = 1; i <= (size_t)STATIC_COUNT + t->count; i++)
+    {
+        const char *entryName, *entryValue;
+        size_t entryNameLen, entryValueLen;
+
+        if (!lookup(t, i, &entryName, &entryNameLen, &entryValue, &entryValueLen) ||
+            entryNameLen != nameLen || memcmp(entryName, name, nameLen))
+            continue;
+        if (entryValueLen == valueLen && !memcmp(entryValue, value, valueLen))
+            return n + putInt(out + n, 7, 0x80, i);
+        if (!nameIndex)
+            nameIndex = i;
+    }
+
+    n += putInt(out + n, index ? 6 : 4, index ? 0x40 : 0x00, nameIndex);
+    if (!nameIndex)
+        n += putString(out + n, name, nameLen);
+    n += putString(out + n, value, valueLen);
+    if (index)
+        insert(t, name, nameLen, value, valueLen);
+    return n;
+}
@@ -0,0 +1,58 @@
+// Сжатие заголовков HTTP/2 (HPACK, RFC 7541).
+// Статическая таблица из 61 записи, динамическая таблица с вытеснением
+// старых записей по размеру, целые с префиксом и строки в коде Хаффмана.
+// HpackTable - состояние одного направления: у декодера соединения своя
+// таблица, у кодера своя.
+#ifndef HTTPD_HPACK_H
+#define HTTPD_HPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "http.h"
+
+#define HPACK_TABLE_SIZE 4096                     // наибольший размер динамической таблицы
+#define HPACK_MAX_ENTRIES (HPACK_TABLE_SIZE / 32) // запись занимает не меньше 32 байт
+
+typedef struct
+{
+    uint16_t off;      // имя и значение подряд в data
+    uint16_t nameLen;
+    uint16_t valueLen;
+} HpackEntry;
+
+typedef struct
+{
+    size_t limit;      // предел из SETTINGS_HEADER_TABLE_SIZE
+    size_t maxSize;    // текущий размер таблицы (не больше limit)
+    size_t size;       // занято: длины строк + 32 на запись
+    bool resized;      // кодер: перед следующим полем сообщить новый размер
+    int first, count;  // кольцо записей, first - самая старая
+    size_t used;       // конец занятой части data
+    HpackEntry entries[HPACK_MAX_ENTRIES];
+    char data[HPACK_TABLE_SIZE];
+} HpackTable;
+
+void hpackInit(HpackTable *t, size_t limit);
+
+// Кодер: новый предел таблицы (SETTINGS_HEADER_TABLE_SIZE собеседника)
+void hpackResize(HpackTable *t, size_t limit);
+
+// Разбирает блок заголовков в fields (не больше max); строки копируются
+// в арену. false - ошибка сжатия или полей больше max
+bool hpackDecode(HpackTable *t, Arena *a, const uint8_t *in, size_t len,
+                 HttpField *fields, int max, int *count);
+
+// Кодирует одно поле (имя в нижнем регистре); index - добавить его в
+// динамическую таблицу. Возвращает длину или 0, если не хватило cap
+size_t hpackEncode(HpackTable *t, uint8_t *out, size_t cap, const char *name, size_t nameLen,
+                   const char *value, size_t valueLen, bool index);
+
+// Наибольшая длина закодированного поля (для проверки места до кодирования)
+static inline size_t hpackEncodedMax(size_t nameLen, size_t valueLen)
+{
+    return nameLen + valueLen + 16;
+}
+
+#endif
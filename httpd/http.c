@@ -0,0 +1,262 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "http.h"
+
+size_t httpRequestLength(const char *buf, size_t len)
+{
+    const char *end = memmem(buf, len, "\r\n\r\n", 4);
+    const char *value;
+    size_t headLen, valueLen;
+
+    if (!end)
+        return 0;
+    headLen = end + 4 - buf;
+    value = httpHeader(buf, headLen, "Content-Length", &valueLen);
+    if (value)
+    {
+        size_t bodyLen = strtoul(value, NULL, 10);
+        if (bodyLen > len - headLen)
+            return 0;
+        headLen += bodyLen;
+    }
+    return headLen;
+}
+
+const char *httpHeader(const char *req, size_t reqLen, const char *name, size_t *valueLen)
+{
+    size_t nameLen = strlen(name);
+    const char *end = req + reqLen;
+    const char *line = memchr(req, '\n', reqLen); // пропуск строки запроса
+
+    while (line && ++line < end && *line != '\r')
+    {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol)
+            break;
+        if ((size_t)(eol - line) > nameLen && line[nameLen] == ':' && !strncasecmp(line, name, nameLen))
+        {
+            const char *value = line + nameLen + 1;
+            const char *valueEnd = eol;
+            while (value < valueEnd && (*value == ' ' || *value == '\t'))
+                value++;
+            while (valueEnd > value && (valueEnd[-1] == '\r' || valueEnd[-1] == ' '))
+                valueEnd--;
+            *valueLen = valueEnd - value;
+            return value;
+        }
+        line = eol;
+    }
+    return NULL;
+}
+
+bool httpHasToken(const char *value, size_t len, const char *token)
+{
+    size_t tokenLen = strlen(token);
+    const char *end = value + len;
+
+    while (value < end)
+    {
+        const char *comma = memchr(value, ',', end - value);
+        const char *itemEnd = comma ? comma : end;
+
+        while (value < itemEnd && *value == ' ')
+            value++;
+        while (itemEnd > value && itemEnd[-1] == ' ')
+            itemEnd--;
+        if ((size_t)(itemEnd - value) == tokenLen && !strncasecmp(value, token, tokenLen))
+            return true;
+        value = comma ? comma + 1 : end;
+    }
+    return false;
+}
+
+bool httpKeepAlive(const char *req, size_t reqLen)
+{
+    const char *eol = memchr(req, '\r', reqLen);
+    size_t valueLen;
+    const char *value = httpHeader(req, reqLen, "Connection", &valueLen);
+    bool http11 = eol && eol - req >= 8 && !memcmp(eol - 8, "HTTP/1.1", 8);
+
+    if (value && httpHasToken(value, valueLen, "close"))
+        return false;
+    if (value && httpHasToken(value, valueLen, "keep-alive"))
+        return true;
+    return http11;
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// Копия части строки запроса в арену с раскодированием %XX и '+'
+static char *decodeArg(Arena *a, const char *s, size_t len, size_t *outLen)
+{
+    char *out = arenaAlloc(a, len + 1);
+    size_t n = 0;
+
+    if (!out)
+        return NULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (s[i] == '%' && i + 2 < len && hexDigit(s[i + 1]) >= 0 && hexDigit(s[i + 2]) >= 0)
+        {
+            out[n++] = (char)(hexDigit(s[i + 1]) << 4 | hexDigit(s[i + 2]));
+            i += 2;
+        }
+        else
+        {
+            out[n++] = s[i] == '+' ? ' ' : s[i];
+        }
+    }
+    out[n] = '\0';
+    *outLen = n;
+    return out;
+}
+
+static bool parseArgs(Arena *a, const char *query, size_t len, HttpRequest *r)
+{
+    int count = 1;
+
+    for (size_t i = 0; i < len; i++)
+        count += query[i] == '&';
+    if (!(r->args = arenaAlloc(a, count * sizeof(HttpField))))
+        return false;
+
+    while (len)
+    {
+        const char *amp = memchr(query, '&', len);
+        size_t itemLen = amp ? (size_t)(amp - query) : len;
+        const char *eq = memchr(query, '=', itemLen);
+        size_t nameLen = eq ? (size_t)(eq - query) : itemLen;
+        HttpField *f = &r->args[r->argCount];
+
+        if (itemLen)
+        {
+            f->name = decodeArg(a, query, nameLen, &f->nameLen);
+            f->value = eq ? decodeArg(a, eq + 1, itemLen - nameLen - 1, &f->valueLen) : "";
+            if (!eq)
+                f->valueLen = 0;
+            if (!f->name || !f->value)
+                return false;
+            r->argCount++;
+        }
+        query += itemLen + (amp != NULL);
+        len -= itemLen + (amp != NULL);
+    }
+    return true;
+}
+
+bool httpParseTarget(Arena *a, const char *target, size_t len, HttpRequest *r)
+{
+    const char *query = memchr(target, '?', len);
+
+    r->path = arenaCopy(a, target, (query ? query : target + len) - target);
+    if (!r->path || !*r->path)
+        return false;
+    return !query || parseArgs(a, query + 1, target + len - query - 1, r);
+}
+
+bool httpParse(Arena *a, const char *req, size_t reqLen, HttpRequest *r)
+{
+    const char *end = req + reqLen;
+    const char *eol = memchr(req, '\n', reqLen);
+    const char *sp1, *sp2, *line, *headEnd, *connection;
+    size_t connectionLen;
+    int count = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (!eol || !(sp1 = memchr(req, ' ', eol - req)) || !(sp2 = memchr(sp1 + 1, ' ', eol - sp1 - 1)))
+        return false;
+    r->method = arenaCopy(a, req, sp1 - req);
+    if (!r->method || sp1 == req || !httpParseTarget(a, sp1 + 1, sp2 - sp1 - 1, r))
+        return false;
+
+    // Сначала считаем строки заголовков, чтобы выделить массив одним куском
+    headEnd = memmem(req, reqLen, "\r\n\r\n", 4);
+    headEnd = headEnd ? headEnd + 2 : end;
+    for (line = eol + 1; line < headEnd && (line = memchr(line, '\n', headEnd - line)); line++)
+        count++;
+    if (count && !(r->headers = arenaAlloc(a, count * sizeof(HttpField))))
+        return false;
+
+    for (line = eol + 1; line < headEnd && r->headerCount < count;)
+    {
+        const char *lineEnd = memchr(line, '\n', headEnd - line);
+        const char *colon = memchr(line, ':', lineEnd - line);
+        const char *value, *valueEnd = lineEnd;
+
+        if (colon)
+        {
+            HttpField *f = &r->headers[r->headerCount++];
+
+            value = colon + 1;
+            while (value < valueEnd && (*value == ' ' || *value == '\t'))
+                value++;
+            while (valueEnd > value && (valueEnd[-1] == '\r' || valueEnd[-1] == ' '))
+                valueEnd--;
+            f->name = line;
+            f->nameLen = colon - line;
+            f->value = value;
+            f->valueLen = valueEnd - value;
+        }
+        line = lineEnd + 1;
+    }
+
+    r->body = headEnd + 2 <= end ? headEnd + 2 : end;
+    r->bodyLen = end - r->body;
+    connection = httpField(r->headers, r->headerCount, "Connection", &connectionLen);
+    if (connection && httpHasToken(connection, connectionLen, "close"))
+        r->keepAlive = false;
+    else if (connection && httpHasToken(connection, connectionLen, "keep-alive"))
+        r->keepAlive = true;
+    else
+        r->keepAlive = eol - sp2 >= 9 && !memcmp(sp2 + 1, "HTTP/1.1", 8);
+    return true;
+}
+
+const char *httpField(const HttpField *fields, int count, const char *name, size_t *valueLen)
+{
+    size_t nameLen = strlen(name);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (fields[i].nameLen == nameLen && !strncasecmp(fields[i].name, name, nameLen))
+        {
+            *valueLen = fields[i].valueLen;
+            return fields[i].value;
+        }
+    }
+    return NULL;
+}
+
+bool httpAcceptsEncoding(const char *value, size_t len, const char *name)
+{
+    size_t nameLen = strlen(name);
+    const char *end = value + len;
+
+    while (value && value < end)
+    {
+        const char *comma = memchr(value, ',', end - value);
+        const char *itemEnd = comma ? comma : end;
+        const char *semi = memchr(value, ';', itemEnd - value);
+        const char *tokenEnd = semi ? semi : itemEnd;
+
+        while (value < tokenEnd && *value == ' ')
+            value++;
+        while (tokenEnd > value && tokenEnd[-1] == ' ')
+            tokenEnd--;
+        if ((size_t)(tokenEnd - value) == nameLen && !strncasecmp(value, name, nameLen))
+        {
+            const char *q = semi ? memmem(semi, itemEnd - semi, "q=", 2) : NULL;
+            return !q || strtod(q + 2, NULL) > 0;
+        }
+        value = comma ? comma + 1 : NULL;
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+// Разбор запросов HTTP/1.x прямо в буфере соединения, без копирования.
+#ifndef HTTPD_HTTP_H
+#define HTTPD_HTTP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+
+typedef struct
+{
+    const char *name;
+    size_t nameLen;
+    const char *value;
+    size_t valueLen;
+} HttpField;
+
+// Разобранный запрос: массивы и копии строк в арене соединения,
+// значения заголовков указывают прямо в буфер приема
+typedef struct
+{
+    char *method;
+    char *path;          // без строки запроса
+    HttpField *headers;
+    int headerCount;
+    HttpField *args;     // аргументы после '?', раскодированные, с нулем в конце
+    int argCount;
+    const char *body;
+    size_t bodyLen;
+    bool keepAlive;
+} HttpRequest;
+
+// Длина первого запроса в буфере (заголовки и тело по Content-Length)
+// или 0, если запрос еще не пришел целиком
+size_t httpRequestLength(const char *buf, size_t len);
+
+// Значение заголовка name (без учета регистра) или NULL; длина в *valueLen
+const char *httpHeader(const char *req, size_t reqLen, const char *name, size_t *valueLen);
+
+// Есть ли token в списке через запятую (Connection: keep-alive, Upgrade)
+bool httpHasToken(const char *value, size_t len, const char *token);
+
+// Принимает ли клиент кодирование name по значению Accept-Encoding
+// (q=0 означает отказ)
+bool httpAcceptsEncoding(const char *value, size_t len, const char *name);
+
+// Оставлять ли соединение открытым после ответа
+bool httpKeepAlive(const char *req, size_t reqLen);
+
+// Разбирает запрос длиной reqLen (см. httpRequestLength); false - ошибка разбора
+bool httpParse(Arena *a, const char *req, size_t reqLen, HttpRequest *r);
+
+// Путь и аргументы из цели запроса "/path?a=1" длиной len (для HTTP/2 - :path)
+bool httpParseTarget(Arena *a, const char *target, size_t len, HttpRequest *r);
+
+// Поле name (без учета регистра) из массива заголовков или аргументов
+const char *httpField(const HttpField *fields, int count, const char *name, size_t *valueLen);
+
+#endif
@@ -0,0 +1,228 @@
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metrics.h"
+
+#define RENDER_MIN_CAP 8192
+
+enum
+{
+    METRIC_COUNTER,
+    METRIC_HISTOGRAM,
+    METRIC_READ
+};
+
+typedef struct
+{
+    int kind;
+    const char *name;
+    const char *labels;
+    const char *help;
+    const char *type;
+    int slot;                // первая ячейка в сегменте
+    const uint64_t *bounds;  // гистограмма: границы, затем +Inf и сумма
+    int count;
+    double scale;
+    double (*read)(void);
+} Metric;
+
+typedef struct MetricShard MetricShard;
+
+// Сегмент потока: пишет только владелец, читает сборщик
+struct MetricShard
+{
+    _Atomic uint64_t v[METRICS_MAX_SLOTS];
+    MetricShard *next;
+};
+
+static Metric metrics[METRICS_MAX];
+static int metricCount, slotCount;
+static _Atomic(MetricShard *) shards;
+static __thread MetricShard *localShard;
+static SharedBuf *rendered;
+
+static int metricAddDef(int kind, const char *name, const char *labels, const char *help, int slots)
+{
+    Metric *m;
+
+    if (metricCount == METRICS_MAX || slotCount + slots > METRICS_MAX_SLOTS)
+        return -1;
+    m = &metrics[metricCount];
+    m->kind = kind;
+    m->name = name;
+    m->labels = labels;
+    m->help = help;
+    m->type = kind == METRIC_HISTOGRAM ? "histogram" : "counter";
+    m->slot = slotCount;
+    slotCount += slots;
+    return metricCount++;
+}
+
+int metricCounter(const char *name, const char *labels, const char *help)
+{
+    return metricAddDef(METRIC_COUNTER, name, labels, help, 1);
+}
+
+int metricHistogram(const char *name, const char *labels, const char *help,
+                    const uint64_t *bounds, int count, double scale)
+{
+    int id = metricAddDef(METRIC_HISTOGRAM, name, labels, help, count + 2);
+
+    if (id < 0)
+        return -1;
+    metrics[id].bounds = bounds;
+    metrics[id].count = count;
+    metrics[id].scale = scale;
+    return id;
+}
+
+void metricRead(const char *name, const char *labels, const char *help, const char *type,
+                double (*read)(void))
+{
+    int id = metricAddDef(METRIC_READ, name, labels, help, 0);
+
+    if (id < 0)
+        return;
+    metrics[id].type = type;
+    metrics[id].read = read;
+}
+
+// Сегмент текущего потока создается при первой записи
+static MetricShard *shardForThread(void)
+{
+    MetricShard *shard = localShard;
+
+    if (shard)
+        return shard;
+    shard = aligned_alloc(64, (sizeof(MetricShard) + 63) & ~(size_t)63);
+    if (!shard)
+        return NULL;
+    memset(shard, 0, sizeof(*shard));
+    shard->next = atomic_load(&shards);
+    while (!atomic_compare_exchange_weak(&shards, &shard->next, shard))
+        ;
+    return localShard = shard;
+}
+
+// Единственный писатель ячейки - владелец сегмента, поэтому хватает load + store
+static inline void slotAdd(MetricShard *shard, int slot, uint64_t value)
+{
+    uint64_t old = atomic_load_explicit(&shard->v[slot], memory_order_relaxed);
+    atomic_store_explicit(&shard->v[slot], old + value, memory_order_relaxed);
+}
+
+void metricAdd(int id, uint64_t value)
+{
+    MetricShard *shard;
+
+    if (id >= 0 && (shard = shardForThread()))
+        slotAdd(shard, metrics[id].slot, value);
+}
+
+void metricObserve(int id, uint64_t value)
+{
+    const Metric *m;
+    MetricShard *shard;
+    int bucket = 0;
+
+    if (id < 0 || !(shard = shardForThread()))
+        return;
+    m = &metrics[id];
+    while (bucket < m->count && value > m->bounds[bucket])
+        bucket++;
+    slotAdd(shard, m->slot + bucket, 1);
+    slotAdd(shard, m->slot + m->count + 1, value);
+}
+
+static uint64_t slotSum(int slot)
+{
+    uint64_t sum = 0;
+
+    for (MetricShard *shard = atomic_load(&shards); shard; shard = shard->next)
+        sum += atomic_load_explicit(&shard->v[slot], memory_order_relaxed);
+    return sum;
+}
+
+// Дописывает в буфер; при нехватке места помечает переполнение
+static void put(SharedBuf *buf, bool *overflow, const char *format, ...)
+{
+    va_list args;
+    int n;
+
+    if (*overflow)
+        return;
+    va_start(args, format);
+    n = vsnprintf(buf->data + buf->len, buf->cap - buf->len, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= buf->cap - buf->len)
+        *overflow = true;
+    else
+        buf->len += n;
+}
+
+static void renderMetric(SharedBuf *buf, bool *overflow, const Metric *m)
+{
+    const char *labels = m->labels ? m->labels : "";
+    const char *sep = m->labels ? "," : "";
+
+    if (m->kind == METRIC_COUNTER)
+    {
+        put(buf, overflow, m->labels ? "%s{%s} %llu\n" : "%s%s %llu\n", m->name, labels,
+            (unsigned long long)slotSum(m->slot));
+    }
+    else if (m->kind == METRIC_READ)
+    {
+        put(buf, overflow, m->labels ? "%s{%s} %.9g\n" : "%s%s %.9g\n", m->name, labels, m->read());
+    }
+    else
+    {
+        uint64_t cumulative = 0;
+
+        for (int i = 0; i < m->count; i++)
+        {
+            cumulative += slotSum(m->slot + i);
+            put(buf, overflow, "%s_bucket{%s%sle=\"%g\"} %llu\n", m->name, labels, sep,
+                m->bounds[i] * m->scale, (unsigned long long)cumulative);
+        }
+        cumulative += slotSum(m->slot + m->count);
+        put(buf, overflow, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", m->name, labels, sep,
+            (unsigned long long)cumulative);
+        put(buf, overflow, m->labels ? "%s_sum{%s} %.9g\n" : "%s_sum%s %.9g\n", m->name, labels,
+            slotSum(m->slot + m->count + 1) * m->scale);
+        put(buf, overflow, m->labels ? "%s_count{%s} %llu\n" : "%s_count%s %llu\n", m->name, labels,
+            (unsigned long long)cumulative);
+    }
+}
+
+SharedBuf *metricsRender(void)
+{
+    size_t cap = rendered ? rendered->cap : RENDER_MIN_CAP;
+
+    for (;;)
+    {
+        bool overflow = false;
+
+        // Прошлый ответ еще в очереди какого-то соединения - нужен новый буфер
+        if (!rendered || rendered->refs > 1 || rendered->cap < cap)
+        {
+            sharedBufUnref(rendered);
+            if (!(rendered = sharedBufNew(cap)))
+                return NULL;
+        }
+        rendered->len = 0;
+        for (int i = 0; i < metricCount; i++)
+        {
+            const Metric *m = &metrics[i];
+
+            if (!i || strcmp(m->name, metrics[i - 1].name))
+                put(rendered, &overflow, "# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, m->type);
+            renderMetric(rendered, &overflow, m);
+        }
+        if (!overflow)
+            return sharedBufRef(rendered);
+        cap = rendered->cap * 2;
+    }
+}
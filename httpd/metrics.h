@@ -0,0 +1,35 @@
+// Метрики в текстовом формате Prometheus.
+// Каждый поток пишет счетчики и гистограммы в свой сегмент без
+// атомарных операций чтения-изменения-записи и без блокировок; сегменты
+// суммируются только при запросе /metrics. Метрики регистрируются при
+// запуске, до старта рабочих потоков.
+#ifndef HTTPD_METRICS_H
+#define HTTPD_METRICS_H
+
+#include <stdint.h>
+#include "buf.h"
+
+#define METRICS_MAX_SLOTS 512 // ячеек сегмента: счетчик - 1, гистограмма - границы + 2
+#define METRICS_MAX 128       // зарегистрированных метрик
+
+// Счетчик; метрики с одинаковым name и разными labels выводятся одной группой.
+// labels - например "status=\"200\"" или NULL. Возвращает номер или -1.
+int metricCounter(const char *name, const char *labels, const char *help);
+
+// Гистограмма с верхними границами bounds (по возрастанию) в единицах
+// metricObserve; scale переводит их в единицы вывода (1e-6 для мкс в секундах)
+int metricHistogram(const char *name, const char *labels, const char *help,
+                    const uint64_t *bounds, int count, double scale);
+
+// Значение, читаемое при сборе (число соединений и т.п.); type - "gauge" или "counter"
+void metricRead(const char *name, const char *labels, const char *help, const char *type,
+                double (*read)(void));
+
+void metricAdd(int id, uint64_t value);
+
+void metricObserve(int id, uint64_t value);
+
+// Текст всех метрик; буфер переиспользуется, если прошлый ответ уже отправлен
+SharedBuf *metricsRender(void);
+
+#endif
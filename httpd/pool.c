@@ -0,0 +1,319 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+#include "pool.h"
+
+#define DEQUE_SIZE 1024    // задач в деке рабочего, степень двойки
+#define INJECT_BATCH 16    // сколько задач рабочий забирает из общей очереди за раз
+#define IDLE_WAIT_NS 10000000 // страховочный таймаут сна рабочего
+
+// Дека Chase-Lev (вариант Lê и др. для слабых моделей памяти)
+typedef struct
+{
+    _Alignas(64) _Atomic long top;
+    _Alignas(64) _Atomic long bottom;
+    _Atomic(PoolTask *) buf[DEQUE_SIZE];
+} Deque;
+
+typedef struct
+{
+    Deque deque;
+    pthread_t thread;
+    unsigned seed; // для выбора жертвы кражи
+} Worker;
+
+static Worker *workers;
+static int workerCount;
+static __thread Worker *self;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static int sleepers;
+static bool stopping;
+static PoolTask *injectHead, *injectTail; // общая очередь, под lock
+static _Atomic long injectCount;
+
+static _Atomic(PoolTask *) completed; // стек Трайбера завершенных задач
+static int eventFd = -1;
+
+static bool dequePush(Deque *d, PoolTask *t)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+
+    if (b - top >= DEQUE_SIZE)
+        return false;
+    atomic_store_explicit(&d->buf[b & (DEQUE_SIZE - 1)], t, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+// Владелец берет задачу снизу
+static PoolTask *dequeTake(Deque *d)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    long top;
+    PoolTask *t = NULL;
+
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    top = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (top <= b)
+    {
+        t = atomic_load_explicit(&d->buf[b & (DEQUE_SIZE - 1)], memory_order_relaxed);
+        if (top == b)
+        {
+            // последняя задача: соревнуемся с ворами
+            if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                                         memory_order_seq_cst, memory_order_relaxed))
+                t = NULL;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+    }
+    else
+    {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return t;
+}
+
+// Вор берет задачу сверху; NULL - пусто или кража перехвачена
+static PoolTask *dequeSteal(Deque *d)
+{
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    long b;
+    PoolTask *t;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (top >= b)
+        return NULL;
+    t = atomic_load_explicit(&d->buf[top & (DEQUE_SIZE - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return t;
+}
+
+// Завершенная задача уходит в стек, первая в пустом стеке будит цикл epoll
+static void finish(PoolTask *t)
+{
+    PoolTask *head = atomic_load_explicit(&completed, memory_order_relaxed);
+
+    do
+        t->next = head;
+    while (!atomic_compare_exchange_weak_explicit(&completed, &head, t,
+                                                  memory_order_release, memory_order_relaxed));
+    if (!head)
+    {
+        uint64_t one = 1;
+        if (write(eventFd, &one, sizeof(one)) < 0)
+            return; // счетчик eventfd уже взведен
+    }
+}
+
+// Пачка задач из общей очереди: первая выполняется, остальные в свою деку
+static PoolTask *takeInjected(Worker *w)
+{
+    PoolTask *first = NULL;
+    int taken = 0;
+
+    if (!atomic_load_explicit(&injectCount, memory_order_relaxed))
+        return NULL;
+    pthread_mutex_lock(&lock);
+    while (injectHead && taken < INJECT_BATCH)
+    {
+        PoolTask *t = injectHead;
+        injectHead = t->next;
+        if (!injectHead)
+            injectTail = NULL;
+        if (!first)
+            first = t;
+        else if (!dequePush(&w->deque, t))
+        {
+            // дека заполнена - вернуть задачу в очередь
+            t->next = injectHead;
+            injectHead = t;
+            if (!injectTail)
+                injectTail = t;
+            break;
+        }
+        taken++;
+    }
+    atomic_fetch_sub_explicit(&injectCount, taken, memory_order_relaxed);
+    if (taken > 1 && sleepers)
+        pthread_cond_broadcast(&wake); // есть что украсть
+    pthread_mutex_unlock(&lock);
+    return first;
+}
+
+static PoolTask *stealWork(Worker *w)
+{
+    int start = rand_r(&w->seed) % workerCount;
+
+    for (int i = 0; i < workerCount; i++)
+    {
+        Worker *victim = &workers[(start + i) % workerCount];
+        PoolTask *t;
+
+        if (victim != w && (t = dequeSteal(&victim->deque)))
+            return t;
+    }
+    return NULL;
+}
+
+static void *workerThread(void *arg)
+{
+    Worker *w = arg;
+
+    self = w;
+    for (;;)
+    {
+        PoolTask *t = dequeTake(&w->deque);
+
+        if (!t)
+            t = takeInjected(w);
+        if (!t)
+            t = stealWork(w);
+        if (!t)
+        {
+            struct timespec until;
+
+            pthread_mutex_lock(&lock);
+            if (stopping)
+            {
+                pthread_mutex_unlock(&lock);
+                break;
+            }
+            if (!injectHead)
+            {
+                clock_gettime(CLOCK_REALTIME, &until);
+                until.tv_nsec += IDLE_WAIT_NS;
+                if (until.tv_nsec >= 1000000000)
+                {
+                    until.tv_sec++;
+                    until.tv_nsec -= 1000000000;
+                }
+                sleepers++;
+                pthread_cond_timedwait(&wake, &lock, &until);
+                sleepers--;
+            }
+            pthread_mutex_unlock(&lock);
+            continue;
+        }
+        t->run(t);
+        finish(t);
+    }
+    return NULL;
+}
+
+int poolStart(int count)
+{
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd < 0)
+        return -1;
+    if (count <= 0)
+        return eventFd;
+
+    workers = calloc(count, sizeof(Worker));
+    if (!workers)
+        return -1;
+    // воры выбирают жертву среди всех рабочих, поэтому число задается заранее
+    workerCount = count;
+    for (int i = 0; i < count; i++)
+    {
+        workers[i].seed = i * 2654435761u + 1;
+        if (pthread_create(&workers[i].thread, NULL, workerThread, &workers[i]))
+        {
+            workerCount = i;
+            poolStop();
+            return -1;
+        }
+    }
+    return eventFd;
+}
+
+void poolStop(void)
+{
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&lock);
+    for (int i = 0; i < workerCount; i++)
+        pthread_join(workers[i].thread, NULL);
+    free(workers);
+    workers = NULL;
+    workerCount = 0;
+    if (eventFd >= 0)
+        close(eventFd);
+    eventFd = -1;
+}
+
+void poolSubmit(PoolTask *t)
+{
+    if (!workerCount)
+    {
+        // без рабочих потоков задача выполняется сразу, done - как обычно из цикла
+        t->run(t);
+        finish(t);
+        return;
+    }
+    t->next = NULL;
+    pthread_mutex_lock(&lock);
+    if (injectTail)
+        injectTail->next = t;
+    else
+        injectHead = t;
+    injectTail = t;
+    atomic_fetch_add_explicit(&injectCount, 1, memory_order_relaxed);
+    if (sleepers)
+        pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+}
+
+void poolSpawn(PoolTask *t)
+{
+    if (!self || !dequePush(&self->deque, t))
+    {
+        poolSubmit(t);
+        return;
+    }
+    if (sleepers)
+    {
+        pthread_mutex_lock(&lock);
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+void poolComplete(void)
+{
+    uint64_t count;
+    PoolTask *list, *ordered = NULL;
+
+    if (read(eventFd, &count, sizeof(count)) < 0)
+    {
+        // счетчик уже сброшен, стек все равно проверяем
+    }
+    list = atomic_exchange_explicit(&completed, NULL, memory_order_acquire);
+
+    // стек - в порядке завершения
+    while (list)
+    {
+        PoolTask *next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    while (ordered)
+    {
+        PoolTask *next = ordered->next;
+        ordered->done(ordered);
+        ordered = next;
+    }
+}
@@ -0,0 +1,35 @@
+// Пул рабочих потоков для блокирующих обработчиков (GPIO, датчики, файлы).
+// У каждого рабочего своя дека Chase-Lev: владелец берет задачи снизу,
+// свободные рабочие крадут сверху. Цикл epoll отдает задачи через общую
+// очередь, а завершенные задачи возвращаются ему через eventfd и
+// выполняют done уже в потоке ввода-вывода.
+#ifndef HTTPD_POOL_H
+#define HTTPD_POOL_H
+
+#include <stdbool.h>
+
+typedef struct PoolTask PoolTask;
+
+struct PoolTask
+{
+    void (*run)(PoolTask *t);  // выполняется в рабочем потоке
+    void (*done)(PoolTask *t); // затем в потоке, вызвавшем poolComplete
+    PoolTask *next;            // служебное поле пула
+};
+
+// Запускает workers потоков; возвращает eventfd для epoll или -1.
+// При workers == 0 run выполняется сразу в poolSubmit, done - через eventfd.
+int poolStart(int workers);
+
+void poolStop(void);
+
+// Отдает задачу пулу; память задачи принадлежит вызывающему до вызова done
+void poolSubmit(PoolTask *t);
+
+// Из рабочего потока: задача попадает в собственную деку рабочего
+void poolSpawn(PoolTask *t);
+
+// Вызывает done для всех завершенных задач; по готовности eventfd
+void poolComplete(void);
+
+#endif
@@ -0,0 +1,70 @@
+#include <string.h>
+#include "ratelimit.h"
+
+#define TOKEN 1000 // маркер в тысячных долях
+
+void rateInit(RateLimiter *r, unsigned perSecond, unsigned burst)
+{
+    memset(r, 0, sizeof(*r));
+    r->perSecond = perSecond;
+    r->burst = (burst ? burst : 1) * TOKEN;
+}
+
+static inline uint32_t hashAddr(uint32_t addr)
+{
+    return (addr * 0x9E3779B1u) >> 20; // старшие биты умножения Фибоначчи, 4096 ячеек
+}
+
+bool rateAllow(RateLimiter *r, uint32_t addr, uint64_t nowMs)
+{
+    uint32_t now = (uint32_t)nowMs, i = hashAddr(addr);
+    RateBucket *b = NULL, *oldest = NULL;
+
+    if (!r->perSecond)
+        return true;
+    for (int probe = 0; probe < RATE_PROBES; probe++, i = (i + 1) & (RATE_SLOTS - 1))
+    {
+        RateBucket *slot = &r->slots[i];
+
+        if (slot->addr == addr)
+        {
+            b = slot;
+            break;
+        }
+        if (!slot->addr)
+        {
+            oldest = slot; // свободная ячейка лучше любой занятой
+            break;
+        }
+        if (!oldest || now - slot->last > now - oldest->last)
+            oldest = slot;
+    }
+
+    if (!b)
+    {
+        // Новый адрес начинает с полным ведром
+        if (oldest->addr)
+            r->evicted++;
+        b = oldest;
+        b->addr = addr;
+        b->last = now;
+        b->tokens = r->burst;
+    }
+    else
+    {
+        // Пополнение за прошедшее время: perSecond маркеров в секунду - это
+        // perSecond тысячных в миллисекунду
+        uint64_t tokens = b->tokens + (uint64_t)(now - b->last) * r->perSecond;
+
+        b->tokens = tokens < r->burst ? (uint32_t)tokens : r->burst;
+        b->last = now;
+    }
+
+    if (b->tokens < TOKEN)
+    {
+        r->limited++;
+        return false;
+    }
+    b->tokens -= TOKEN;
+    return true;
+}
@@ -0,0 +1,40 @@
+// Ограничение частоты запросов по адресу клиента.
+// На каждый адрес IPv4 - ведро маркеров в хэш-таблице постоянного размера
+// с открытой адресацией. Ведро пополняется лениво, при обращении, на
+// время, прошедшее с прошлого обращения, так что таймеры и обходы таблицы
+// не нужны. Маркеры хранятся в тысячных долях, поэтому пополнение - одно
+// умножение. Если все ячейки окна проб заняты другими адресами, место
+// отдается ведру, к которому дольше всех не обращались. Память не выделяется.
+#ifndef HTTPD_RATELIMIT_H
+#define HTTPD_RATELIMIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RATE_SLOTS 4096 // ячеек таблицы, степень двойки
+#define RATE_PROBES 8   // ячеек, просматриваемых от места по хэшу
+
+typedef struct
+{
+    uint32_t addr;   // 0 - ячейка свободна
+    uint32_t last;   // время последнего пополнения, мс (младшие 32 бита)
+    uint32_t tokens; // тысячные доли маркера
+} RateBucket;
+
+typedef struct
+{
+    uint32_t perSecond;      // маркеров в секунду; 0 - ограничения нет
+    uint32_t burst;          // емкость ведра в тысячных долях маркера
+    unsigned long limited;   // отказов
+    unsigned long evicted;   // ведер, вытесненных новыми адресами
+    RateBucket slots[RATE_SLOTS];
+} RateLimiter;
+
+// perSecond маркеров в секунду, в ведре не больше burst
+void rateInit(RateLimiter *r, unsigned perSecond, unsigned burst);
+
+// Берет маркер адреса addr (в порядке байтов сети) в момент nowMs;
+// false - маркеров нет, запрос нужно отклонить
+bool rateAllow(RateLimiter *r, uint32_t addr, uint64_t nowMs);
+
+#endif
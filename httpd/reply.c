@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <string.h>
+#include "h2.h"
+#include "head.h"
+#include "reply.h"
+
+#define CHUNK_HEAD 6 // "XXXX\r\n": размер куска четырьмя шестнадцатеричными цифрами
+#define CHUNK_TAIL 2
+
+void replyInit(HttpReply *r, HttpSink sink, void *ctx, bool keepAlive, bool noBody)
+{
+    r->sink = sink;
+    r->ctx = ctx;
+    r->status = 0;
+    r->keepAlive = keepAlive;
+    r->noBody = noBody;
+    r->chunked = false;
+    r->bodyStarted = false;
+    r->failed = false;
+    r->ended = false;
+    r->len = 0;
+    r->sent = 0;
+}
+
+static void sinkWrite(HttpReply *r, const char *data, size_t len)
+{
+    if (!r->failed && len && !r->sink(r->ctx, data, len))
+        r->failed = true;
+}
+
+// Проставляет размер текущего куска и завершающий CRLF; пустой кусок
+// убирается, он означал бы конец тела
+static void closeChunk(HttpReply *r)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t size = r->len - r->chunkStart - CHUNK_HEAD;
+    char *p = r->buf + r->chunkStart;
+
+    if (!size)
+    {
+        r->len = r->chunkStart;
+        return;
+    }
+    // Ведущие нули в размере допустимы, поэтому место под него постоянное
+    p[0] = hex[size >> 12 & 15];
+    p[1] = hex[size >> 8 & 15];
+    p[2] = hex[size >> 4 & 15];
+    p[3] = hex[size & 15];
+    p[4] = '\r';
+    p[5] = '\n';
+    r->buf[r->len++] = '\r';
+    r->buf[r->len++] = '\n';
+}
+
+// Отдает накопленное и начинает следующий кусок
+static void flush(HttpReply *r)
+{
+    bool inChunk = r->chunked && r->bodyStarted;
+
+    if (inChunk)
+        closeChunk(r);
+    sinkWrite(r, r->buf, r->len);
+    r->len = 0;
+    if (inChunk)
+    {
+        r->chunkStart = 0;
+        r->len = CHUNK_HEAD;
+    }
+}
+
+// Копирует заголовки в буфер; при нехватке места отдает накопленное
+static void putHead(HttpReply *r, const char *data, size_t len)
+{
+    while (len)
+    {
+        size_t n = REPLY_BUF_SIZE - r->len < len ? REPLY_BUF_SIZE - r->len : len;
+
+        memcpy(r->buf + r->len, data, n);
+        r->len += n;
+        data += n;
+        len -= n;
+        if (r->len == REPLY_BUF_SIZE)
+            flush(r);
+    }
+}
+
+void replyStart(HttpReply *r, int status, const char *contentType, size_t length)
+{
+    char line[96], date[HEAD_DATE_LEN];
+
+    r->status = status;
+    putHead(r, line, snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", status, replyReason(status)));
+    if (contentType)
+        replyHeader(r, "Content-Type", contentType);
+    if (length != REPLY_LENGTH_UNKNOWN)
+    {
+        putHead(r, line, snprintf(line, sizeof(line), "Content-Length: %zu\r\n", length));
+    }
+    else if (!r->noBody)
+    {
+        putHead(r, "Transfer-Encoding: chunked\r\n", 28);
+        r->chunked = true;
+    }
+    headDate(date);
+    putHead(r, date, HEAD_DATE_LEN);
+    if (!r->keepAlive)
+        putHead(r, "Connection: close\r\n", 19);
+}
+
+void replyHeader(HttpReply *r, const char *name, const char *value)
+{
+    if (r->bodyStarted)
+        return;
+    putHead(r, name, strlen(name));
+    putHead(r, ": ", 2);
+    putHead(r, value, strlen(value));
+    putHead(r, "\r\n", 2);
+}
+
+// Пустая строка после заголовков и место под первый кусок
+static void startBody(HttpReply *r)
+{
+    putHead(r, "\r\n", 2);
+    r->bodyStarted = true;
+    if (r->chunked)
+    {
+        if (REPLY_BUF_SIZE - r->len < CHUNK_HEAD + CHUNK_TAIL + 1)
+            flush(r);
+        r->chunkStart = r->len;
+        r->len += CHUNK_HEAD;
+    }
+}
+
+void replyWrite(HttpReply *r, const void *data, size_t len)
+{
+    const char *p = data;
+    size_t tail = r->chunked ? CHUNK_TAIL : 0;
+
+    if (!r->bodyStarted)
+        startBody(r);
+    if (r->noBody || r->failed || r->ended || !len)
+        return;
+    r->sent += len;
+    // Большое тело известной длины пишется мимо буфера
+    if (!r->chunked && len >= REPLY_BUF_SIZE)
+    {
+        flush(r);
+        sinkWrite(r, p, len);
+        return;
+    }
+    while (len)
+    {
+        size_t room = REPLY_BUF_SIZE - tail - r->len;
+        size_t n = room < len ? room : len;
+
+        memcpy(r->buf + r->len, p, n);
+        r->len += n;
+        p += n;
+        len -= n;
+        if (r->len + tail == REPLY_BUF_SIZE)
+            flush(r);
+    }
+}
+
+void replyString(HttpReply *r, const char *s)
+{
+    replyWrite(r, s, strlen(s));
+}
+
+bool replyEnd(HttpReply *r)
+{
+    if (r->ended)
+        return !r->failed;
+    r->ended = true;
+    if (!r->bodyStarted)
+        startBody(r);
+    if (r->chunked && !r->noBody)
+    {
+        // Последний кусок и завершающий нулевой уходят одной записью
+        closeChunk(r);
+        if (REPLY_BUF_SIZE - r->len < 5)
+        {
+            sinkWrite(r, r->buf, r->len);
+            r->len = 0;
+        }
+        memcpy(r->buf + r->len, "0\r\n\r\n", 5);
+        r->len += 5;
+    }
+    sinkWrite(r, r->buf, r->len);
+    r->len = 0;
+    return !r->failed;
+}
+
+const char *replyReason(int status)
+{
+    switch (status)
+    {
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
+
+void replyQueue(Connection *c, int head, const char *body, size_t len, SharedBuf *owner)
+{
+    if (c->kind == CONN_H2)
+    {
+        size_t headLen;
+        const char *block = headBlock(head, &headLen);
+
+        h2Respond(c, c->stream, block, headLen, body, len, owner);
+        c->streamBytes = len;
+        return;
+    }
+    headQueue(c, head, len);
+    if (len)
+        connQueue(c, body, len, owner);
+}
+
+void replyQueueError(Connection *c, int head)
+{
+    if (c->kind != CONN_H2)
+        c->closeAfterWrite = true;
+    replyQueue(c, head, NULL, 0, NULL);
+}
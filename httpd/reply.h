@@ -0,0 +1,72 @@
+// Ответы двух видов.
+// HttpReply - ответ HTTP/1.1 через функцию записи (сокет, WiFiClient).
+// Строка статуса, заголовки и тело копятся в буфере ответа размером с
+// сегмент TCP и уходят в запись целыми буферами, так что заголовки и
+// начало тела идут одним сегментом. Тело неизвестной длины отдается
+// кусками (Transfer-Encoding: chunked): место под размер куска оставлено
+// в буфере заранее, и кусок тоже уходит одной записью. Память не выделяется.
+// replyQueue - ответ готовым блоком заголовков (head.h) и телом без
+// копирования в очередь соединения conn.c или в поток HTTP/2.
+#ifndef HTTPD_REPLY_H
+#define HTTPD_REPLY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "buf.h"
+
+#define REPLY_BUF_SIZE 1460               // сегмент TCP в Ethernet
+#define REPLY_LENGTH_UNKNOWN ((size_t)-1) // тело кусками
+
+typedef struct Connection Connection;
+
+// Пишет len байт целиком; false - соединение потеряно
+typedef bool (*HttpSink)(void *ctx, const char *data, size_t len);
+
+typedef struct
+{
+    HttpSink sink;
+    void *ctx;
+    int status;          // 0 - ответ еще не начат
+    bool keepAlive;      // без Connection: close
+    bool noBody;         // ответ на HEAD: тело не отправляется
+    bool chunked;
+    bool bodyStarted;    // заголовки закрыты пустой строкой
+    bool failed;         // запись не удалась, остальное отбрасывается
+    bool ended;          // ответ завершен, повторный replyEnd ничего не пишет
+    size_t chunkStart;   // начало текущего куска (место под его размер)
+    size_t len;
+    size_t sent;         // отправлено байт тела
+    char buf[REPLY_BUF_SIZE];
+} HttpReply;
+
+void replyInit(HttpReply *r, HttpSink sink, void *ctx, bool keepAlive, bool noBody);
+
+// Строка статуса, Content-Type (если не NULL), Content-Length или
+// chunked для REPLY_LENGTH_UNKNOWN, Date и Connection
+void replyStart(HttpReply *r, int status, const char *contentType, size_t length);
+
+// Дополнительный заголовок до начала тела
+void replyHeader(HttpReply *r, const char *name, const char *value);
+
+// Тело ответа по частям
+void replyWrite(HttpReply *r, const void *data, size_t len);
+void replyString(HttpReply *r, const char *s);
+
+// Завершает ответ (последний кусок для chunked); false - запись не удалась.
+// Можно вызвать раньше владельца, например перед перезапуском
+bool replyEnd(HttpReply *r);
+
+// Текст причины для строки статуса
+const char *replyReason(int status);
+
+// Ответ блоком head (HEAD_*) и телом: в HTTP/1.1 - в очередь соединения,
+// в HTTP/2 - в поток c->stream (длина тела - в c->streamBytes). body
+// живет вместе с owner, а без owner - не меньше соединения или копируется
+// сессией HTTP/2
+void replyQueue(Connection *c, int head, const char *body, size_t len, SharedBuf *owner);
+
+// Ответ об ошибке; соединение HTTP/1.1 после него закрывается, а сессия
+// HTTP/2 теряет только поток
+void replyQueueError(Connection *c, int head);
+
+#endif
@@ -0,0 +1,47 @@
+#include <string.h>
+#include "router.h"
+
+void routerInit(HttpRouter *r, HttpHandler notFound, void *arg)
+{
+    r->count = 0;
+    r->notFound.method = NULL;
+    r->notFound.path = "";
+    r->notFound.prefix = true;
+    r->notFound.handler = notFound;
+    r->notFound.arg = arg;
+}
+
+bool routerAdd(HttpRouter *r, const char *method, const char *path, bool prefix,
+               HttpHandler handler, void *arg)
+{
+    HttpRoute *route;
+
+    if (r->count == ROUTER_MAX_ROUTES)
+        return false;
+    route = &r->routes[r->count++];
+    route->method = method;
+    route->path = path;
+    route->prefix = prefix;
+    route->handler = handler;
+    route->arg = arg;
+    return true;
+}
+
+const HttpRoute *routerMatch(const HttpRouter *r, const char *method, const char *path)
+{
+    for (int i = 0; i < r->count; i++)
+    {
+        const HttpRoute *route = &r->routes[i];
+
+        if (route->method && strcmp(route->method, method))
+            continue;
+        if (route->prefix ? !strncmp(path, route->path, strlen(route->path)) : !strcmp(path, route->path))
+            return route;
+    }
+    return &r->notFound;
+}
+
+int routerDispatch(const HttpRouter *r, void *ctx, const HttpRequest *req)
+{
+    return routerMatch(r, req->method, req->path)->handler(ctx, req);
+}
@@ -0,0 +1,47 @@
+// Таблица маршрутов.
+// Маршрут - метод (или любой), точный путь или префикс пути и обработчик.
+// Таблица задается при запуске и просматривается по порядку добавления,
+// первый подходящий маршрут побеждает; запрос без маршрута уходит
+// обработчику notFound. Память не выделяется.
+#ifndef HTTPD_ROUTER_H
+#define HTTPD_ROUTER_H
+
+#include <stdbool.h>
+#include "http.h"
+
+#define ROUTER_MAX_ROUTES 32
+
+// ctx - соединение или обмен сервера, на который отвечает обработчик;
+// возвращает код ответа или 0, если ответ будет позже
+typedef int (*HttpHandler)(void *ctx, const HttpRequest *req);
+
+typedef struct
+{
+    const char *method;  // NULL - любой метод
+    const char *path;
+    bool prefix;         // path - начало пути ("/static/")
+    HttpHandler handler;
+    void *arg;           // данные обработчика (например, функция в адаптере)
+} HttpRoute;
+
+typedef struct
+{
+    HttpRoute routes[ROUTER_MAX_ROUTES];
+    int count;
+    HttpRoute notFound;
+} HttpRouter;
+
+void routerInit(HttpRouter *r, HttpHandler notFound, void *arg);
+
+// Добавляет маршрут; строки должны жить не меньше таблицы.
+// false - таблица заполнена
+bool routerAdd(HttpRouter *r, const char *method, const char *path, bool prefix,
+               HttpHandler handler, void *arg);
+
+// Маршрут запроса; notFound, если подходящего нет
+const HttpRoute *routerMatch(const HttpRouter *r, const char *method, const char *path);
+
+// Вызывает обработчик маршрута запроса req
+int routerDispatch(const HttpRouter *r, void *ctx, const HttpRequest *req);
+
+#endif
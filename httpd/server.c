@@ -0,0 +1,551 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "conn.h"
+#include "h2.h"
+#include "head.h"
+#include "server.h"
+#include "static.h"
+#include "timer.h"
+#include "ws.h"
+
+static void processInput(HttpServer *s, Connection *c);
+static void flushClient(HttpServer *s, Connection *c);
+
+uint64_t serverNowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int notFound(void *ctx, const HttpRequest *req)
+{
+    (void)req;
+    serverSend(ctx, 404, "text/plain", "Not Found", 9);
+    return 404;
+}
+
+void serverInit(HttpServer *s, void *user)
+{
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    s->epfd = epoll_create1(EPOLL_CLOEXEC);
+    s->user = user;
+    s->maxWaiting = SERVER_MAX_WAITING;
+    routerInit(&s->router, notFound, NULL);
+}
+
+bool serverBegin(HttpServer *s, uint16_t port)
+{
+    struct sockaddr_in addr;
+    struct epoll_event ev;
+    int one = 1;
+
+    if (s->epfd < 0)
+        return false;
+    s->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s->fd < 0)
+        return false;
+    setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    ev.events = EPOLLIN;
+    ev.data.ptr = &s->fd;
+    if (bind(s->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(s->fd, SOMAXCONN) < 0 ||
+        epoll_ctl(s->epfd, EPOLL_CTL_ADD, s->fd, &ev) < 0)
+    {
+        close(s->fd);
+        s->fd = -1;
+        return false;
+    }
+    connInit(s->epfd, s->maxWaiting);
+    s->now = timerNow();
+    return true;
+}
+
+bool serverWatch(HttpServer *s, int fd, ServerReady ready, void *arg)
+{
+    struct epoll_event ev;
+
+    if (s->epfd < 0 || s->watchCount == SERVER_MAX_WATCH)
+        return false;
+    s->watch[s->watchCount].fd = fd;
+    s->watch[s->watchCount].ready = ready;
+    s->watch[s->watchCount].arg = arg;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &s->watch[s->watchCount];
+    if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        return false;
+    s->watchCount++;
+    return true;
+}
+
+void serverStop(HttpServer *s)
+{
+    if (s->fd < 0)
+        return;
+    epoll_ctl(s->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    s->fd = -1;
+}
+
+// Исчерпан ли лимит адреса; время берется с пробуждения цикла. Локальные
+// адреса не исключаются: через обратный прокси все клиенты приходят с них
+static bool rateLimited(HttpServer *s, RateLimiter *r, const struct sockaddr_in *addr)
+{
+    return r && !rateAllow(r, addr->sin_addr.s_addr, s->now);
+}
+
+static void logRequest(HttpServer *s, Connection *c, const char *method, const char *path, int status,
+                       size_t bytes, uint64_t start)
+{
+    s->requests++;
+    if (s->onRequest)
+        s->onRequest(s, c, method, path, status, bytes, start);
+}
+
+// Запись HttpReply: сначала то, что уже в очереди соединения, затем
+// данные прямо в сокет; место в сокете ждем через poll, как ждала бы
+// однопоточная прошивка
+static bool sinkConn(void *ctx, const char *data, size_t len)
+{
+    Connection *c = ctx;
+    struct pollfd p = {c->fd, POLLOUT, 0};
+    int result;
+
+    while ((result = connFlush(c)) == 0)
+    {
+        if (poll(&p, 1, SERVER_WRITE_MS) <= 0)
+            return false;
+    }
+    if (result < 0)
+        return false;
+    while (len)
+    {
+        ssize_t n = send(c->fd, data, len, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EAGAIN)
+        {
+            if (poll(&p, 1, SERVER_WRITE_MS) <= 0)
+                return false;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// HTTP/2 не пишется в сокет напрямую: ответ через HttpReply в потоке не удается
+static bool sinkStream(void *ctx, const char *data, size_t len)
+{
+    (void)ctx, (void)data, (void)len;
+    return false;
+}
+
+void serverSend(HttpExchange *x, int status, const char *contentType, const void *body, size_t len)
+{
+    replyStart(&x->reply, status, contentType, len);
+    replyWrite(&x->reply, body, len);
+}
+
+int serverDetach(HttpExchange *x)
+{
+    x->reply.ended = true;
+    return connDetach(x->conn);
+}
+
+// Запрос req соединения c (поток stream в HTTP/2) обработчику маршрута;
+// возвращает код ответа или 0, если ответ будет позже
+static int dispatch(HttpServer *s, Connection *c, unsigned stream, const HttpRequest *req)
+{
+    HttpExchange x;
+    int status;
+
+    x.server = s;
+    x.conn = c;
+    x.stream = stream;
+    x.req = req;
+    x.route = routerMatch(&s->router, req->method, req->path);
+    replyInit(&x.reply, stream ? sinkStream : sinkConn, c, !c->closeAfterWrite, !strcmp(req->method, "HEAD"));
+    status = x.route->handler(&x, req);
+    // Ответ по частям уходит в сокет сразу; если запись не удалась, ответ
+    // оборван и соединение закрывается
+    if (x.reply.status && !x.reply.ended && !replyEnd(&x.reply))
+        c->closeAfterWrite = true;
+    if (x.reply.status && x.reply.failed)
+        c->closeAfterWrite = true;
+    return status;
+}
+
+// Запрос потока HTTP/2: ответ в поток и запись в журнал
+static void serveStream(Connection *c, unsigned stream, const HttpRequest *req)
+{
+    HttpServer *s = c->owner;
+    uint64_t start = serverNowNs();
+    int status;
+
+    c->stream = stream;
+    c->streamBytes = 0;
+    if (rateLimited(s, s->requestLimit, &c->addr))
+    {
+        replyQueue(c, HEAD_TOO_MANY, NULL, 0, NULL);
+        status = 429;
+    }
+    else
+    {
+        status = dispatch(s, c, stream, req);
+    }
+    if (status)
+        logRequest(s, c, req->method, req->path, status, c->streamBytes, start);
+}
+
+// Ответ на полностью принятый запрос длиной len и запись в журнал
+static void handleRequest(HttpServer *s, Connection *c, size_t len)
+{
+    HttpRequest req;
+    uint64_t start = serverNowNs();
+    size_t queued = c->queuedBytes;
+    int status;
+
+    if (!httpParse(&c->arena, c->in, len, &req))
+    {
+        c->closeAfterWrite = true;
+        headQueue(c, HEAD_BAD_REQUEST, 0);
+        logRequest(s, c, "-", "-", 400, c->queuedBytes - queued, start);
+        return;
+    }
+    if (s->h2c && h2Upgrade(c, &req, serveStream))
+        return; // запрос ушел потоком 1 уже в HTTP/2
+    c->closeAfterWrite = !req.keepAlive;
+    status = dispatch(s, c, 0, &req);
+    if (status)
+        logRequest(s, c, req.method, req.path, status, c->queuedBytes - queued, start);
+}
+
+bool serverUpgradeSocket(HttpExchange *x)
+{
+    Connection *c = x->conn;
+
+    if (c->kind != CONN_HTTP || !wsHandshake(c, c->in, httpRequestLength(c->in, c->inLen)))
+        return false;
+    c->kind = CONN_WS;
+    c->closeAfterWrite = false;
+    return true;
+}
+
+// Один кадр WebSocket из буфера приема, возвращает число разобранных байт
+static size_t socketInput(HttpServer *s, Connection *c)
+{
+    WsFrame f;
+    long used = wsParseFrame((uint8_t *)c->in, c->inLen, &f);
+    uint8_t status[2];
+
+    if (used == 0 && c->inLen < CONN_INBUF_SIZE)
+        return 0; // кадр еще не пришел целиком
+    if (used <= 0)
+    {
+        // 1002 - ошибка протокола, 1009 - кадр больше буфера
+        status[0] = 0x03;
+        status[1] = used < 0 ? 0xEA : 0xF1;
+        wsQueue(c, WS_OP_CLOSE, status, sizeof(status));
+        c->closeAfterWrite = true;
+        return c->inLen;
+    }
+
+    switch (f.opcode)
+    {
+    case WS_OP_BINARY:
+    case WS_OP_TEXT:
+        if (s->onMessage)
+            s->onMessage(s, c, f.payload, f.len);
+        break;
+    case WS_OP_PING:
+        wsQueue(c, WS_OP_PONG, f.payload, f.len);
+        break;
+    case WS_OP_CLOSE:
+        wsQueue(c, WS_OP_CLOSE, f.payload, f.len < 2 ? f.len : 2);
+        c->closeAfterWrite = true;
+        break;
+    }
+    return used;
+}
+
+// Разбор всех целиком принятых запросов или кадров из буфера соединения
+static void processInput(HttpServer *s, Connection *c)
+{
+    while (c->fd >= 0 && c->inLen && !c->busy && !c->closeAfterWrite && c->kind != CONN_SSE)
+    {
+        size_t used;
+
+        if (c->kind == CONN_WS)
+        {
+            used = socketInput(s, c);
+        }
+        else if (c->kind == CONN_H2)
+        {
+            used = h2Input(c);
+        }
+        else
+        {
+            int preface = s->h2c ? h2Preface(c->in, c->inLen) : -1;
+
+            if (preface == 0)
+                break; // может оказаться преамбулой HTTP/2, ждем еще байты
+            if (preface > 0)
+            {
+                // HTTP/2 с заранее известным протоколом: преамбулу разберет сессия
+                if (!h2Start(c, serveStream))
+                {
+                    connClose(c);
+                    return;
+                }
+                continue;
+            }
+            if (c->outCount > CONN_OUTQ_SIZE - 3)
+                break; // ответы на конвейер запросов ждут отправки
+            used = httpRequestLength(c->in, c->inLen);
+            if (!used && c->inLen == CONN_INBUF_SIZE)
+            {
+                // Запрос не помещается в буфер
+                size_t queued = c->queuedBytes;
+
+                c->closeAfterWrite = true;
+                headQueue(c, HEAD_TOO_LARGE, 0);
+                logRequest(s, c, "-", "-", 413, c->queuedBytes - queued, serverNowNs());
+                used = c->inLen;
+            }
+            else if (used && rateLimited(s, s->requestLimit, &c->addr))
+            {
+                // Отказ до разбора запроса
+                size_t queued = c->queuedBytes;
+
+                c->closeAfterWrite = !httpKeepAlive(c->in, used);
+                headQueue(c, HEAD_TOO_MANY, 0);
+                logRequest(s, c, "-", "-", 429, c->queuedBytes - queued, serverNowNs());
+            }
+            else if (used)
+            {
+                handleRequest(s, c, used);
+            }
+        }
+        if (!used)
+            break;
+        if (c->fd < 0)
+            return; // соединение закрыто рассылкой или отдано владельцу
+        memmove(c->in, c->in + used, c->inLen - used);
+        c->inLen -= used;
+        c->in[c->inLen] = '\0';
+    }
+}
+
+// Срок чтения запроса по тому, что уже пришло в буфер: отдельные сроки на
+// заголовки и на тело
+static void trackRequest(Connection *c)
+{
+    int wait = CONN_WAIT_NONE;
+
+    if (c->kind == CONN_H2)
+    {
+        // сессия ждет новых потоков, только когда все ответы отправлены
+        if (h2Idle(c) && !c->closeAfterWrite && !c->outCount)
+            wait = CONN_WAIT_IDLE;
+    }
+    else if (c->kind == CONN_HTTP && !c->busy && !c->closeAfterWrite && !c->outCount)
+    {
+        if (!c->inLen)
+            wait = CONN_WAIT_IDLE;
+        else if (!memmem(c->in, c->inLen, "\r\n\r\n", 4))
+            wait = CONN_WAIT_HEADERS;
+        else
+            wait = CONN_WAIT_BODY;
+    }
+    connWait(c, wait);
+}
+
+// Отправка очереди и закрытие соединения после ответа
+static void flushClient(HttpServer *s, Connection *c)
+{
+    int result;
+
+    while (c->fd >= 0)
+    {
+        result = connFlush(c);
+        if (result < 0 || (result > 0 && c->closeAfterWrite && !c->busy))
+        {
+            connClose(c);
+            return;
+        }
+        if (result == 0 || (!c->inLen && c->kind != CONN_H2))
+            break;
+        // очередь освободилась - досылаем тела потоков HTTP/2 и продолжаем
+        // разбор конвейера запросов
+        h2Pump(c);
+        processInput(s, c);
+        if (c->fd < 0 || !c->outCount)
+            break;
+    }
+    if (c->fd < 0)
+        return;
+    if (c->readPaused && c->inLen < CONN_INBUF_SIZE)
+        connPauseRead(c, false);
+    trackRequest(c);
+}
+
+void serverResume(HttpServer *s, Connection *c)
+{
+    processInput(s, c);
+    flushClient(s, c);
+}
+
+static void readClient(HttpServer *s, Connection *c)
+{
+    ssize_t result;
+
+    if (c->inLen == CONN_INBUF_SIZE)
+    {
+        // буфер полон: разбор продолжится после отложенного ответа или отправки
+        connPauseRead(c, true);
+        return;
+    }
+    result = recv(c->fd, c->in + c->inLen, CONN_INBUF_SIZE - c->inLen, 0);
+    if (result < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+    if (result <= 0)
+    {
+        connClose(c);
+        return;
+    }
+    if (c->kind == CONN_SSE || c->closeAfterWrite)
+        return; // подписчикам и уже ответившим слать нечего
+
+    c->inLen += result;
+    c->in[c->inLen] = '\0';
+    serverResume(s, c);
+}
+
+static void acceptClients(HttpServer *s)
+{
+    static const char tooMany[] = "HTTP/1.1 429 Too Many Requests\r\nRetry-After: 1\r\n"
+                                  "Content-Length: 0\r\nConnection: close\r\n\r\n";
+    struct sockaddr_in addr;
+    socklen_t size = sizeof(addr);
+    Connection *c;
+    int fd;
+
+    while ((fd = accept4(s->fd, (struct sockaddr *)&addr, &size, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+        size = sizeof(addr);
+        // Сверх лимита соединение не заводится: ответ влезает в буфер сокета
+        if (rateLimited(s, s->connectLimit, &addr))
+        {
+            send(fd, tooMany, sizeof(tooMany) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+            close(fd);
+            continue;
+        }
+        if (!(c = connOpen(fd, &addr)))
+        {
+            close(fd);
+            continue;
+        }
+        c->owner = s;
+    }
+}
+
+int serverStatic(void *ctx, const HttpRequest *req)
+{
+    HttpExchange *x = ctx;
+    Connection *c = x->conn;
+    const char *path = req->path + strlen(x->route->path) - 1, *acceptEncoding, *ifNoneMatch;
+    size_t acceptEncodingLen = 0, ifNoneMatchLen = 0;
+    StaticReply reply;
+
+    acceptEncoding = httpField(req->headers, req->headerCount, "Accept-Encoding", &acceptEncodingLen);
+    ifNoneMatch = httpField(req->headers, req->headerCount, "If-None-Match", &ifNoneMatchLen);
+    staticServe(path, strlen(path), acceptEncoding, acceptEncodingLen, ifNoneMatch, ifNoneMatchLen, &reply);
+
+    if (reply.status == 404)
+    {
+        replyQueue(c, HEAD_NOT_FOUND, NULL, 0, NULL);
+    }
+    else if (reply.status == 403)
+    {
+        replyQueue(c, HEAD_FORBIDDEN, NULL, 0, NULL);
+    }
+    else if (c->kind == CONN_H2)
+    {
+        // Тело читается из файла кадрами DATA
+        c->streamBytes = reply.status == 200 && strcmp(req->method, "HEAD") ? reply.bodyLen : 0;
+        h2Respond(c, c->stream, reply.head, reply.headLen, NULL, c->streamBytes, reply.owner);
+        return reply.status;
+    }
+    else
+    {
+        connQueue(c, reply.head, reply.headLen, reply.owner);
+        headQueueEnd(c);
+    }
+
+    if (reply.status == 200 && strcmp(req->method, "HEAD"))
+        connQueueFile(c, reply.owner, 0, reply.bodyLen);
+    return reply.status;
+}
+
+void serverPoll(HttpServer *s, int timeoutMs)
+{
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    int wait = timerWait(timerNow()), n;
+
+    if (s->epfd < 0)
+        return;
+    if (timeoutMs >= 0 && (wait < 0 || timeoutMs < wait))
+        wait = timeoutMs;
+    n = epoll_wait(s->epfd, events, SERVER_MAX_EVENTS, wait);
+    s->now = timerNow();
+
+    for (int i = 0; i < n; i++)
+    {
+        void *tag = events[i].data.ptr;
+
+        if (tag == &s->fd)
+        {
+            acceptClients(s);
+        }
+        else if ((char *)tag >= (char *)s->watch && (char *)tag < (char *)(s->watch + SERVER_MAX_WATCH))
+        {
+            int w = (int)(((char *)tag - (char *)s->watch) / sizeof(s->watch[0]));
+
+            if (!s->watch[w].ready(s, s->watch[w].arg))
+                epoll_ctl(s->epfd, EPOLL_CTL_DEL, s->watch[w].fd, NULL);
+        }
+        else
+        {
+            Connection *c = tag;
+
+            // Соединение могло быть закрыто рассылкой в этой же итерации
+            if (c->fd < 0)
+                continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+                connClose(c);
+            else if (events[i].events & EPOLLOUT)
+                flushClient(s, c);
+            else if (events[i].events & EPOLLIN)
+                readClient(s, c);
+        }
+    }
+    timerRun(timerNow()); // закрывает соединения с истекшим сроком
+    connReap();
+}
@@ -0,0 +1,114 @@
+// Сервер HTTP/1.1 на цикле epoll - общее ядро hw3.3_button и сборки
+// прошивки main.c для Linux (host/ESP8266WebServer). Соединения живут в
+// conn.c: неблокирующие сокеты, очередь фрагментов на отправку, сроки
+// ожидания запроса. Запрос разбирается в арену соединения, маршрут
+// выбирается по таблице, и обработчик отвечает одним из двух способов:
+// готовым блоком заголовков и телом без копирования (replyQueue) или по
+// частям через HttpReply обмена, который пишет прямо в сокет. Кроме
+// запросов ядро ведет подписчиков SSE, кадры WebSocket, сессии HTTP/2
+// без TLS (h2c) и раздает статику. На пути запроса память не выделяется.
+#ifndef HTTPD_SERVER_H
+#define HTTPD_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "http.h"
+#include "ratelimit.h"
+#include "reply.h"
+#include "router.h"
+
+#define SERVER_MAX_WAITING 1024 // соединений, ждущих запрос (по умолчанию)
+#define SERVER_MAX_WATCH 4      // дескрипторов владельца в цикле (консоль, пул)
+#define SERVER_MAX_EVENTS 256   // событий epoll за одну итерацию
+#define SERVER_WRITE_MS 2000    // ожидание места в сокете при записи HttpReply
+
+typedef struct HttpServer HttpServer;
+
+// Обработка одного запроса; ctx обработчиков маршрутов указывает сюда
+typedef struct
+{
+    HttpServer *server;
+    Connection *conn;
+    unsigned stream;         // поток HTTP/2 или 0
+    const HttpRequest *req;
+    const HttpRoute *route;
+    HttpReply reply;         // ответ по частям; только в HTTP/1.1
+} HttpExchange;
+
+// Готовность дескриптора владельца; false - больше за ним не следить
+typedef bool (*ServerReady)(HttpServer *s, void *arg);
+
+struct HttpServer
+{
+    int fd;                     // слушающий сокет
+    int epfd;
+    HttpRouter router;
+    void *user;                 // данные владельца (адаптер, программа)
+    unsigned long requests;     // обработано запросов
+    uint64_t now;               // пробуждение цикла, мс CLOCK_MONOTONIC
+
+    // Настройки владельца до serverBegin; после serverInit все выключено
+    int maxWaiting;             // соединений, ждущих запрос
+    bool h2c;                   // принимать HTTP/2 без TLS
+    RateLimiter *requestLimit;  // запросов с адреса, сверх - 429; NULL - без ограничения
+    RateLimiter *connectLimit;  // новых соединений с адреса
+    // Завершенный запрос - для журнала и метрик. bytes - поставлено в
+    // очередь соединения HTTP/1.1 или тело ответа потока HTTP/2
+    void (*onRequest)(HttpServer *s, Connection *c, const char *method, const char *path,
+                      int status, size_t bytes, uint64_t startNs);
+    // Кадр данных WebSocket (текст или двоичный); ping и close - забота ядра
+    void (*onMessage)(HttpServer *s, Connection *c, const uint8_t *payload, size_t len);
+
+    int watchCount;
+    struct
+    {
+        int fd;
+        ServerReady ready;
+        void *arg;
+    } watch[SERVER_MAX_WATCH];
+};
+
+// Таблица маршрутов пуста, запросы без маршрута получают 404
+void serverInit(HttpServer *s, void *user);
+
+// Слушает порт на всех адресах; false - ошибка сокета
+bool serverBegin(HttpServer *s, uint16_t port);
+
+// Дескриптор владельца (консоль, eventfd пула) в том же цикле: ready
+// вызывается при готовности к чтению. false - мест нет
+bool serverWatch(HttpServer *s, int fd, ServerReady ready, void *arg);
+
+// Одна итерация цикла: ждет событий не дольше timeoutMs (0 - только
+// проверить, -1 - до события или срока соединения), принимает клиентов,
+// читает и обрабатывает запросы, отправляет ответы
+void serverPoll(HttpServer *s, int timeoutMs);
+
+// Перестает принимать соединения
+void serverStop(HttpServer *s);
+
+// Время для startNs в onRequest, нс CLOCK_MONOTONIC
+uint64_t serverNowNs(void);
+
+// Ответ целиком через HttpReply: заголовки и тело известной длины
+void serverSend(HttpExchange *x, int status, const char *contentType, const void *body, size_t len);
+
+// Забирает соединение текущего запроса у сервера (поток событий и т.п.):
+// сервер больше не читает его, не отвечает на запрос и не закрывает
+// сокет - все это дальше делает владелец. Возвращает неблокирующий сокет
+int serverDetach(HttpExchange *x);
+
+// Продолжает соединение, ответ которому пришел позже (обработчик вернул
+// 0, например после задачи пула): конвейер запросов и отправка очереди
+void serverResume(HttpServer *s, Connection *c);
+
+// Переводит соединение запроса на WebSocket: ответ 101 в очереди, кадры
+// данных дальше идут в onMessage. false - не HTTP/1.1 или неверный Upgrade
+bool serverUpgradeSocket(HttpExchange *x);
+
+// Обработчик маршрута-префикса: файл из каталога staticInit (static.h),
+// путь - остаток после префикса. Заголовки из кэша, тело через sendfile
+// или кадрами DATA в HTTP/2
+int serverStatic(void *ctx, const HttpRequest *req);
+
+#endif
@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <string.h>
+#include "sse.h"
+
+static const char sseHeaders[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n"
+    "retry: 1000\n\n";
+
+bool sseSubscribe(Channel *ch, Connection *c)
+{
+    if (ch->count == ch->cap)
+        return false;
+
+    c->kind = CONN_SSE;
+    connQueue(c, sseHeaders, sizeof(sseHeaders) - 1, NULL);
+    return channelSubscribe(ch, c);
+}
+
+int ssePublish(Channel *ch, const char *event, const char *data)
+{
+    SharedBuf *buf = sharedBufNew(strlen(event) + strlen(data) + 48);
+
+    if (!buf)
+        return 0;
+    buf->len = sprintf(buf->data, "id: %lu\nevent: %s\ndata: %s\n\n", ch->seq + 1, event, data);
+    return channelPublish(ch, buf);
+}
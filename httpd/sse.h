@@ -0,0 +1,15 @@
+// Server-Sent Events (text/event-stream) поверх канала рассылки.
+// Браузерный EventSource при разрыве сам переподключится и получит
+// последнее событие канала.
+#ifndef HTTPD_SSE_H
+#define HTTPD_SSE_H
+
+#include "channel.h"
+
+// Отправляет заголовки потока и последнее событие, переводит соединение в CONN_SSE
+bool sseSubscribe(Channel *ch, Connection *c);
+
+// Рассылает событие всем подписчикам, возвращает число получателей
+int ssePublish(Channel *ch, const char *event, const char *data);
+
+#endif
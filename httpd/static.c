@@ -0,0 +1,378 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "http.h"
+#include "static.h"
+
+#define STATIC_BUCKETS 1024         // размер хеш-таблицы кэша
+#define STATIC_MAX_FILES 1024       // файлов в кэше, до 3 дескрипторов у каждого
+#define STATIC_MAX_PATH 256         // максимальная длина пути запроса
+#define STATIC_RECHECK_NS 1000000000 // как часто сверять кэш с диском
+
+enum
+{
+    VAR_PLAIN,
+    VAR_GZIP,
+    VAR_BR,
+    VAR_COUNT
+};
+
+static const char *const varSuffix[VAR_COUNT] = {"", ".gz", ".br"};
+static const char *const varEncoding[VAR_COUNT] = {"", "Content-Encoding: gzip\r\n", "Content-Encoding: br\r\n"};
+
+// Одно представление файла: исходное или сжатое
+typedef struct
+{
+    SharedBuf *buf;        // заголовки 200 и 304, buf->fd - открытый файл; NULL - нет файла
+    size_t len200, len304; // заголовки 304 лежат сразу за заголовками 200
+    off_t size;
+    const char *etag;      // указывает внутрь buf
+    size_t etagLen;
+    ino_t ino;             // для обнаружения замены файла
+    struct timespec mtime;
+} Variant;
+
+typedef struct StaticFile StaticFile;
+
+struct StaticFile
+{
+    StaticFile *next;
+    uint64_t hash;
+    size_t pathLen;
+    char path[STATIC_MAX_PATH];
+    long long checkedAt; // когда кэш последний раз сверялся с диском
+    long long usedAt;    // последний запрос - для вытеснения
+    Variant var[VAR_COUNT];
+};
+
+static int rootFd = -1;
+static StaticFile *buckets[STATIC_BUCKETS];
+static int fileCount;
+
+static const struct
+{
+    const char *ext;
+    const char *type;
+} contentTypes[] = {
+    {".html", "text/html; charset=utf-8"},
+    {".htm", "text/html; charset=utf-8"},
+    {".css", "text/css; charset=utf-8"},
+    {".js", "application/javascript; charset=utf-8"},
+    {".json", "application/json"},
+    {".txt", "text/plain; charset=utf-8"},
+    {".svg", "image/svg+xml"},
+    {".png", "image/png"},
+    {".jpg", "image/jpeg"},
+    {".jpeg", "image/jpeg"},
+    {".gif", "image/gif"},
+    {".ico", "image/x-icon"},
+    {".woff2", "font/woff2"},
+};
+
+static long long nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint64_t hashPath(const char *path, size_t len)
+{
+    uint64_t h = 14695981039346656037ULL; // FNV-1a
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)path[i]) * 1099511628211ULL;
+    return h;
+}
+
+static const char *contentType(const char *path, size_t len)
+{
+    for (size_t i = 0; i < sizeof(contentTypes) / sizeof(contentTypes[0]); i++)
+    {
+        size_t extLen = strlen(contentTypes[i].ext);
+        if (len > extLen && !strncasecmp(path + len - extLen, contentTypes[i].ext, extLen))
+            return contentTypes[i].type;
+    }
+    return "application/octet-stream";
+}
+
+// Путь в каталоге: без "..", обратных слешей и %-кодирования
+static bool safePath(const char *path, size_t len)
+{
+    if (!len || path[0] != '/' || len >= STATIC_MAX_PATH - 16)
+        return false;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (path[i] == '\\' || path[i] == '%' || path[i] == '\0')
+            return false;
+        if (path[i] == '.' && i > 0 && path[i - 1] == '/' && i + 1 < len && path[i + 1] == '.')
+            return false;
+    }
+    return true;
+}
+
+// Канонический путь в out: повторные "/" и сегменты "." убираются, так что
+// разные записи пути к одному файлу делят одну запись кэша, а не заводят
+// каждая свою с открытыми дескрипторами. Конечный "/" (каталог) остается
+static size_t canonicalPath(const char *path, size_t len, char *out)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < len;)
+    {
+        size_t end = i + 1, segLen;
+
+        while (end < len && path[end] != '/')
+            end++;
+        segLen = end - i - 1;
+        if (segLen && !(segLen == 1 && path[i + 1] == '.'))
+        {
+            out[n++] = '/';
+            memcpy(out + n, path + i + 1, segLen);
+            n += segLen;
+        }
+        else if (end == len && (!n || out[n - 1] != '/'))
+            out[n++] = '/';
+        i = end;
+    }
+    if (!n)
+        out[n++] = '/';
+    return n;
+}
+
+// Относительное имя файла представления в name
+static void variantName(const StaticFile *f, int var, char *name, size_t size)
+{
+    const char *rel = f->path + 1;
+    const char *index = (!*rel || f->path[f->pathLen - 1] == '/') ? "index.html" : "";
+
+    snprintf(name, size, "%s%s%s", rel, index, varSuffix[var]);
+}
+
+static void unloadVariant(Variant *v)
+{
+    sharedBufUnref(v->buf);
+    memset(v, 0, sizeof(*v));
+}
+
+static void loadVariant(StaticFile *f, int var)
+{
+    Variant *v = &f->var[var];
+    char name[STATIC_MAX_PATH + 16], lastModified[40], etag[48];
+    struct stat st;
+    struct tm tm;
+    SharedBuf *buf;
+    int fd;
+
+    unloadVariant(v);
+    variantName(f, var, name, sizeof(name));
+    fd = openat(rootFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || !(buf = sharedBufNew(640)))
+    {
+        close(fd);
+        return;
+    }
+
+    buf->fd = fd;
+    v->buf = buf;
+    v->size = st.st_size;
+    v->ino = st.st_ino;
+    v->mtime = st.st_mtim;
+    gmtime_r(&st.st_mtime, &tm);
+    strftime(lastModified, sizeof(lastModified), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+    // Сильный ETag: размер, время изменения и кодирование представления
+    v->etagLen = sprintf(etag, "\"%llx-%llx%s%s\"", (long long)st.st_size,
+                         (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec,
+                         var == VAR_PLAIN ? "" : "-", var == VAR_PLAIN ? "" : varSuffix[var] + 1);
+    v->len200 = sprintf(buf->data,
+                        "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: %s\r\n"
+                        "Content-Length: %lld\r\n"
+                        "Last-Modified: %s\r\n"
+                        "Vary: Accept-Encoding\r\n"
+                        "%s"
+                        "ETag: %s\r\n",
+                        contentType(f->path, f->pathLen), (long long)st.st_size, lastModified,
+                        varEncoding[var], etag);
+    v->etag = buf->data + v->len200 - 2 - v->etagLen;
+    v->len304 = sprintf(buf->data + v->len200,
+                        "HTTP/1.1 304 Not Modified\r\n"
+                        "Vary: Accept-Encoding\r\n"
+                        "ETag: %s\r\n",
+                        etag);
+    buf->len = v->len200 + v->len304;
+}
+
+// Изменился ли файл представления с момента загрузки
+static bool variantChanged(const StaticFile *f, int var)
+{
+    const Variant *v = &f->var[var];
+    char name[STATIC_MAX_PATH + 16];
+    struct stat st;
+
+    variantName(f, var, name, sizeof(name));
+    if (fstatat(rootFd, name, &st, 0) < 0 || !S_ISREG(st.st_mode))
+        return v->buf != NULL;
+    return !v->buf || st.st_ino != v->ino || st.st_size != v->size ||
+           st.st_mtim.tv_sec != v->mtime.tv_sec || st.st_mtim.tv_nsec != v->mtime.tv_nsec;
+}
+
+static void freeFile(StaticFile *f)
+{
+    for (int var = 0; var < VAR_COUNT; var++)
+        unloadVariant(&f->var[var]);
+    free(f);
+    fileCount--;
+}
+
+// Место для нового файла: дольше всех не запрошенный уходит из кэша.
+// Перебор всего кэша - только на холодном пути, рядом с открытием файлов
+static void evictOldest(void)
+{
+    StaticFile **oldest = NULL, *f;
+
+    for (int i = 0; i < STATIC_BUCKETS; i++)
+        for (StaticFile **slot = &buckets[i]; *slot; slot = &(*slot)->next)
+            if (!oldest || (*slot)->usedAt < (*oldest)->usedAt)
+                oldest = slot;
+    if (!oldest)
+        return;
+    f = *oldest;
+    *oldest = f->next;
+    freeFile(f);
+}
+
+// Совпадает ли один из ETag в If-None-Match (сравнение слабое)
+static bool etagMatches(const char *value, size_t len, const Variant *v)
+{
+    const char *end = value + len;
+
+    while (value && value < end)
+    {
+        const char *comma = memchr(value, ',', end - value);
+        const char *itemEnd = comma ? comma : end;
+
+        while (value < itemEnd && *value == ' ')
+            value++;
+        while (itemEnd > value && itemEnd[-1] == ' ')
+            itemEnd--;
+        if (itemEnd - value >= 2 && !memcmp(value, "W/", 2))
+            value += 2;
+        if ((itemEnd - value == 1 && *value == '*') ||
+            ((size_t)(itemEnd - value) == v->etagLen && !memcmp(value, v->etag, v->etagLen)))
+            return true;
+        value = comma ? comma + 1 : NULL;
+    }
+    return false;
+}
+
+bool staticInit(const char *root)
+{
+    if (rootFd >= 0)
+        close(rootFd);
+    rootFd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return rootFd >= 0;
+}
+
+int staticServe(const char *path, size_t pathLen,
+                const char *acceptEncoding, size_t acceptEncodingLen,
+                const char *ifNoneMatch, size_t ifNoneMatchLen,
+                StaticReply *reply)
+{
+    const char *query = memchr(path, '?', pathLen);
+    char canon[STATIC_MAX_PATH];
+    StaticFile **slot, *f;
+    uint64_t hash;
+    long long now = nowNs();
+    Variant *v;
+
+    memset(reply, 0, sizeof(*reply));
+    if (query)
+        pathLen = query - path;
+    if (rootFd < 0 || !safePath(path, pathLen))
+        return reply->status = 403;
+
+    pathLen = canonicalPath(path, pathLen, canon);
+    path = canon;
+    hash = hashPath(path, pathLen);
+    for (slot = &buckets[hash % STATIC_BUCKETS]; (f = *slot); slot = &f->next)
+        if (f->hash == hash && f->pathLen == pathLen && !memcmp(f->path, path, pathLen))
+            break;
+
+    if (!f)
+    {
+        // Холодный путь: открываем файл и его сжатые копии, готовим заголовки
+        if (!(f = calloc(1, sizeof(StaticFile))))
+            return reply->status = 404;
+        fileCount++;
+        f->hash = hash;
+        f->pathLen = pathLen;
+        memcpy(f->path, path, pathLen);
+        for (int var = 0; var < VAR_COUNT; var++)
+            loadVariant(f, var);
+        if (!f->var[VAR_PLAIN].buf)
+        {
+            freeFile(f);
+            return reply->status = 404;
+        }
+        if (fileCount > STATIC_MAX_FILES)
+            evictOldest();
+        f->checkedAt = now;
+        f->next = buckets[hash % STATIC_BUCKETS];
+        buckets[hash % STATIC_BUCKETS] = f;
+    }
+    else if (now - f->checkedAt >= STATIC_RECHECK_NS)
+    {
+        f->checkedAt = now;
+        for (int var = 0; var < VAR_COUNT; var++)
+            if (variantChanged(f, var))
+                loadVariant(f, var);
+        if (!f->var[VAR_PLAIN].buf)
+        {
+            *slot = f->next;
+            freeFile(f);
+            return reply->status = 404;
+        }
+    }
+
+    f->usedAt = now;
+    v = &f->var[VAR_PLAIN];
+    if (acceptEncoding && f->var[VAR_BR].buf && httpAcceptsEncoding(acceptEncoding, acceptEncodingLen, "br"))
+        v = &f->var[VAR_BR];
+    else if (acceptEncoding && f->var[VAR_GZIP].buf && httpAcceptsEncoding(acceptEncoding, acceptEncodingLen, "gzip"))
+        v = &f->var[VAR_GZIP];
+
+    reply->owner = v->buf;
+    if (ifNoneMatch && etagMatches(ifNoneMatch, ifNoneMatchLen, v))
+    {
+        reply->head = v->buf->data + v->len200;
+        reply->headLen = v->len304;
+        return reply->status = 304;
+    }
+    reply->head = v->buf->data;
+    reply->headLen = v->len200;
+    reply->bodyLen = v->size;
+    return reply->status = 200;
+}
+
+void staticFlush(void)
+{
+    for (int i = 0; i < STATIC_BUCKETS; i++)
+    {
+        while (buckets[i])
+        {
+            StaticFile *f = buckets[i];
+            buckets[i] = f->next;
+            freeFile(f);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+// Раздача статических файлов из каталога.
+// Для каждого файла кэшируются открытый дескриптор, ETag, Last-Modified и
+// готовые заголовки ответов 200 и 304 для исходного файла и его сжатых
+// копий name.br / name.gz. Кэш сверяется с диском не чаще раза в секунду,
+// поэтому If-None-Match обычно обслуживается без обращения к файлу.
+// Ключ кэша - канонический путь; файлов в кэше не больше STATIC_MAX_FILES,
+// сверх того вытесняется дольше всех не запрошенный.
+#ifndef HTTPD_STATIC_H
+#define HTTPD_STATIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "buf.h"
+
+// Ответ на запрос файла
+typedef struct
+{
+    int status;       // 200, 304, 403 или 404
+    SharedBuf *owner; // держит заголовки и открытый файл (owner->fd)
+    const char *head; // строка статуса и заголовки без завершающей пустой строки
+    size_t headLen;
+    size_t bodyLen;   // длина тела (0 для 304)
+} StaticReply;
+
+// Каталог с файлами; false, если его нельзя открыть
+bool staticInit(const char *root);
+
+// Находит файл по пути запроса (без префикса маршрута).
+// acceptEncoding и ifNoneMatch - значения заголовков или NULL
+int staticServe(const char *path, size_t pathLen,
+                const char *acceptEncoding, size_t acceptEncodingLen,
+                const char *ifNoneMatch, size_t ifNoneMatchLen,
+                StaticReply *reply);
+
+// Сбрасывает кэш метаданных (для замеров холодного старта)
+void staticFlush(void);
+
+#endif
@@ -0,0 +1,91 @@
+#include <time.h>
+#include "timer.h"
+
+#define TIMER_SLOTS 512 // один оборот колеса - 51.2 с, степень двойки
+
+static Timer slots[TIMER_SLOTS]; // голова кольцевого списка каждой ячейки
+static uint64_t doneTick;        // последний обработанный шаг
+static bool started;
+static int activeCount;
+
+uint64_t timerNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static void timerStart(uint64_t now)
+{
+    for (int i = 0; i < TIMER_SLOTS; i++)
+        slots[i].prev = slots[i].next = &slots[i];
+    doneTick = now / TIMER_TICK_MS;
+    started = true;
+}
+
+void timerAdd(Timer *t, uint64_t expires)
+{
+    uint64_t tick = expires / TIMER_TICK_MS;
+    Timer *head;
+
+    if (!started)
+        timerStart(timerNow());
+    timerCancel(t);
+    if (!activeCount)
+        doneTick = timerNow() / TIMER_TICK_MS; // колесо стояло без таймеров
+    if (tick <= doneTick)
+        tick = doneTick + 1; // уже пройденный шаг - сработает на ближайшем
+    head = &slots[tick & (TIMER_SLOTS - 1)];
+    t->expires = expires;
+    t->next = head;
+    t->prev = head->prev;
+    head->prev->next = t;
+    head->prev = t;
+    activeCount++;
+}
+
+void timerCancel(Timer *t)
+{
+    if (!t->next)
+        return;
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->prev = t->next = NULL;
+    activeCount--;
+}
+
+int timerRun(uint64_t now)
+{
+    uint64_t nowTick = now / TIMER_TICK_MS;
+    int fired = 0;
+
+    if (!started)
+        return 0;
+    while (doneTick < nowTick)
+    {
+        Timer *head = &slots[++doneTick & (TIMER_SLOTS - 1)];
+        Timer *t = head->next;
+
+        // В ячейке лежат и таймеры следующих оборотов колеса
+        while (t != head)
+        {
+            Timer *next = t->next;
+
+            if (t->expires / TIMER_TICK_MS <= doneTick)
+            {
+                timerCancel(t);
+                t->fire(t);
+                fired++;
+            }
+            t = next;
+        }
+    }
+    return fired;
+}
+
+int timerWait(uint64_t now)
+{
+    if (!activeCount)
+        return -1;
+    return (doneTick + 1) * TIMER_TICK_MS > now ? (int)((doneTick + 1) * TIMER_TICK_MS - now) : 0;
+}
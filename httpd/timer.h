@@ -0,0 +1,41 @@
+// Колесо таймеров для сроков соединений.
+// Таймер встраивается в структуру владельца и попадает в ячейку колеса
+// по времени срабатывания; добавление и отмена - O(1), за шаг колеса
+// просматривается одна ячейка. Точность - TIMER_TICK_MS.
+#ifndef HTTPD_TIMER_H
+#define HTTPD_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMER_TICK_MS 100
+
+typedef struct Timer Timer;
+
+struct Timer
+{
+    uint64_t expires;          // время срабатывания, мс CLOCK_MONOTONIC
+    Timer *prev, *next;        // NULL, если таймер не взведен
+    void (*fire)(Timer *t);
+};
+
+// Текущее время в мс (CLOCK_MONOTONIC)
+uint64_t timerNow(void);
+
+// Взводит (или переносит) таймер на момент expires
+void timerAdd(Timer *t, uint64_t expires);
+
+void timerCancel(Timer *t);
+
+static inline bool timerActive(const Timer *t)
+{
+    return t->next != NULL;
+}
+
+// Вызывает fire у всех истекших таймеров, возвращает их число
+int timerRun(uint64_t now);
+
+// Таймаут для epoll_wait: мс до следующего шага колеса или -1, если таймеров нет
+int timerWait(uint64_t now);
+
+#endif
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <string.h>
+#include "http.h"
+#include "ws.h"
+
+static const char wsGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static uint32_t rol(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+// SHA-1 для ключа рукопожатия (сообщение короче одного блока с дополнением)
+static void sha1(const uint8_t *msg, size_t len, uint8_t digest[20])
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t block[128] = {0};
+    size_t total = len + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+
+    memcpy(block, msg, len);
+    block[len] = 0x80;
+    for (int i = 0; i < 8; i++)
+        block[total - 1 - i] = bits >> (8 * i);
+
+    for (size_t off = 0; off < total; off += 64)
+    {
+        uint32_t w[80], a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t)block[off + 4 * i] << 24 | (uint32_t)block[off + 4 * i + 1] << 16 |
+                   (uint32_t)block[off + 4 * i + 2] << 8 | block[off + 4 * i + 3];
+        for (int i = 16; i < 80; i++)
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        for (int i = 0; i < 80; i++)
+        {
+            uint32_t f, k, t;
+            if (i < 20)
+                f = (b & c) | (~b & d), k = 0x5A827999;
+            else if (i < 40)
+                f = b ^ c ^ d, k = 0x6ED9EBA1;
+            else if (i < 60)
+                f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+            else
+                f = b ^ c ^ d, k = 0xCA62C1D6;
+            t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 20; i++)
+        digest[i] = h[i / 4] >> (24 - 8 * (i % 4));
+}
+
+static size_t base64(const uint8_t *in, size_t len, char *out)
+{
+    static const char abc[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t v = (uint32_t)in[i] << 16 | (i + 1 < len ? in[i + 1] << 8 : 0) | (i + 2 < len ? in[i + 2] : 0);
+        out[n++] = abc[v >> 18 & 63];
+        out[n++] = abc[v >> 12 & 63];
+        out[n++] = i + 1 < len ? abc[v >> 6 & 63] : '=';
+        out[n++] = i + 2 < len ? abc[v & 63] : '=';
+    }
+    out[n] = '\0';
+    return n;
+}
+
+bool wsHandshake(Connection *c, const char *req, size_t reqLen)
+{
+    const char *upgrade, *connection, *version, *key;
+    size_t upgradeLen, connectionLen, versionLen, keyLen;
+    uint8_t input[64], digest[20];
+    char accept[32];
+    char *resp;
+    int respLen;
+
+    upgrade = httpHeader(req, reqLen, "Upgrade", &upgradeLen);
+    connection = httpHeader(req, reqLen, "Connection", &connectionLen);
+    version = httpHeader(req, reqLen, "Sec-WebSocket-Version", &versionLen);
+    key = httpHeader(req, reqLen, "Sec-WebSocket-Key", &keyLen);
+    if (!upgrade || !httpHasToken(upgrade, upgradeLen, "websocket") ||
+        !connection || !httpHasToken(connection, connectionLen, "Upgrade") ||
+        !version || versionLen != 2 || memcmp(version, "13", 2) ||
+        !key || keyLen + sizeof(wsGuid) - 1 > sizeof(input))
+        return false;
+
+    memcpy(input, key, keyLen);
+    memcpy(input + keyLen, wsGuid, sizeof(wsGuid) - 1);
+    sha1(input, keyLen + sizeof(wsGuid) - 1, digest);
+    base64(digest, sizeof(digest), accept);
+
+    resp = arenaAlloc(&c->arena, 160);
+    if (!resp)
+        return false;
+    respLen = sprintf(resp,
+                        "HTTP/1.1 101 Switching Protocols\r\n"
+                        "Upgrade: websocket\r\n"
+                        "Connection: Upgrade\r\n"
+                        "Sec-WebSocket-Accept: %s\r\n"
+                        "\r\n",
+                        accept);
+    connQueue(c, resp, respLen, NULL);
+    return true;
+}
+
+// Снятие маски: 8 байт за шаг, маска размножена на слово
+static void wsUnmask(uint8_t *p, size_t len, const uint8_t key[4])
+{
+    uint8_t keyWord[8];
+    uint64_t mask, word;
+    size_t i = 0;
+
+    memcpy(keyWord, key, 4);
+    memcpy(keyWord + 4, key, 4);
+    memcpy(&mask, keyWord, 8);
+    for (; i + 8 <= len; i += 8)
+    {
+        memcpy(&word, p + i, 8);
+        word ^= mask;
+        memcpy(p + i, &word, 8);
+    }
+    for (; i < len; i++)
+        p[i] ^= key[i & 3];
+}
+
+long wsParseFrame(uint8_t *buf, size_t len, WsFrame *f)
+{
+    size_t payloadLen, head;
+
+    // Быстрый путь: замаскированный кадр с длиной до 125 байт
+    if (len >= 6 && (buf[1] & 0x80) && (buf[1] & 0x7F) < 126)
+    {
+        payloadLen = buf[1] & 0x7F;
+        head = 6;
+    }
+    else
+    {
+        if (len < 2)
+            return 0;
+        if (!(buf[1] & 0x80))
+            return -1; // кадры клиента обязаны быть замаскированы
+        payloadLen = buf[1] & 0x7F;
+        head = 2;
+        if (payloadLen == 126)
+        {
+            if (len < 4)
+                return 0;
+            payloadLen = (size_t)buf[2] << 8 | buf[3];
+            head = 4;
+        }
+        else if (payloadLen == 127)
+        {
+            if (len < 10)
+                return 0;
+            payloadLen = 0;
+            for (int i = 2; i < 10; i++)
+                payloadLen = payloadLen << 8 | buf[i];
+            head = 10;
+        }
+        if (len < head + 4)
+            return 0;
+        head += 4;
+    }
+
+    if (payloadLen > len - head)
+        return 0;
+    f->fin = buf[0] & 0x80;
+    f->opcode = buf[0] & 0x0F;
+    f->payload = buf + head;
+    f->len = payloadLen;
+    if ((buf[0] & 0x70) || (f->opcode >= WS_OP_CLOSE && (!f->fin || payloadLen > 125)))
+        return -1;
+    wsUnmask(f->payload, payloadLen, buf + head - 4);
+    return head + payloadLen;
+}
+
+size_t wsEncode(uint8_t *out, int opcode, const void *payload, size_t len)
+{
+    size_t head = 2;
+
+    out[0] = (uint8_t)(0x80 | opcode);
+    if (len < 126)
+    {
+        out[1] = (uint8_t)len;
+    }
+    else if (len <= 0xFFFF)
+    {
+        out[1] = 126;
+        out[2] = (uint8_t)(len >> 8);
+        out[3] = (uint8_t)len;
+        head = 4;
+    }
+    else
+    {
+        out[1] = 127;
+        for (int i = 0; i < 8; i++)
+            out[2 + i] = (uint8_t)((uint64_t)len >> (56 - 8 * i));
+        head = 10;
+    }
+    memcpy(out + head, payload, len);
+    return head + len;
+}
+
+SharedBuf *wsFrame(int opcode, const void *payload, size_t len)
+{
+    SharedBuf *buf = sharedBufNew(len + 10);
+
+    if (!buf)
+        return NULL;
+    buf->len = wsEncode((uint8_t *)buf->data, opcode, payload, len);
+    return buf;
+}
+
+void wsQueue(Connection *c, int opcode, const void *payload, size_t len)
+{
+    uint8_t *frame = arenaAlloc(&c->arena, len + 10);
+
+    if (!frame || !connQueue(c, (char *)frame, wsEncode(frame, opcode, payload, len), NULL))
+        c->closeAfterWrite = true;
+}
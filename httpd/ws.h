@@ -0,0 +1,45 @@
+// WebSocket (RFC 6455): рукопожатие и кадры.
+// Кадры клиента всегда замаскированы; короткие кадры (до 125 байт)
+// разбираются быстрым путем, маска снимается словами по 8 байт.
+#ifndef HTTPD_WS_H
+#define HTTPD_WS_H
+
+#include <stdint.h>
+#include "conn.h"
+
+enum
+{
+    WS_OP_CONT = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+};
+
+typedef struct
+{
+    int opcode;
+    bool fin;
+    uint8_t *payload; // уже без маски, указывает в буфер разбора
+    size_t len;
+} WsFrame;
+
+// Проверяет заголовки Upgrade и ставит в очередь ответ 101 Switching Protocols
+bool wsHandshake(Connection *c, const char *req, size_t reqLen);
+
+// Разбирает кадр клиента, снимая маску на месте:
+// >0 - длина кадра, 0 - кадр пришел не целиком, -1 - ошибка протокола
+long wsParseFrame(uint8_t *buf, size_t len, WsFrame *f);
+
+// Кадр сервера (без маски) в out размером не меньше len + 10; возвращает длину
+size_t wsEncode(uint8_t *out, int opcode, const void *payload, size_t len);
+
+// Готовый кадр сервера (без маски) в новом SharedBuf
+SharedBuf *wsFrame(int opcode, const void *payload, size_t len);
+
+// Ставит в очередь одноразовый кадр из арены соединения; при
+// переполнении очереди соединение закрывается после отправки
+void wsQueue(Connection *c, int opcode, const void *payload, size_t len);
+
+#endif
@@ -1,124 +1,781 @@
-
+// Веб-сервер с кнопками ON/OFF и REST API для платы до 64 реле на цикле
+// epoll httpd/server: страница, /relay/..., события /events и /ws, /metrics
+// и файлы каталога argv[1] (по умолчанию www) по /static/; HTTP/1.1 и h2c.
+// Настройки - переменные окружения BUTTON_* (см. main()), команды - строки на stdin.
+// Сборка: gcc -O2 -pthread -o button hw3.3_button.c httpd/*.c gpio/*.c
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/resource.h>
+#include <time.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include "httpd/accesslog.h"
+#include "httpd/conn.h"
+#include "httpd/head.h"
+#include "httpd/http.h"
+#include "httpd/metrics.h"
+#include "httpd/sse.h"
+#include "httpd/static.h"
+#include "httpd/pool.h"
+#include "httpd/ratelimit.h"
+#include "httpd/router.h"
+#include "httpd/server.h"
+#include "httpd/ws.h"
+#include "gpio/gpio.h"
+#include "pages/button_html.h"
+
+#define MAX_SUBSCRIBERS 65536  // максимум подписчиков /events и /ws
+#define MAX_JOBS 1024          // одновременных переключений реле в пуле
+#define DEFAULT_WORKERS 4
+#define DEFAULT_MAX_WAITING SERVER_MAX_WAITING
+#define DEFAULT_RELAYS 8         // реле в имитации
+#define DEFAULT_RATE 20          // запросов в секунду с одного адреса
+#define DEFAULT_CONN_RATE 10     // новых соединений в секунду с одного адреса
+#define DEFAULT_WS_RATE 200      // команд /ws в секунду с одного адреса
+
+static uint64_t relayState;     // разосланное состояние реле, бит на реле
+static uint64_t relayAll;       // маска всех реле платы
+static Channel relayEvents;     // подписчики /events
+static Channel relaySockets;    // подписчики /ws
 
-int main()
+// Переключение реле в пуле потоков; соединение ждет ответа с busy == true
+typedef struct RelayJob RelayJob;
+
+struct RelayJob
 {
+    PoolTask task;   // первое поле: задача пула приводится к RelayJob
+    Connection *c;
+    unsigned gen;    // c->gen на момент запроса; иначе соединение уже другое
+    uint64_t set;    // включаемые реле
+    uint64_t clear;  // выключаемые реле
+    int reply;       // JOB_PAGE, JOB_PAGE_GZIP или JOB_JSON
+    bool ok;         // результат записи в GPIO
+    uint64_t start;
+    unsigned stream; // поток HTTP/2, которому нужен ответ
+    char method[8];
+    char path[34];
+    RelayJob *nextFree;
+};
 
-    int server;  //файл-дескриптор сервера
-    int client;  //файл-дескриптор клиента 
-    int portNum = 8000;  //номера порта (0 до 65535)
-    bool isExit = false;  //признак завершения программы.
-    int bufsize = 1024;  //размер буффера
-    char buffer[bufsize]; //буффер обмена для приема/отправки данных к/от сервера
+// Ответ на переключение реле
+enum
+{
+    JOB_PAGE,      // страница
+    JOB_PAGE_GZIP, // страница в gzip
+    JOB_JSON       // состояние в JSON
+};
 
-    struct sockaddr_in server_addr;
-    socklen_t size;
-    
-    server = socket(AF_INET, SOCK_STREAM, 0);
-    printf("SERVER\n");
+static RelayJob jobs[MAX_JOBS];
+static RelayJob *freeJobs;
 
-    if (server < 0) 
-    {
-        printf("Error establishing socket...\n");
-        exit(1);
-    }
-	
-	printf("=> Socket server has been created...\n");
+// Метрики: запросы по кодам ответа (последний - прочие), задержки, GPIO
+static const struct
+{
+    int status;
+    const char *labels;
+} statusLabels[] = {
+    {101, "status=\"101\""}, {200, "status=\"200\""}, {304, "status=\"304\""},
+    {400, "status=\"400\""}, {403, "status=\"403\""}, {404, "status=\"404\""}, {413, "status=\"413\""},
+    {429, "status=\"429\""}, {500, "status=\"500\""}, {503, "status=\"503\""}, {0, "status=\"other\""},
+};
 
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = htons(INADDR_ANY);
-    server_addr.sin_port = htons(portNum);
+static const uint64_t latencyBoundsUs[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000, 250000, 1000000};
 
+static HttpServer server;
+static RateLimiter requestLimit, connectLimit, frameLimit;
 
-    if ((bind(server, (struct sockaddr*)&server_addr,sizeof(server_addr))) < 0) 
+static int requestMetrics[sizeof(statusLabels) / sizeof(statusLabels[0])];
+static int latencyMetric, gpioOkMetric, gpioErrorMetric, gpioLatencyMetric, wsFrameMetric;
+static int publishMetric, notifiedMetric;
+
+// Кадры /ws: команда клиента - один байт, WS_CMD_MASK - еще 8 байт set и 8 байт clear
+// (little-endian); состояние - [WS_MSG_STATE, реле 0, 8 байт маски]
+enum
+{
+    WS_CMD_OFF = 0x00,
+    WS_CMD_ON = 0x01,
+    WS_CMD_STATE = 0x02,
+    WS_CMD_MASK = 0x03,
+    WS_MSG_STATE = 0x01
+};
+
+static void putLe64(uint8_t *out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint64_t getLe64(const uint8_t *in)
+{
+    uint64_t value = 0;
+
+    for (int i = 0; i < 8; i++)
+        value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+// Рассылка нового состояния реле всем подписчикам; время рассылки и
+// число уведомлений - в /metrics
+static void publishRelays(uint64_t state)
+{
+    uint64_t start = accessLogNow();
+    uint8_t message[10] = {WS_MSG_STATE, state & 1};
+    char mask[24];
+    SharedBuf *frame;
+    int delivered;
+
+    relayState = state;
+    snprintf(mask, sizeof(mask), "0x%016llx", (unsigned long long)state);
+    delivered = ssePublish(&relayEvents, "relays", mask);
+    putLe64(message + 2, state);
+    if ((frame = wsFrame(WS_OP_BINARY, message, sizeof(message))))
+        delivered += channelPublish(&relaySockets, frame);
+    metricAdd(notifiedMetric, delivered);
+    metricObserve(publishMetric, (accessLogNow() - start) / 1000);
+}
+
+// Страница собрана из pages/button.html вместе с gzip-вариантом
+// (tools/gzip_embed); сжатая отдается, если клиент принимает gzip
+static void queuePage(Connection *c, bool gzip)
+{
+    if (gzip)
+        replyQueue(c, HEAD_OK_HTML_GZIP, (const char *)pageGzip, sizeof(pageGzip), NULL);
+    else
+        replyQueue(c, HEAD_OK_HTML, page, sizeof(page) - 1, NULL);
+}
+
+// Примет ли клиент страницу в gzip
+static bool acceptsGzip(const HttpRequest *req)
+{
+    size_t len;
+    const char *value = httpField(req->headers, req->headerCount, "Accept-Encoding", &len);
+
+    return value && httpAcceptsEncoding(value, len, "gzip");
+}
+
+// Состояние реле в JSON; буфер в арене соединения
+static void queueRelayState(Connection *c, uint64_t state)
+{
+    char *body = arenaAlloc(&c->arena, 64);
+    int bodyLen;
+
+    if (!body)
     {
-        printf("=> Error binding connection, the socket has already been established...\n");
-        return -1;
+        replyQueueError(c, HEAD_UNAVAILABLE);
+        return;
     }
+    bodyLen = sprintf(body, "{\"relays\":%d,\"state\":\"0x%016llx\"}\n", gpioCount(), (unsigned long long)state);
+    replyQueue(c, HEAD_OK_JSON, body, bodyLen, NULL);
+}
 
-    size = sizeof(server_addr);
-    printf("=> Looking for clients...\n");
+static void queueSocketState(Connection *c);
 
-   
-    listen(server, 1);
+// Учет завершенного запроса в метриках и журнале доступа
+static void logRequest(HttpServer *s, Connection *c, const char *method, const char *path, int status,
+                       size_t bytes, uint64_t start)
+{
+    int i = 0;
 
-    int clientCount = 1;
-    
-    
-    while(!isExit)
-    {
-        client = accept(server,(struct sockaddr *)&server_addr,&size);
+    (void)s;
 
-        if (client < 0) 
-            printf("=> Error on accepting...");
+    while (statusLabels[i].status && statusLabels[i].status != status)
+        i++;
+    metricAdd(requestMetrics[i], 1);
+    metricObserve(latencyMetric, (accessLogNow() - start) / 1000);
+    accessLog(c->addr.sin_addr.s_addr, method, path, strlen(path), status, bytes, start);
+}
 
-        if(client > 0) 
+// Выполняется в рабочем потоке
+static void relayRun(PoolTask *t)
+{
+    RelayJob *job = (RelayJob *)t;
+    uint64_t start = accessLogNow();
+
+    job->ok = gpioUpdate(job->set, job->clear);
+    metricAdd(job->ok ? gpioOkMetric : gpioErrorMetric, 1);
+    metricObserve(gpioLatencyMetric, (accessLogNow() - start) / 1000);
+}
+
+// Выполняется в цикле epoll после записи в GPIO
+static void relayDone(PoolTask *t)
+{
+    RelayJob *job = (RelayJob *)t;
+    Connection *c = job->c;
+
+    // Рабочие могли завершить записи не в том порядке, в каком пришли сюда
+    if (job->ok || gpioState() != relayState)
+        publishRelays(gpioState());
+
+    // Сессия HTTP/2 не занята целиком: ответа ждет только поток job->stream
+    if (c->fd >= 0 && c->gen == job->gen && (c->busy || c->kind == CONN_H2))
+    {
+        c->busy = false;
+        c->stream = job->stream;
+        if (c->kind == CONN_WS)
         {
-            printf("=> Connected with the client %d, you are good to go...\n",clientCount);
+            // при успехе новое состояние уже разослано всем подписчикам
+            if (!job->ok)
+                queueSocketState(c);
+        }
+        else
+        {
+            size_t queued = c->queuedBytes;
 
-            int result = recv(client, buffer, bufsize, 0);
-            if (result < 0)
+            if (job->ok && job->reply == JOB_JSON)
             {
-                printf("\n\n=> Connection terminated error %d  with IP %s\n",result,inet_ntoa(server_addr.sin_addr));   
-                close(client);
-                exit(1);
+                queueRelayState(c, gpioState());
             }
-
-            buffer[result] = '\0';               
-            char response[1024] = "HTTP/1.1 200 OK\r\n"
-                "Version: HTTP/1.1\r\n"
-                "Content-Type: text/html; charset=utf-8\r\n"
-                "\r\n\r\n"
-                    "<!DOCTYPE HTML>"
-                    "<html>"
-                    "  <head>"
-                    "    <meta name=\"viewport\" content=\"width=device-width,"
-                    "    initial-scale=1\">"
-                    "  </head>"
-                    "  <h1>OrangePI - Web Server</h1>"
-                    "  <p>Buttons"
-                    "    <a href=\"ON\">"
-                    "      <button>ON</button>"
-                    "    </a>&nbsp;"
-                    "    <a href=\"OFF\">"
-                    "      <button>OFF</button>"
-                    "    </a>"
-                    "  </p>";
-            strcat(response,"</html>");
-            printf("%s\n",buffer);
-            char* get_str_on = strstr(buffer, "/ON");
-            char* get_str_off = strstr(buffer, "/OFF");
-            if (get_str_on)
+            else if (job->ok)
             {
-                printf("%s\n", get_str_on);
+                queuePage(c, job->reply == JOB_PAGE_GZIP);
             }
-            if (get_str_off)
+            else
             {
-                printf("%s\n", get_str_off);
+                replyQueue(c, HEAD_INTERNAL_ERROR, NULL, 0, NULL);
             }
-            
-            send(client, response,strlen(response), 0);
-            printf("\n\n=> Connection terminated with IP %s\n",inet_ntoa(server_addr.sin_addr));   
-            close(client);
-            printf("\n=> Press any key and <Enter>, # to end the connection\n");
-            char c;
-            while((c=getchar())!='\n')
-                if(c=='#')
-                {
-                    isExit=true;                 
-                }
+            logRequest(&server, c, job->method, job->path, job->ok ? 200 : 500,
+                       c->kind == CONN_H2 ? c->streamBytes : c->queuedBytes - queued, job->start);
+        }
+        serverResume(&server, c);
+    }
+    job->nextFree = freeJobs;
+    freeJobs = job;
+}
+
+// Отдает изменение реле пулу; false, если свободных задач нет
+static bool submitRelay(Connection *c, uint64_t set, uint64_t clear, int reply,
+                        const char *method, const char *path)
+{
+    RelayJob *job = freeJobs;
+
+    if (!job)
+        return false;
+    freeJobs = job->nextFree;
+    job->task.run = relayRun;
+    job->task.done = relayDone;
+    job->c = c;
+    job->gen = c->gen;
+    job->set = set;
+    job->clear = clear;
+    job->reply = reply;
+    job->start = accessLogNow();
+    job->stream = c->stream;
+    snprintf(job->method, sizeof(job->method), "%s", method);
+    snprintf(job->path, sizeof(job->path), "%s", path);
+    c->busy = c->kind != CONN_H2; // потоки HTTP/2 ждут ответов независимо
+    poolSubmit(&job->task);
+    return true;
+}
+
+// Счетчики запросов, задержек и GPIO в формате Prometheus; текст
+// собирается из сегментов потоков в момент запроса
+static int serveMetrics(void *ctx, const HttpRequest *req)
+{
+    HttpExchange *x = ctx;
+    Connection *c = x->conn;
+    SharedBuf *body = metricsRender();
+
+    (void)req;
+
+    if (!body)
+    {
+        replyQueueError(c, HEAD_UNAVAILABLE);
+        return 503;
+    }
+    replyQueue(c, HEAD_OK_METRICS, body->data, body->len, body);
+    sharedBufUnref(body);
+    return 200;
+}
+
+// Маска реле из аргумента name; false, если его нет или он задает лишние реле
+static bool relayArg(const HttpRequest *req, const char *name, uint64_t *mask)
+{
+    size_t len;
+    const char *value = httpField(req->args, req->argCount, name, &len);
+    char *end;
+
+    if (!value || !len)
+        return false;
+    errno = 0;
+    *mask = strtoull(value, &end, 0);
+    return !*end && !errno && !(*mask & ~relayAll);
+}
+
+// /relay/...: одно реле, маска целиком или набор реле одним запросом -
+// /relay/<n>/on, /relay/<n>/off, /relay/mask (состояние или ?value=),
+// /relay/set?mask= и /relay/clear?mask=. Любое изменение - одна запись порта
+static int routeRelay(void *ctx, const HttpRequest *req)
+{
+    HttpExchange *x = ctx;
+    Connection *c = x->conn;
+    const char *rest = req->path + 7;
+    uint64_t set = 0, clear = 0, value = 0;
+    bool valid = true;
+
+    if (!strcmp(rest, "mask"))
+    {
+        // без аргументов - только чтение; value - новое состояние целиком
+        if (!req->argCount)
+        {
+            queueRelayState(c, gpioState());
+            return 200;
+        }
+        valid = relayArg(req, "value", &value);
+        set = value;
+        clear = relayAll & ~value;
+    }
+    else if (!strcmp(rest, "set"))
+    {
+        valid = relayArg(req, "mask", &set);
+    }
+    else if (!strcmp(rest, "clear"))
+    {
+        valid = relayArg(req, "mask", &clear);
+    }
+    else
+    {
+        char *end;
+        unsigned long id = strtoul(rest, &end, 10);
+
+        if (end == rest || id >= (unsigned long)gpioCount() || (strcmp(end, "/on") && strcmp(end, "/off")))
+        {
+            replyQueue(c, HEAD_NOT_FOUND, NULL, 0, NULL);
+            return 404;
+        }
+        if (!strcmp(end, "/on"))
+            set = 1ULL << id;
+        else
+            clear = 1ULL << id;
+    }
+
+    if (!valid)
+    {
+        replyQueueError(c, HEAD_BAD_REQUEST);
+        return 400;
+    }
+    if (submitRelay(c, set, clear, JOB_JSON, req->method, req->path))
+        return 0;
+    replyQueueError(c, HEAD_UNAVAILABLE);
+    return 503;
+}
+
+// Подписка на поток событий /events (Server-Sent Events): состояние реле
+// рассылается браузерам при каждом изменении
+static int routeEvents(void *ctx, const HttpRequest *req)
+{
+    HttpExchange *x = ctx;
+    Connection *c = x->conn;
+
+    (void)req;
+    // Подписки держат соединение целиком и в поток HTTP/2 не переводятся
+    if (c->kind == CONN_H2)
+    {
+        replyQueue(c, HEAD_NOT_FOUND, NULL, 0, NULL);
+        return 404;
+    }
+    c->closeAfterWrite = false;
+    if (!sseSubscribe(&relayEvents, c))
+    {
+        c->closeAfterWrite = true;
+        headQueue(c, HEAD_UNAVAILABLE, 0);
+        return 503;
+    }
+    return 200;
+}
+
+// Рукопожатие WebSocket /ws - управление с малой задержкой бинарными
+// кадрами; запрос - первый в буфере приема
+static int routeSocket(void *ctx, const HttpRequest *req)
+{
+    HttpExchange *x = ctx;
+    Connection *c = x->conn;
+
+    (void)req;
+    if (c->kind == CONN_H2)
+    {
+        replyQueue(c, HEAD_NOT_FOUND, NULL, 0, NULL);
+        return 404;
+    }
+    if (!serverUpgradeSocket(x))
+    {
+        replyQueueError(c, HEAD_BAD_REQUEST);
+        return 400;
+    }
+    if (!channelSubscribe(&relaySockets, c))
+    {
+        // 1013 - попробовать позже
+        static const uint8_t tryAgain[2] = {0x03, 0xF5};
+
+        wsQueue(c, WS_OP_CLOSE, tryAgain, sizeof(tryAgain));
+        c->closeAfterWrite = true;
+        return 503;
+    }
+    return 101;
+}
+
+// Кнопки страницы /ON и /OFF: в ответ страница
+static int routeButton(void *ctx, const HttpRequest *req)
+{
+    HttpExchange *x = ctx;
+    Connection *c = x->conn;
+    bool on = !strcmp(req->path, "/ON");
+
+    if (submitRelay(c, on, !on, acceptsGzip(req) ? JOB_PAGE_GZIP : JOB_PAGE, req->method, req->path))
+        return 0;
+    replyQueueError(c, HEAD_UNAVAILABLE);
+    return 503;
+}
+
+// Все остальные пути - страница с кнопками
+static int routePage(void *ctx, const HttpRequest *req)
+{
+    HttpExchange *x = ctx;
+
+    queuePage(x->conn, acceptsGzip(req));
+    return 200;
+}
+
+static void initRoutes(void)
+{
+    routerInit(&server.router, routePage, NULL);
+    routerAdd(&server.router, NULL, "/events", false, routeEvents, NULL);
+    routerAdd(&server.router, NULL, "/ws", false, routeSocket, NULL);
+    routerAdd(&server.router, NULL, "/metrics", false, serveMetrics, NULL);
+    routerAdd(&server.router, NULL, "/static/", true, serverStatic, NULL);
+    routerAdd(&server.router, NULL, "/relay/", true, routeRelay, NULL);
+    routerAdd(&server.router, NULL, "/ON", false, routeButton, NULL);
+    routerAdd(&server.router, NULL, "/OFF", false, routeButton, NULL);
+}
+
+// Текущее состояние реле кадром /ws: последний разосланный кадр канала,
+// а если его нет (wsFrame не получил памяти) - собранный заново
+static void queueSocketState(Connection *c)
+{
+    uint8_t message[10] = {WS_MSG_STATE, relayState & 1};
+
+    if (relaySockets.last)
+    {
+        connQueue(c, relaySockets.last->data, relaySockets.last->len, relaySockets.last);
+        return;
+    }
+    putLe64(message + 2, relayState);
+    wsQueue(c, WS_OP_BINARY, message, sizeof(message));
+}
+
+// Команда в кадре данных /ws
+static void socketMessage(HttpServer *s, Connection *c, const uint8_t *payload, size_t len)
+{
+    (void)s;
+    metricAdd(wsFrameMetric, 1);
+    if (len >= 1 && (payload[0] == WS_CMD_ON || payload[0] == WS_CMD_OFF || payload[0] == WS_CMD_MASK))
+    {
+        uint64_t set = payload[0] == WS_CMD_ON, clear = payload[0] == WS_CMD_OFF;
+
+        if (payload[0] == WS_CMD_MASK)
+        {
+            set = len >= 17 ? getLe64(payload + 1) & relayAll : 0;
+            clear = len >= 17 ? getLe64(payload + 9) & relayAll : 0;
         }
+        // Сверх лимита команда отбрасывается, клиент получает текущее состояние;
+        // время берется с пробуждения цикла
+        if (!rateAllow(&frameLimit, c->addr.sin_addr.s_addr, server.now) ||
+            !submitRelay(c, set, clear, JOB_PAGE, "WS", "/ws"))
+            queueSocketState(c);
     }
-    close(server); 
+    else if (len >= 1 && payload[0] == WS_CMD_STATE)
+        queueSocketState(c);
+}
+
+// Команды с консоли: "#" - завершение, "log N" - в журнале доступа (его
+// пишет фоновый поток) остается 1 из N запросов, "log 0" выключает его,
+// "mem" - счетчики памяти запросов, "conn" - счетчики соединений
+static bool readCommand(HttpServer *s, void *isExit)
+{
+    static char line[64];
+    static size_t lineLen;
+    char c;
+
+    (void)s;
+    if (read(STDIN_FILENO, &c, 1) <= 0)
+        return false;
+    if (c == '#')
+        *(bool *)isExit = true;
+    if (c != '\n')
+    {
+        if (lineLen < sizeof(line) - 1)
+            line[lineLen++] = c;
+        return true;
+    }
+    line[lineLen] = '\0';
+    lineLen = 0;
+    if (!strncmp(line, "log ", 4))
+    {
+        unsigned rate = strtoul(line + 4, NULL, 10);
+        accessLogSetSampling(rate);
+        if (rate)
+            printf("=> Access log keeps 1 of %u requests\n", rate);
+        else
+            printf("=> Access log is disabled\n");
+    }
+    else if (!strcmp(line, "conn"))
+    {
+        printf("=> Connections: %d open, %d waiting for a request, %lu timed out, %lu evicted\n",
+               connCount(), connWaiting(), connTimedOut(), connEvicted());
+        printf("=> Rate limit: %lu requests, %lu connections and %lu /ws commands refused\n",
+               requestLimit.limited, connectLimit.limited, frameLimit.limited);
+    }
+    else if (!strcmp(line, "mem"))
+    {
+        const ArenaStats *stats = arenaStats();
+        printf("=> Arena: %llu allocs, %llu bytes, %llu resets, %llu heap overflows, peak %zu of %d bytes;"
+               " shared buffers from heap: %llu\n",
+               (unsigned long long)stats->allocs, (unsigned long long)stats->bytes,
+               (unsigned long long)stats->resets, (unsigned long long)stats->overflows,
+               stats->peak, CONN_ARENA_SIZE, (unsigned long long)sharedBufHeapAllocs());
+    }
+    return true;
+}
+
+static double readOpen(void)
+{
+    return connCount();
+}
+
+static double readWaiting(void)
+{
+    return connWaiting();
+}
+
+static double readTimedOut(void)
+{
+    return connTimedOut();
+}
+
+static double readEvicted(void)
+{
+    return connEvicted();
+}
+
+static double readRequestsLimited(void)
+{
+    return requestLimit.limited;
+}
+
+static double readConnectionsLimited(void)
+{
+    return connectLimit.limited;
+}
+
+static double readFramesLimited(void)
+{
+    return frameLimit.limited;
+}
+
+static double readEventSubscribers(void)
+{
+    return relayEvents.count;
+}
+
+static double readSocketSubscribers(void)
+{
+    return relaySockets.count;
+}
+
+static double readRelays(void)
+{
+    return __builtin_popcountll(relayState);
+}
+
+static double readLogDropped(void)
+{
+    return accessLogDropped();
+}
+
+static double readArenaOverflows(void)
+{
+    return arenaStats()->overflows;
+}
+
+// Регистрация метрик до запуска рабочих потоков
+static void initMetrics(void)
+{
+    static const char requestsHelp[] = "HTTP requests by response status.";
+    static const char gpioHelp[] = "Relay GPIO writes.";
+    size_t bounds = sizeof(latencyBoundsUs) / sizeof(latencyBoundsUs[0]);
+
+    for (size_t i = 0; i < sizeof(statusLabels) / sizeof(statusLabels[0]); i++)
+        requestMetrics[i] = metricCounter("button_http_requests_total", statusLabels[i].labels, requestsHelp);
+    latencyMetric = metricHistogram("button_http_request_duration_seconds", NULL,
+                                    "Time from parsing a request to queuing its response.",
+                                    latencyBoundsUs, bounds, 1e-6);
+    wsFrameMetric = metricCounter("button_ws_frames_total", NULL, "WebSocket data frames received.");
+    gpioOkMetric = metricCounter("button_gpio_writes_total", "result=\"ok\"", gpioHelp);
+    gpioErrorMetric = metricCounter("button_gpio_writes_total", "result=\"error\"", gpioHelp);
+    gpioLatencyMetric = metricHistogram("button_gpio_write_duration_seconds", NULL, "Duration of a relay GPIO write.",
+                                        latencyBoundsUs, bounds, 1e-6);
+    publishMetric = metricHistogram("button_relay_publish_duration_seconds", NULL,
+                                    "Time to notify all relay state subscribers.", latencyBoundsUs, bounds, 1e-6);
+    notifiedMetric = metricCounter("button_relay_notifications_total", NULL,
+                                   "Relay state notifications queued to subscribers.");
+    metricRead("button_relays_on", NULL, "Relays currently switched on.", "gauge", readRelays);
+    metricRead("button_open_connections", NULL, "Open client connections.", "gauge", readOpen);
+    metricRead("button_waiting_connections", NULL, "Connections waiting for a request.", "gauge", readWaiting);
+    metricRead("button_subscribers", "stream=\"sse\"", "Relay state subscribers.", "gauge", readEventSubscribers);
+    metricRead("button_subscribers", "stream=\"ws\"", "Relay state subscribers.", "gauge", readSocketSubscribers);
+    metricRead("button_connections_timed_out_total", NULL, "Connections closed by a read deadline.",
+               "counter", readTimedOut);
+    metricRead("button_connections_evicted_total", NULL, "Waiting connections evicted over the limit.",
+               "counter", readEvicted);
+    metricRead("button_rate_limited_total", "layer=\"request\"", "Requests and connections refused by the per-address rate limit.",
+               "counter", readRequestsLimited);
+    metricRead("button_rate_limited_total", "layer=\"connection\"", "Requests and connections refused by the per-address rate limit.",
+               "counter", readConnectionsLimited);
+    metricRead("button_rate_limited_total", "layer=\"ws\"", "Requests and connections refused by the per-address rate limit.",
+               "counter", readFramesLimited);
+    metricRead("button_access_log_dropped_total", NULL, "Access log records lost to full rings.",
+               "counter", readLogDropped);
+    metricRead("button_arena_overflows_total", NULL, "Request arena allocations served from the heap.",
+               "counter", readArenaOverflows);
+}
+
+// Завершенные задачи пула
+static bool completeJobs(HttpServer *s, void *arg)
+{
+    (void)s, (void)arg;
+    poolComplete();
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+
+    int portNum = 8000;  //номера порта (0 до 65535)
+    const char *staticDir = argc > 1 ? argv[1] : "www"; //каталог статических файлов
+    bool isExit = false;  //признак завершения программы.
+    struct rlimit limit;
+    const char *env;
+    // Запись в GPIO блокирующая и выполняется в пуле из BUTTON_WORKERS потоков
+    // (0 - в цикле epoll). Реле - линии BUTTON_GPIO_LINES на BUTTON_GPIO_CHIP
+    // (например 17,18,27 и /dev/gpiochip0), без них - имитация BUTTON_RELAYS
+    // реле с задержкой записи BUTTON_GPIO_DELAY_US. Ждущих запрос соединений
+    // не больше BUTTON_MAX_WAITING, лишние вытесняются начиная с самых старых.
+    // С одного адреса - BUTTON_RATE запросов в секунду с запасом
+    // BUTTON_RATE_BURST (0 - без ограничения) и BUTTON_CONN_RATE новых
+    // соединений, сверх них ответ 429. Подключение /ws - обычный запрос, а
+    // команды в его кадрах - отдельный запас BUTTON_WS_RATE в секунду:
+    // кнопки страницы шлют их чаще, чем запросы. Нагрузочные тесты bench/
+    // запускают сервер с BUTTON_RATE=0 BUTTON_CONN_RATE=0 BUTTON_WS_RATE=0.
+    // Журнал доступа пишется в файл BUTTON_ACCESS_LOG, а не в stdout:
+    // строки фонового потока не перемешиваются с сообщениями консоли
+    int workers = (env = getenv("BUTTON_WORKERS")) ? atoi(env) : DEFAULT_WORKERS;
+    const char *gpioChip = getenv("BUTTON_GPIO_CHIP");
+    int relayCount = (env = getenv("BUTTON_RELAYS")) ? atoi(env) : DEFAULT_RELAYS;
+    unsigned gpioDelayUs = (env = getenv("BUTTON_GPIO_DELAY_US")) ? strtoul(env, NULL, 10) : 0;
+    int maxWaiting = (env = getenv("BUTTON_MAX_WAITING")) ? atoi(env) : DEFAULT_MAX_WAITING;
+    unsigned rate = (env = getenv("BUTTON_RATE")) ? strtoul(env, NULL, 10) : DEFAULT_RATE;
+    unsigned rateBurst = (env = getenv("BUTTON_RATE_BURST")) ? strtoul(env, NULL, 10) : 2 * rate;
+    unsigned connRate = (env = getenv("BUTTON_CONN_RATE")) ? strtoul(env, NULL, 10) : DEFAULT_CONN_RATE;
+    unsigned wsRate = (env = getenv("BUTTON_WS_RATE")) ? strtoul(env, NULL, 10) : DEFAULT_WS_RATE;
+    const char *accessLogPath = (env = getenv("BUTTON_ACCESS_LOG")) ? env : "access.log";
+    int poolFd, accessLogFd;
+    unsigned gpioLines[GPIO_MAX_LINES];
+
+    printf("SERVER\n");
+
+    // HTTP/2 без TLS (h2c) - по преамбуле или Upgrade: h2c; страница, API и
+    // статика идут потоками одного соединения, подписки /events и /ws -
+    // только в HTTP/1.1
+    serverInit(&server, NULL);
+    server.maxWaiting = maxWaiting;
+    server.h2c = true;
+    server.requestLimit = &requestLimit;
+    server.connectLimit = &connectLimit;
+    server.onRequest = logRequest;
+    server.onMessage = socketMessage;
+    if (!serverBegin(&server, portNum))
+    {
+        printf("=> Error binding connection, the socket has already been established...\n");
+        return -1;
+    }
+    printf("=> Socket server has been created...\n");
+    printf("=> Looking for clients...\n");
+
+    // Тысячи подписчиков /events требуют поднять лимит открытых файлов
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!channelInit(&relayEvents, MAX_SUBSCRIBERS) || !channelInit(&relaySockets, MAX_SUBSCRIBERS))
+    {
+        printf("=> Error creating event loop...\n");
+        exit(1);
+    }
+    rateInit(&requestLimit, rate, rateBurst);
+    rateInit(&connectLimit, connRate, 2 * connRate);
+    rateInit(&frameLimit, wsRate, 2 * wsRate);
+    initMetrics();
+    initRoutes();
+    // Номера линий реле через запятую, по порядку битов маски
+    if (gpioChip)
+    {
+        char *end;
+
+        relayCount = 0;
+        env = getenv("BUTTON_GPIO_LINES");
+        for (; env && *env && relayCount < GPIO_MAX_LINES; env = end + (*end == ','))
+        {
+            unsigned long line = strtoul(env, &end, 10);
+            if (end == env)
+                break;
+            gpioLines[relayCount++] = line;
+        }
+    }
+    if (!gpioInit(gpioChip, gpioLines, relayCount, gpioDelayUs) || (poolFd = poolStart(workers)) < 0)
+    {
+        printf("=> Error initializing GPIO %s...\n", gpioChip ? gpioChip : "simulation");
+        exit(1);
+    }
+    relayAll = relayCount >= 64 ? ~0ULL : (1ULL << relayCount) - 1;
+    for (int i = 0; i < MAX_JOBS; i++)
+    {
+        jobs[i].nextFree = freeJobs;
+        freeJobs = &jobs[i];
+    }
+    gpioUpdate(0, relayAll);
+    printf("=> %d relays, handlers run on %d worker threads\n", relayCount, workers);
+    publishRelays(gpioState()); // новые подписчики сразу получают текущее состояние
+    accessLogFd = open(accessLogPath, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (accessLogFd < 0 || !accessLogStart(accessLogFd, 1))
+        printf("=> Error opening access log %s, it is disabled\n", accessLogPath);
+    if (!staticInit(staticDir))
+        printf("=> Static directory %s not found, /static/ is disabled\n", staticDir);
+
+    serverWatch(&server, STDIN_FILENO, readCommand, &isExit);
+    serverWatch(&server, poolFd, completeJobs, NULL);
+
+    printf("\n=> Enter # and <Enter> to stop the server, log N to sample the access log, mem for memory counters\n");
+
+    while (!isExit)
+        serverPoll(&server, -1);
+    poolStop();
+    accessLogStop();
+    if (accessLogFd >= 0)
+        close(accessLogFd);
+    serverStop(&server);
+    close(server.epfd);
     printf("\nGoodbye...");
     isExit = false;
     return 0;
-}
\ No newline at end of file
+}
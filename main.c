@@ -3,8 +3,8 @@
 #include <ESP8266WebServer.h>
 #include <ESP8266mDNS.h>
 #include <ESP8266HTTPUpdateServer.h>
-#include <PubSubClient.h>
 #include <EEPROM.h>
+#include <LittleFS.h>
 #include <Adafruit_Sensor.h>
 #include <DHT.h>
 
@@ -30,14 +30,19 @@ const char *const levelArg PROGMEM = "level";
 const char *const onbootArg PROGMEM = "onboot";
 const char *const rebootArg PROGMEM = "reboot";
 const char *const tempArg PROGMEM = "temp";
+const char *const humArg PROGMEM = "hum";
+const char *const ageArg PROGMEM = "age";
 const char *const wifimodeArg PROGMEM = "wifimode";
 const char *const mqttconnectedArg PROGMEM = "mqttconnected";
 
 // Блок датчика температуры
 const int gpioDHT22 = D7;
+const uint32_t sensorInterval = 2000; // DHT22 отвечает не чаще раза в 2 с
 DHT dht(gpioDHT22, DHT22);
-float Temperature;
-float Humidity;
+// Последние удачные показания датчика и millis() их чтения
+float Temperature = NAN;
+float Humidity = NAN;
+uint32_t sensorTime;
 const bool mqttSensorRetained = false;
 
 // Блок сервера, wi-fi и mqtt
@@ -47,8 +52,218 @@ uint16_t mqttPort = 1883;
 
 ESP8266WebServer httpServer(80);
 ESP8266HTTPUpdateServer httpUpdater;
-WiFiClient espClient;
-PubSubClient pubsubClient(espClient);
+
+// Состояние подключения к сети WiFi (updateWiFi())
+enum LinkState
+{
+  LINK_AP_ONLY,     // настроек сети нет - только своя точка доступа
+  LINK_CONNECTING,  // станция подключается
+  LINK_CONNECTED,
+  LINK_FALLBACK_AP  // подключиться не удалось - точка доступа до следующей попытки
+};
+const uint32_t wifiConnectTimeout = 20000; // на попытку подключения
+const uint32_t wifiRetryMin = 10000;       // пауза до повтора, удваивается
+const uint32_t wifiRetryMax = 300000;      // после каждой неудачи до 5 минут
+LinkState linkState;
+uint32_t linkTime; // millis() перехода в состояние (в LINK_CONNECTED - и проверки кэша)
+uint32_t wifiRetryDelay;
+
+// Последнее удачное подключение: точка доступа и адреса, в EEPROM за
+// настройками. С ними подключение идет без поиска сети и DHCP; если за
+// wifiFastTimeout оно не удалось - обычное, с поиском
+struct LinkCache
+{
+  uint32_t ssidHash; // кэш годится только для той же сети
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip, gateway, mask, dns;
+};
+const uint16_t linkCacheOffset = 512;
+const uint32_t wifiFastTimeout = 3000;
+const uint32_t dhcpRenewDelay = 10000; // прошлый адрес - только на первые секунды
+const uint32_t linkCacheCheck = 60000;  // адрес от DHCP или точка доступа сменились
+LinkCache linkCache;
+bool linkFast; // идет подключение по кэшу
+
+// Блок событий главной страницы (Server-Sent Events, /events): состояние
+// уходит открытым страницам только при изменении, вместо опроса /data
+const byte maxEventClients = 3; // соединений у lwIP немного, часть - для запросов
+const uint32_t eventKeepAlive = 15000; // комментарий в поток, если событий нет
+WiFiClient eventClients[maxEventClients];
+String statusEvent;      // последнее событие "data: {...}"
+uint32_t statusVersion;  // растет при каждом изменении состояния
+uint32_t bootId;         // случайное при запуске: версии разных запусков не совпадают
+
+// Блок очереди показаний MQTT: показание, которое не удалось отправить,
+// ждет в кольце в RAM; когда оно заполнится, старшая половина уходит в
+// журнал во флеше (тоже кольцо - при переполнении теряются самые старые).
+// После переподключения очередь, начиная со старых, уходит в топик
+// <topic>/backlog пачками "[[темп.,возраст в с],...]" не чаще раза в
+// backlogInterval (возраст null - показание прошлого запуска)
+struct Reading
+{
+  uint32_t boot; // bootId запуска, в котором снято показание
+  uint32_t time; // millis() снятия
+  float temp;
+};
+struct QueueHeader
+{
+  char sign[4];
+  uint16_t head, count;
+};
+const byte ramQueueSize = 32;          // 16 минут показаний раз в 30 с
+const uint16_t flashQueueSize = 2880;  // сутки, 35 КБ во флеше
+const byte backlogBatch = 10;          // пачка - около 150 байт, один сегмент TCP
+const uint32_t backlogInterval = 250;
+const char queueSign[4] PROGMEM = {'#', 'Q', 'U', 'E'};
+const char queuePath[] = "/mqttqueue.bin";
+Reading ramQueue[ramQueueSize];
+byte ramHead, ramCount;
+QueueHeader flashQueue; // заголовок журнала, копия в RAM
+
+/*
+ * Потоковый вывод страниц
+ */
+
+// Страница уходит кусками (Transfer-Encoding: chunked) по мере
+// формирования, а не собирается целиком в String: длинные неизменные
+// части отправляются прямо из PROGMEM через sendContent_P, короткие и
+// значения настроек копятся в буфере на стеке и уходят, когда он
+// заполнится, - так кусков и пакетов TCP не больше, чем нужно.
+// Куча для вывода не используется. Страницы выводят функции render*Page,
+// созданные из шаблонов pages/esp/*.html (tools/html_template.c).
+class PageWriter
+{
+public:
+  PageWriter()
+  {
+    httpServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    httpServer.send(200, F("text/html"), String());
+  }
+  ~PageWriter() { end(); }
+
+  void print(const __FlashStringHelper *str)
+  {
+    PGM_P p = reinterpret_cast<PGM_P>(str);
+
+    printP(p, strlen_P(p));
+  }
+
+  // n байт из PROGMEM, длина известна при сборке
+  void printP(PGM_P p, size_t n)
+  {
+    if (n >= sizeof(buffer))
+    {
+      flush();
+      httpServer.sendContent_P(p, n);
+      return;
+    }
+    if (len + n > sizeof(buffer))
+      flush();
+    memcpy_P(buffer + len, p, n);
+    len += n;
+  }
+
+  void print(unsigned long n)
+  {
+    char digits[12];
+
+    write(digits, snprintf(digits, sizeof(digits), "%lu", n));
+  }
+
+  // Значение для атрибута или текста: кавычки и разметка заменяются
+  // ссылками на символы
+  void printEscaped(const String &str)
+  {
+    for (unsigned int i = 0; i < str.length(); i++)
+    {
+      char c = str[i];
+
+      switch (c)
+      {
+      case '"':
+        write("&quot;", 6);
+        break;
+      case '&':
+        write("&amp;", 5);
+        break;
+      case '<':
+        write("&lt;", 4);
+        break;
+      default:
+        write(&c, 1);
+      }
+    }
+  }
+
+  // Остаток буфера и последний, пустой кусок
+  void end()
+  {
+    if (ended)
+      return;
+    flush();
+    httpServer.sendContent("");
+    ended = true;
+  }
+
+private:
+  char buffer[256];
+  size_t len = 0;
+  bool ended = false;
+
+  void write(const char *data, size_t n)
+  {
+    if (len + n > sizeof(buffer))
+      flush();
+    memcpy(buffer + len, data, n);
+    len += n;
+  }
+
+  void flush()
+  {
+    if (len)
+      httpServer.sendContent(buffer, len);
+    len = 0;
+  }
+};
+
+// Вместо вывода - хэш FNV-1a всех байт страницы: сильный ETag для страниц
+// без значений, известных только при работе (имяPageETag() в esp_pages.h)
+class PageHash
+{
+public:
+  void print(const __FlashStringHelper *str)
+  {
+    PGM_P p = reinterpret_cast<PGM_P>(str);
+
+    printP(p, strlen_P(p));
+  }
+
+  void printP(PGM_P p, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      hash = (hash ^ pgm_read_byte(p + i)) * 0x100000001b3ULL;
+  }
+
+  String etag() const
+  {
+    char text[21];
+
+    snprintf(text, sizeof(text), "\"%08lx%08lx\"", (unsigned long)(hash >> 32),
+             (unsigned long)(hash & 0xFFFFFFFF));
+    return String(text);
+  }
+
+private:
+  uint64_t hash = 0xcbf29ce484222325ULL;
+};
+
+#include "pages/esp_pages.h"
+
+#include "mqtt/mqtt_client.h"
+
+MqttClient mqtt;
 
 /*
  * Функции для работы с EEPROM
@@ -66,7 +281,15 @@ void writeConfig();
  * Функции для работы с WiFi
  */
 
-bool setupWiFiAsStation();
+void startStation(bool keepAP);
+
+void beginStation(bool fast);
+
+uint32_t ssidHash();
+
+void saveLinkCache();
+
+void updateWiFi();
 
 void setupWiFiAsAP();
 
@@ -76,8 +299,6 @@ void setupWiFi();
  * Функции для работы с HTTP
  */
 
-String quoteEscape(const String &str);
-
 void handleRoot();
 
 void handleWiFiConfig();
@@ -90,11 +311,29 @@ void handleReboot();
 
 void handleData();
 
+void handleEvents();
+
+bool notModified(const String &etag);
+
+void appendStatus(String &message);
+
+void updateStatus();
+
+/* Функции для работы с датчиком */
+
+void sampleSensor();
+
 /* Функции для работы с MQTT */
 
-bool mqttReconnect();
-bool mqtt_subscribe(PubSubClient &client, const String &topic);
 void readSendTemperature(const String &topic);
+void notePublish();
+
+/* Функции очереди показаний MQTT */
+
+void loadQueue();
+void queueReading(float temp, uint32_t time);
+void spillQueue();
+void drainQueue(const String &topic);
 
 void setup()
 {
@@ -109,6 +348,13 @@ void setup()
   setupWiFi();
   dht.begin();
 
+  if (!LittleFS.begin())
+    Serial.println(F("LittleFS mount failed!"));
+  loadQueue();
+
+  bootId = ESP.random();
+  static const char *etagHeaders[] = {"If-None-Match"};
+  httpServer.collectHeaders(etagHeaders, 1);
   httpUpdater.setup(&httpServer);
   httpServer.onNotFound([]()
                         { httpServer.send(404, F("text/plain"), F("FileNotFound")); });
@@ -119,32 +365,40 @@ void setup()
   httpServer.on("/store", handleStoreConfig);
   httpServer.on("/reboot", handleReboot);
   httpServer.on("/data", handleData);
+  httpServer.on("/events", handleEvents);
 
   if (mqttServer.length())
   {
-    pubsubClient.setServer(mqttServer.c_str(), mqttPort);
+    mqtt.setServer(mqttServer, mqttPort);
+    mqtt.setCredentials(mqttClient, mqttUser, mqttPassword);
+    mqtt.setSubscription(String('/') + mqttTopic);
+    mqtt.setLed(pinBuiltinLed);
   }
 }
 
 
 void loop()
 {
-  if ((WiFi.getMode() == WIFI_STA) && (WiFi.status() != WL_CONNECTED))
-  {
-    setupWiFi();
-  }
+  updateWiFi();
+  sampleSensor();
+  updateStatus(); // до запросов: ETag /data - версия уже с новыми показаниями
 
   httpServer.handleClient();
 
-  if (mqttServer.length() && (WiFi.getMode() == WIFI_STA))
+  // Показания снимаются и без сети - до подключения их хранит очередь
+  if (mqttServer.length() && ssid.length())
   {
-    if (!pubsubClient.connected())
-      mqttReconnect();
-    if (pubsubClient.connected())
-      pubsubClient.loop();
+    // Подключение к брокеру идет по шагам, без ожидания, пока есть сеть
+    if (linkState == LINK_CONNECTED)
+      mqtt.loop();
+    if (mqtt.connected())
+      drainQueue(mqttTopic);
     static unsigned long lastTempRead = 0;
-    if ((millis() - lastTempRead) >= 30000)
+    static bool firstSent = false;
+    // Первое показание - как только оно есть, дальше раз в 30 с
+    if ((!firstSent && !isnan(Temperature)) || (millis() - lastTempRead) >= 30000)
     {
+      firstSent = true;
       lastTempRead = millis();
       readSendTemperature(mqttTopic);
     }
@@ -206,6 +460,7 @@ bool readConfig()
   offset = readEEPROMString(offset, mqttPassword);
   offset = readEEPROMString(offset, mqttClient);
   offset = readEEPROMString(offset, mqttTopic);
+  EEPROM.get(linkCacheOffset, linkCache);
 
   return true;
 }
@@ -235,37 +490,143 @@ void writeConfig()
   EEPROM.commit();
 }
 
-// Подключение к сети WiFi
-bool setupWiFiAsStation()
+// Начало подключения к сети WiFi; keepAP - точка доступа остается, пока
+// подключение не удастся
+void startStation(bool keepAP)
 {
-  const uint32_t timeout = 60000;
-  uint32_t maxtime = millis() + timeout;
-
   Serial.print(F("Connecting to "));
   Serial.println(ssid);
 
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), password.c_str());
+  WiFi.mode(keepAP ? WIFI_AP_STA : WIFI_STA);
+  beginStation(linkCache.ssidHash == ssidHash() && linkCache.channel >= 1 && linkCache.channel <= 14 &&
+               linkCache.ip);
+  linkState = LINK_CONNECTING;
+}
 
-  while (WiFi.status() != WL_CONNECTED)
+// fast - к точке доступа из кэша по ее каналу и BSSID с прошлым адресом,
+// иначе поиск сети и DHCP
+void beginStation(bool fast)
+{
+  linkFast = fast;
+  linkTime = millis();
+  if (fast)
   {
-    digitalWrite(pinBuiltinLed, LOW);
-    delay(500);
-    digitalWrite(pinBuiltinLed, HIGH);
-    Serial.print(".");
-    if (millis() >= maxtime)
-    {
-      Serial.println(F(" fail!"));
+    WiFi.config(linkCache.ip, linkCache.gateway, linkCache.mask, linkCache.dns);
+    WiFi.begin(ssid.c_str(), password.c_str(), linkCache.channel, linkCache.bssid);
+  }
+  else
+  {
+    WiFi.config(0U, 0U, 0U); // нулевой адрес включает DHCP
+    WiFi.begin(ssid.c_str(), password.c_str());
+  }
+}
 
-      return false;
+// FNV-1a имени сети
+uint32_t ssidHash()
+{
+  uint32_t hash = 2166136261U;
+
+  for (unsigned int i = 0; i < ssid.length(); i++)
+    hash = (hash ^ (uint8_t)ssid[i]) * 16777619U;
+  return hash;
+}
+
+// Кэш подключения пишется, только если изменился: каждый commit()
+// переписывает сектор флеша
+void saveLinkCache()
+{
+  LinkCache cache = {};
+
+  cache.ssidHash = ssidHash();
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+  cache.channel = WiFi.channel();
+  cache.ip = WiFi.localIP();
+  cache.gateway = WiFi.gatewayIP();
+  cache.mask = WiFi.subnetMask();
+  cache.dns = WiFi.dnsIP();
+  if (!memcmp(&cache, &linkCache, sizeof(cache)))
+    return;
+  linkCache = cache;
+  EEPROM.put(linkCacheOffset, linkCache);
+  EEPROM.commit();
+  Serial.println(F("WiFi link cache updated"));
+}
+
+// Шаг автомата подключения, из loop(): только проверка состояния, без
+// ожидания - веб-сервер, датчик и очередь MQTT работают и во время
+// подключения
+void updateWiFi()
+{
+  switch (linkState)
+  {
+  case LINK_CONNECTING:
+    if (WiFi.status() == WL_CONNECTED)
+    {
+      if (WiFi.getMode() != WIFI_STA)
+        WiFi.mode(WIFI_STA); // точка доступа больше не нужна
+      digitalWrite(pinBuiltinLed, HIGH);
+      Serial.printf("WiFi connected in %lu ms (%s), %lu ms after boot\n", millis() - linkTime,
+                    linkFast ? "cached network" : "scan", millis());
+      Serial.print("IP address: ");
+      Serial.println(WiFi.localIP());
+      linkState = LINK_CONNECTED;
+      wifiRetryDelay = wifiRetryMin;
+      saveLinkCache();
+    }
+    else if (linkFast && millis() - linkTime >= wifiFastTimeout)
+    {
+      // Точка доступа сменила канал или адрес - обычное подключение
+      Serial.println(F("Cached network not found, scanning"));
+      beginStation(false);
+    }
+    else if (millis() - linkTime >= wifiConnectTimeout)
+    {
+      Serial.println(F("WiFi connection failed!"));
+      digitalWrite(pinBuiltinLed, HIGH);
+      setupWiFiAsAP();
+      linkState = LINK_FALLBACK_AP;
+      linkTime = millis();
+    }
+    else
+    {
+      // Мигание раз в секунду, пока идет подключение
+      digitalWrite(pinBuiltinLed, (millis() - linkTime) / 500 % 2 ? HIGH : LOW);
+    }
+    break;
+  case LINK_CONNECTED:
+    if (WiFi.status() != WL_CONNECTED)
+    {
+      // Станция переподключается сама; точка доступа - если это не удастся
+      Serial.println(F("WiFi connection lost"));
+      linkState = LINK_CONNECTING;
+      linkTime = millis();
     }
+    else if (linkFast && millis() - linkTime >= dhcpRenewDelay)
+    {
+      // Адрес из кэша задан статически, и аренды на него у роутера нет:
+      // когда истечет прежняя, он отдаст адрес другому. DHCP в фоне берет
+      // аренду - обычно на тот же адрес, соединения не рвутся
+      Serial.println(F("Requesting DHCP lease for the cached address"));
+      WiFi.config(0U, 0U, 0U);
+      linkFast = false;
+      linkTime = millis();
+    }
+    else if (millis() - linkTime >= linkCacheCheck && (uint32_t)WiFi.localIP())
+    {
+      linkTime = millis();
+      saveLinkCache();
+    }
+    break;
+  case LINK_FALLBACK_AP:
+    if (millis() - linkTime >= wifiRetryDelay)
+    {
+      wifiRetryDelay = wifiRetryDelay * 2 < wifiRetryMax ? wifiRetryDelay * 2 : wifiRetryMax;
+      startStation(true);
+    }
+    break;
+  case LINK_AP_ONLY:
+    break;
   }
-  Serial.println();
-  Serial.println(F("WiFi connected"));
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
-
-  return true;
 }
 
 // Создание точки доступа WiFi
@@ -281,11 +642,21 @@ void setupWiFiAsAP()
   Serial.println(WiFi.softAPIP());
 }
 
-// Выбор режима работы с WiFi клиент или точка доступа
+// Запуск WiFi: без настроек сети - точка доступа, иначе - подключение,
+// которое дальше ведет updateWiFi()
 void setupWiFi()
 {
-  if ((!ssid.length()) || (!setupWiFiAsStation()))
+  WiFi.persistent(false); // повторные begin() не переписывают флеш
+  if (ssid.length())
+  {
+    wifiRetryDelay = wifiRetryMin;
+    startStation(false);
+  }
+  else
+  {
     setupWiFiAsAP();
+    linkState = LINK_AP_ONLY;
+  }
 
   if (domain.length())
   {
@@ -304,273 +675,34 @@ void setupWiFi()
   Serial.println(F("HTTP server started (use '/update' url to OTA update)"));
 }
 
-// Парсинг данных
-String quoteEscape(const String &str)
-{
-  String result = "";
-  unsigned int start = 0;
-  int pos;
-
-  while (start < str.length())
-  {
-    pos = str.indexOf('"', start);
-    if (pos != -1)
-    {
-      result += str.substring(start, pos) + F("&quot;");
-      start = pos + 1;
-    }
-    else
-    {
-      result += str.substring(start);
-      break;
-    }
-  }
-  return result;
-}
-
 // Отображение главной web страницы
 void handleRoot()
 {
-  String message =
-      F("<!DOCTYPE html>\n\
-      <html>\n\
-      <head>\n\
-      <title>ESP </title>\n\
-      <style type=\"text/css\">\n\
-      .checkbox {\n\
-      vertical-align:top;\n\
-      margin:0 3px 0 0;\n\
-      width:17px;\n\
-      height:17px;\n\
-      }\n\
-      .checkbox + label {\n\
-      cursor:pointer;\n\
-      }\n\
-      checkbox:not(checked) {\n\
-      position:absolute;\n\
-      opacity:0;\n\
-      }\n\
-    .checkbox:not(checked) + label {\n\
-      position:relative;\n\
-      padding:0 0 0 60px;\n\
-    }\n\
-    .checkbox:not(checked) + label:before {\n\
-      content:'';\n\
-      position:absolute;\n\
-      top:-4px;\n\
-      left:0;\n\
-      width:50px;\n\
-      height:26px;\n\
-      border-radius:13px;\n\
-      background:#CDD1DA;\n\
-      box-shadow:inset 0 2px 3px rgba(0,0,0,.2);\n\
-    }\n\
-    .checkbox:not(checked) + label:after {\n\
-      content:'';\n\
-      position:absolute;\n\
-      top:-2px;\n\
-      left:2px;\n\
-      width:22px;\n\
-      height:22px;\n\
-      border-radius:10px;\n\
-      background:#FFF;\n\
-      box-shadow:0 2px 5px rgba(0,0,0,.3);\n\
-      transition:all .2s;\n\
-    }\n\
-    .checkbox:checked + label:before {\n\
-      background:#9FD468;\n\
-    }\n\
-    .checkbox:checked + label:after {\n\
-      left:26px;\n\
-    }\n\
-  </style>\n\
-  <script type=\"text/javascript\">\n\
-    function openUrl(url) {\n\
-      var request = new XMLHttpRequest();\n\
-      request.open('GET', url, true);\n\
-      request.send(null);\n\
-    }\n\
-    function refreshData() {\n\
-      var request = new XMLHttpRequest();\n\
-      request.open('GET', '/data', true);\n\
-      request.onreadystatechange = function() {\n\
-        if (request.readyState == 4) {\n\
-          var data = JSON.parse(request.responseText);\n\
-          document.getElementById('");
-  message += FPSTR(tempArg);
-  message += F("').innerHTML = data.");
-  message += FPSTR(tempArg);
-  message += F(";\n\
-          document.getElementById('");
-  message += FPSTR(wifimodeArg);
-  message += F("').innerHTML = data.");
-  message += FPSTR(wifimodeArg);
-  message += F(";\n\
-          document.getElementById('");
-  message += FPSTR(mqttconnectedArg);
-  message += F("').innerHTML = (data.");
-  message += FPSTR(mqttconnectedArg);
-  message += F(" != true ) ? \"Not connected \" :  \"Connected\";");
-  message += F("\n\
-        }\n\
-      }\n\
-      request.send(null);\n\
-    }\n\
-    setInterval(refreshData, 500);\n\
-  </script>\n\
-</head>\n\
-<body>\n\
-  <form>\n\
-    <h3>ESP </h3>\n\
-    <p>\n\
-    Temp : <span id=\"");
-  message += FPSTR(tempArg);
-  message += F("\">?</span> C<br/>\n\
-    WiFi mode: <span id=\"");
-  message += FPSTR(wifimodeArg);
-  message += F("\">?</span><br/>\n\
-    MQTT broker: <span id=\"");
-  message += FPSTR(mqttconnectedArg);
-  message += F("\">?</span><br/>\n\
-    ");
-  message += F("</label>\n\
-    <p>\n\
-    <input type=\"button\" value=\"WiFi Setup\" onclick=\"location.href='/wifi';\" />\n\
-    <input type=\"button\" value=\"MQTT Setup\" onclick=\"location.href='/mqtt';\" />\n\
-    <input type=\"button\" value=\"Reboot!\" onclick=\"if (confirm('Are you sure to reboot?')) location.href='/reboot';\" />\n\
-  </form>\n\
-</body>\n\
-</html>");
+  if (notModified(rootPageETag()))
+    return;
 
-  httpServer.send(200, F("text/html"), message);
+  PageWriter page;
+
+  renderRootPage(page);
+  page.end();
 }
 
 // Отображение страницы настроек WiFi
 void handleWiFiConfig()
 {
-  String message =
-      F("<!DOCTYPE html>\n\
-<html>\n\
-<head>\n\
-  <title>WiFi Setup</title>\n\
-</head>\n\
-<body>\n\
-  <form name=\"wifi\" method=\"get\" action=\"/store\">\n\
-    <h3>WiFi Setup</h3>\n\
-    SSID:<br/>\n\
-    <input type=\"text\" name=\"");
-  message += FPSTR(ssidArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(ssid);
-  message += F("\" />\n\
-    <br/>\n\
-    Password:<br/>\n\
-    <input type=\"password\" name=\"");
-  message += FPSTR(passwordArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(password);
-  message += F("\" />\n\
-    <br/>\n\
-    mDNS domain:<br/>\n\
-    <input type=\"text\" name=\"");
-  message += FPSTR(domainArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(domain);
-  message += F("\" />\n\
-    \n\
-    <p>\n\
-    <input type=\"submit\" value=\"Save\" />\n\
-    <input type=\"hidden\" name=\"");
-  message += FPSTR(rebootArg);
-  message += F("\" value=\"1\" />\n\
-  </form>\n\
-</body>\n\
-</html>");
+  PageWriter page;
 
-  httpServer.send(200, F("text/html"), message);
+  renderWifiPage(page);
+  page.end();
 }
 
 // Отображение страницы настроек MQTT
 void handleMQTTConfig()
 {
-  String message =
-      F("<!DOCTYPE html>\n\
-<html>\n\
-<head>\n\
-  <title>MQTT Setup</title>\n\
-</head>\n\
-<body>\n\
-  <form name=\"mqtt\" method=\"get\" action=\"/store\">\n\
-    <h3>MQTT Setup</h3>\n\
-    Server:<br/>\n\
-    <input type=\"text\" name=\"");
-  message += FPSTR(serverArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(mqttServer);
-  message += F("\" onchange=\"document.mqtt.reboot.value=1;\" />\n\
-    \n\
-    <br/>\n\
-    Port:<br/>\n\
-    <input type=\"text\" name=\"");
-  message += FPSTR(portArg);
-  message += F("\" maxlength=5 value=\"");
-  message += String(mqttPort);
-  message += F("\" onchange=\"document.mqtt.reboot.value=1;\" />\n\
-    <br/>\n\
-    User:<br/>\n\
-    <input type=\"text\" name=\"");
-  message += FPSTR(userArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(mqttUser);
-  message += F("\" />\n\
-    \n\
-    <br/>\n\
-    Password:<br/>\n\
-    <input type=\"password\" name=\"");
-  message += FPSTR(mqttpswdArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(mqttPassword);
-  message += F("\" />\n\
-    <br/>\n\
-    Client:<br/>\n\
-    <input type=\"text\" name=\"");
-  message += FPSTR(clientArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(mqttClient);
-  message += F("\" />\n\
-    <br/>\n\
-    Topic:<br/>\n\
-    <input type=\"text\" name=\"");
-  message += FPSTR(topicArg);
-  message += F("\" maxlength=");
-  message += String(maxStrParamLength);
-  message += F(" value=\"");
-  message += quoteEscape(mqttTopic);
-  message += F("\" />\n\
-    <p>\n\
-    <input type=\"submit\" value=\"Save\" />\n\
-    <input type=\"hidden\" name=\"");
-  message += FPSTR(rebootArg);
-  message += F("\" value=\"0\" />\n\
-  </form>\n\
-</body>\n\
-</html>");
+  PageWriter page;
 
-  httpServer.send(200, F("text/html"), message);
+  renderMqttPage(page);
+  page.end();
 }
 
 // Функция перезаписи полученых данных из web интерфейса в EEPROM
@@ -631,24 +763,10 @@ void handleStoreConfig()
 
   writeConfig();
 
-  String message =
-      F("<!DOCTYPE html>\n\
-<html>\n\
-<head>\n\
-  <title>Store Setup</title>\n\
-  <meta http-equiv=\"refresh\" content=\"5; /index.html\">\n\
-</head>\n\
-<body>\n\
-  Configuration stored successfully.\n");
-  if (httpServer.arg(rebootArg) == "1")
-    message += F("  <br/>\n\
-  <i>You must reboot module to apply new configuration!</i>\n");
-  message += F("  <p>\n\
-  Wait for 5 sec. or click <a href=\"/index.html\">this</a> to return to main page.\n\
-</body>\n\
-</html>");
+  PageWriter page;
 
-  httpServer.send(200, F("text/html"), message);
+  renderStorePage(page, httpServer.arg(rebootArg) == "1");
+  page.end();
 }
 
 // Функция перезагрузки контроллера со страницы в браузере
@@ -656,19 +774,13 @@ void handleReboot()
 {
   Serial.println(F("/reboot()"));
 
-  String message =
-      F("<!DOCTYPE html>\n\
-<html>\n\
-<head>\n\
-  <title>Rebooting</title>\n\
-  <meta http-equiv=\"refresh\" content=\"5; /index.html\">\n\
-</head>\n\
-<body>\n\
-  Rebooting...\n\
-</body>\n\
-</html>");
+  // Действие, а не документ: ответ каждый раз, без ETag и 304
+  {
+    PageWriter page;
 
-  httpServer.send(200, F("text/html"), message);
+    renderRebootPage(page);
+    page.end();
+  }
 
   ESP.restart();
 }
@@ -676,10 +788,82 @@ void handleReboot()
 // Функция подготовки и отправки JSON
 void handleData()
 {
-  String message = F("{\"");
+  // Слабый ETag: при той же версии ответ отличается только возрастом показаний
+  String etag = F("W/\"");
+  etag += String(bootId, HEX);
+  etag += '-';
+  etag += String(statusVersion);
+  etag += '"';
+  if (notModified(etag))
+    return;
+
+  String message = F("{");
+  appendStatus(message);
+  message += F(",\"");
+  message += FPSTR(ageArg);
+  message += F("\":");
+  if (isnan(Temperature)) // показаний еще не было: возраст неизвестен
+    message += F("null");
+  else
+    message += String(millis() - sensorTime);
+  message += F("}");
+
+  httpServer.send(200, F("text/html"), message);
+}
+
+// ETag уходит с ответом; если он совпал с If-None-Match, вместо ответа -
+// 304 без тела: у браузера уже есть эта версия
+bool notModified(const String &etag)
+{
+  httpServer.sendHeader(F("ETag"), etag);
+  if (httpServer.header(F("If-None-Match")).indexOf(etag) < 0)
+    return false;
+  httpServer.send(304);
+  return true;
+}
+
+// Поток событий для главной страницы. Соединение забирается у сервера
+// и остается открытым; заголовки ответа пишутся в него напрямую, сразу за
+// ними - текущее состояние
+void handleEvents()
+{
+  for (byte i = 0; i < maxEventClients; i++)
+  {
+    if (eventClients[i].connected())
+      continue;
+    eventClients[i] = httpServer.client();
+    eventClients[i].setNoDelay(true);
+    eventClients[i].print(F("HTTP/1.1 200 OK\r\n"
+                            "Content-Type: text/event-stream\r\n"
+                            "Cache-Control: no-cache\r\n"
+                            "Connection: keep-alive\r\n"
+                            "\r\n"
+                            "retry: 5000\n\n"));
+    if (statusEvent.length())
+      eventClients[i].print(statusEvent);
+    return;
+  }
+  httpServer.send(503, F("text/plain"), F("Too many event streams"));
+}
+
+// Поля состояния для /data и событий: показания (null, пока датчик не
+// прочитан - nan в JSON не допускается), режим WiFi, связь с MQTT
+void appendStatus(String &message)
+{
+  message += F("\"");
   message += FPSTR(tempArg);
   message += F("\":");
-  message += String(dht.readTemperature());
+  if (isnan(Temperature))
+    message += F("null");
+  else
+    message += String(Temperature);
+  message += F(",\"");
+  message += FPSTR(humArg);
+  message += F("\":");
+  if (isnan(Humidity))
+    message += F("null");
+  else
+    message += String(Humidity);
   message += F(",\"");
   message += FPSTR(wifimodeArg);
   message += F("\":\"");
@@ -703,67 +887,226 @@ void handleData()
   message += F("\",\"");
   message += FPSTR(mqttconnectedArg);
   message += F("\":");
-  if (pubsubClient.connected())
+  if (mqtt.connected())
     message += F("true");
   else
     message += F("false");
-  message += F("}");
-
-  httpServer.send(200, F("text/html"), message);
 }
 
-// Переподключение к MQTT
-bool mqttReconnect()
+// Рассылка состояния потокам событий. Событие собирается, только когда
+// изменились его исходные данные, а не на каждом проходе loop(); без
+// изменений потокам раз в eventKeepAlive уходит комментарий - он держит
+// соединение через прокси и выявляет закрытые страницы
+void updateStatus()
 {
-  const uint32_t timeout = 30000;
-  static uint32_t lastTime;
-  bool result = false;
-
-  if (millis() > lastTime + timeout)
+  static float lastTemperature = NAN, lastHumidity = NAN;
+  static WiFiMode_t lastMode = WIFI_OFF;
+  static bool lastMqtt = false;
+  static uint32_t lastSend = 0;
+  WiFiMode_t mode = WiFi.getMode();
+  bool mqttUp = mqtt.connected();
+  // NAN != NAN: пока датчик не прочитан, изменением это не считается
+  bool changed = !statusEvent.length() || mode != lastMode || mqttUp != lastMqtt ||
+                 (Temperature != lastTemperature && !(isnan(Temperature) && isnan(lastTemperature))) ||
+                 (Humidity != lastHumidity && !(isnan(Humidity) && isnan(lastHumidity)));
+
+  if (changed)
   {
-    Serial.print(F("Attempting MQTT connection...\n"));
-    Serial.printf("Client %s User %s Password %s\n", mqttClient.c_str(), mqttUser.c_str(), mqttPassword.c_str());
-    digitalWrite(pinBuiltinLed, LOW);
-    if (mqttUser.length())
-      result = pubsubClient.connect(mqttClient.c_str(), mqttUser.c_str(), mqttPassword.c_str());
-    else
-      result = pubsubClient.connect(mqttClient.c_str());
-    digitalWrite(pinBuiltinLed, HIGH);
-    if (result)
-    {
-      Serial.println(F(" connected"));
-      String topic('/');
-      topic += mqttTopic;
-      result = mqtt_subscribe(pubsubClient, topic);
-    }
-    else
-    {
-      Serial.print(F(" failed, rc="));
-      Serial.println(pubsubClient.state());
-    }
-    lastTime = millis();
+    lastTemperature = Temperature;
+    lastHumidity = Humidity;
+    lastMode = mode;
+    lastMqtt = mqttUp;
+    statusVersion++;
+    statusEvent = F("data: {");
+    appendStatus(statusEvent);
+    statusEvent += F("}\n\n");
   }
+  else if (millis() - lastSend < eventKeepAlive)
+    return;
+  lastSend = millis();
 
-  return result;
+  for (byte i = 0; i < maxEventClients; i++)
+  {
+    if (!eventClients[i].connected())
+      continue;
+    size_t sent = changed ? eventClients[i].print(statusEvent) : eventClients[i].print(F(":\n\n"));
+    if (!sent)
+      eventClients[i].stop();
+  }
 }
 
-// Подписка на топик
-bool mqtt_subscribe(PubSubClient &client, const String &topic)
+// Опрос датчика по расписанию. Чтение DHT22 - обмен с запрещенными
+// прерываниями на несколько миллисекунд, поэтому датчик читается только
+// здесь, раз в sensorInterval, а /data и MQTT отдают сохраненные значения
+void sampleSensor()
 {
-  Serial.print(F("Subscribing to "));
-  Serial.println(topic);
-  return client.subscribe(topic.c_str());
+  static uint32_t lastSample = millis();
+
+  if (millis() - lastSample < sensorInterval)
+    return;
+  lastSample = millis();
+
+  float t = dht.readTemperature(false, true);
+  float h = dht.readHumidity();
+
+  if (isnan(t) || isnan(h))
+  {
+    Serial.println(F("Failed to read from DHT sensor!"));
+    return;
+  }
+  Temperature = t;
+  Humidity = h;
+  sensorTime = lastSample;
 }
 
 // Отправка данных в топик
 void readSendTemperature(const String &topic)
 {
 
-  float t = dht.readTemperature();
+  float t = Temperature;
 
+  if (isnan(t))
+    return;
   Serial.print(F("Temp: "));
   Serial.print(t);
   Serial.println(F("C"));
   String str_temp(t);
-  pubsubClient.publish(topic.c_str(), str_temp.c_str(), mqttSensorRetained);
+  if (mqtt.publish(topic.c_str(), str_temp.c_str(), mqttSensorRetained))
+    notePublish();
+  else
+    queueReading(t, sensorTime);
+}
+
+// Время от запуска до первой публикации - итог подключения к сети и
+// брокеру, печатается один раз
+void notePublish()
+{
+  static bool published = false;
+
+  if (published)
+    return;
+  published = true;
+  Serial.printf("First MQTT publish %lu ms after boot\n", millis());
+}
+
+// Смещение показания в журнале
+uint32_t queueOffset(uint16_t index)
+{
+  return sizeof(QueueHeader) + (uint32_t)(index % flashQueueSize) * sizeof(Reading);
+}
+
+// Заголовок журнала; без файла или с чужим файлом журнал пуст
+void loadQueue()
+{
+  File f = LittleFS.open(queuePath, "r");
+
+  if (!f || f.read((uint8_t *)&flashQueue, sizeof(flashQueue)) != sizeof(flashQueue) ||
+      memcmp_P(flashQueue.sign, queueSign, sizeof(queueSign)) || flashQueue.head >= flashQueueSize ||
+      flashQueue.count > flashQueueSize)
+  {
+    memcpy_P(flashQueue.sign, queueSign, sizeof(queueSign));
+    flashQueue.head = flashQueue.count = 0;
+  }
+  if (flashQueue.count)
+    Serial.printf("MQTT backlog: %u readings in flash\n", flashQueue.count);
+}
+
+void queueReading(float temp, uint32_t time)
+{
+  if (ramCount == ramQueueSize)
+    spillQueue();
+  ramQueue[(ramHead + ramCount) % ramQueueSize] = {bootId, time, temp};
+  ramCount++;
+}
+
+// Старшая половина кольца в RAM - в журнал за одно открытие файла. Если
+// флеш недоступен, место освобождается за счет самых старых показаний
+void spillQueue()
+{
+  const byte n = ramQueueSize / 2;
+  File f = LittleFS.open(queuePath, flashQueue.count ? "r+" : "w+");
+
+  if (!flashQueue.count)
+    flashQueue.head = 0;
+  for (byte i = 0; f && i < n; i++)
+  {
+    if (!f.seek(queueOffset(flashQueue.head + flashQueue.count)) ||
+        f.write((const uint8_t *)&ramQueue[(ramHead + i) % ramQueueSize], sizeof(Reading)) != sizeof(Reading))
+      break;
+    if (flashQueue.count < flashQueueSize)
+      flashQueue.count++;
+    else
+      flashQueue.head = (flashQueue.head + 1) % flashQueueSize;
+  }
+  if (!f || !f.seek(0) || f.write((const uint8_t *)&flashQueue, sizeof(flashQueue)) != sizeof(flashQueue))
+    Serial.println(F("MQTT backlog: flash write failed, oldest readings dropped"));
+  ramHead = (ramHead + n) % ramQueueSize;
+  ramCount -= n;
+}
+
+// Пачка самых старых показаний - сначала из журнала, затем из RAM. Пачка
+// удаляется из очереди только после удачной публикации
+void drainQueue(const String &topic)
+{
+  static uint32_t lastDrain;
+  Reading batch[backlogBatch];
+  byte n = 0, fromFlash = 0;
+
+  if ((!ramCount && !flashQueue.count) || millis() - lastDrain < backlogInterval)
+    return;
+  lastDrain = millis();
+
+  if (flashQueue.count)
+  {
+    File f = LittleFS.open(queuePath, "r");
+
+    while (f && n < backlogBatch && n < flashQueue.count && f.seek(queueOffset(flashQueue.head + n)) &&
+           f.read((uint8_t *)&batch[n], sizeof(Reading)) == sizeof(Reading))
+      n++;
+    if (!n)
+    {
+      Serial.println(F("MQTT backlog: flash log unreadable, dropped"));
+      flashQueue.count = 0;
+      LittleFS.remove(queuePath);
+    }
+    fromFlash = n;
+  }
+  for (byte i = 0; n < backlogBatch && i < ramCount; i++)
+    batch[n++] = ramQueue[(ramHead + i) % ramQueueSize];
+  if (!n)
+    return;
+
+  String payload('[');
+  for (byte i = 0; i < n; i++)
+  {
+    payload += i ? F(",[") : F("[");
+    payload += String(batch[i].temp);
+    payload += ',';
+    if (batch[i].boot == bootId)
+      payload += String((millis() - batch[i].time) / 1000);
+    else
+      payload += F("null");
+    payload += ']';
+  }
+  payload += ']';
+  if (!mqtt.publish((topic + F("/backlog")).c_str(), payload.c_str()))
+    return;
+  notePublish();
+
+  if (fromFlash)
+  {
+    flashQueue.head = (flashQueue.head + fromFlash) % flashQueueSize;
+    flashQueue.count -= fromFlash;
+    if (!flashQueue.count)
+      LittleFS.remove(queuePath);
+    else
+    {
+      File f = LittleFS.open(queuePath, "r+");
+
+      if (f)
+        f.write((const uint8_t *)&flashQueue, sizeof(flashQueue));
+    }
+  }
+  ramHead = (ramHead + n - fromFlash) % ramQueueSize;
+  ramCount -= n - fromFlash;
 }
\ No newline at end of file
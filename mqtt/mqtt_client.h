@@ -0,0 +1,385 @@
+// Клиент MQTT прошивки main.c. Подключается из main.c; в сборке для Linux
+// проверяется bench/mqtt_check.c.
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <Arduino.h>
+#include <ESPAsyncTCP.h>
+
+// Клиент MQTT 3.1.1 поверх AsyncClient (ESPAsyncTCP): ни один вызов не
+// ждет сети. loop() ведет подключение по шагам - TCP, CONNECT и CONNACK,
+// SUBSCRIBE и SUBACK - и держит его живым (PINGREQ); обработчики
+// AsyncClient только разбирают входящий поток и ставят флаги. Неудачная
+// попытка откладывает следующую на случайную паузу от d/2 до d, где d
+// удваивается от mqttRetryMin до mqttRetryMax, - так устройства после
+// сбоя брокера не приходят к нему разом. publish() - QoS 0: пакет
+// целиком ложится в буфер отправки lwIP или не отправляется вовсе.
+// Входящие PUBLISH пропускаются - обработчика у прошивки нет. Светодиод
+// setLed() горит, пока идет попытка подключения.
+const uint32_t mqttRetryMin = 1000;
+const uint32_t mqttRetryMax = 60000;
+const uint32_t mqttTimeout = 5000;  // на каждый шаг подключения
+const uint16_t mqttKeepAlive = 15;  // с
+
+class MqttClient
+{
+public:
+  enum State
+  {
+    MQTT_IDLE,      // пауза до следующей попытки
+    MQTT_TCP,       // подключение TCP
+    MQTT_CONNACK,   // CONNECT отправлен
+    MQTT_SUBACK,    // SUBSCRIBE отправлен, публиковать уже можно
+    MQTT_CONNECTED
+  };
+
+  MqttClient()
+  {
+    tcp.onConnect([](void *arg, AsyncClient *)
+                  { static_cast<MqttClient *>(arg)->tcpOpened = true; }, this);
+    tcp.onDisconnect([](void *arg, AsyncClient *)
+                     { static_cast<MqttClient *>(arg)->tcpClosed = true; }, this);
+    tcp.onError([](void *arg, AsyncClient *, int8_t error)
+                { static_cast<MqttClient *>(arg)->tcpError = error; }, this);
+    tcp.onData([](void *arg, AsyncClient *, void *data, size_t len)
+               { static_cast<MqttClient *>(arg)->receive(static_cast<const uint8_t *>(data), len); }, this);
+  }
+
+  void setServer(const String &host, uint16_t port)
+  {
+    this->host = host;
+    this->port = port;
+  }
+
+  void setCredentials(const String &clientId, const String &user, const String &password)
+  {
+    this->clientId = clientId;
+    this->user = user;
+    this->password = password;
+  }
+
+  // Вывод светодиода состояния (горит при LOW), -1 - без него
+  void setLed(int pin) { ledPin = pin; }
+
+  // Топик, на который клиент подписывается после каждого подключения
+  void setSubscription(const String &topic) { subscription = topic; }
+
+  bool connected() { return state >= MQTT_SUBACK && tcp.connected(); }
+
+  // Шаг подключения или проверки связи; вызывается из loop() прошивки
+  void loop()
+  {
+    uint32_t now = millis();
+
+    if (state != MQTT_IDLE && tcpClosed)
+    {
+      failed(state == MQTT_TCP ? F("TCP connect failed") : F("connection lost"));
+      return;
+    }
+    switch (state)
+    {
+    case MQTT_IDLE:
+      if (host.length() && now - stateTime >= retryDelay)
+        attempt();
+      break;
+    case MQTT_TCP:
+      if (tcpOpened)
+      {
+        tcp.setNoDelay(true);
+        sendConnect();
+        enter(MQTT_CONNACK);
+      }
+      else if (now - stateTime >= mqttTimeout)
+        failed(F("TCP connect timeout"));
+      break;
+    case MQTT_CONNACK:
+      if (received & GOT_CONNACK)
+      {
+        if (connackCode)
+        {
+          Serial.printf("MQTT: connection refused, code %u\n", connackCode);
+          failed(F("refused"));
+          break;
+        }
+        retries = 0;
+        setLedOff();
+        Serial.printf("MQTT: connected in %lu ms\n", (unsigned long)(now - attemptTime));
+        if (subscription.length() && sendSubscribe())
+          enter(MQTT_SUBACK);
+        else
+          enter(MQTT_CONNECTED);
+      }
+      else if (now - stateTime >= mqttTimeout)
+        failed(F("no CONNACK"));
+      break;
+    case MQTT_SUBACK:
+      if (received & GOT_SUBACK)
+      {
+        Serial.print(subackCode == 0x80 ? F("MQTT: subscription rejected: ") : F("MQTT: subscribed to "));
+        Serial.println(subscription);
+        enter(MQTT_CONNECTED);
+      }
+      else if (now - stateTime >= mqttTimeout)
+        failed(F("no SUBACK"));
+      break;
+    case MQTT_CONNECTED:
+      break;
+    }
+    if (state >= MQTT_SUBACK)
+      keepAlive(now);
+  }
+
+  // QoS 0; false - нет связи или места в буфере отправки
+  bool publish(const char *topic, const char *payload, bool retained = false)
+  {
+    size_t topicLen = strlen(topic), payloadLen = strlen(payload);
+
+    if (!connected() || !addHeader(retained ? 0x31 : 0x30, 2 + topicLen + payloadLen))
+      return false;
+    addString(topic, topicLen);
+    tcp.add(payload, payloadLen);
+    return send();
+  }
+
+private:
+  enum
+  {
+    GOT_CONNACK = 1,
+    GOT_SUBACK = 2
+  };
+  enum RxStep
+  {
+    RX_TYPE,
+    RX_LENGTH,
+    RX_BODY
+  };
+
+  AsyncClient tcp;
+  int ledPin = -1;
+  String host, clientId, user, password, subscription;
+  uint16_t port = 1883;
+  State state = MQTT_IDLE;
+  uint32_t stateTime, attemptTime;
+  uint32_t retryDelay = 0; // первая попытка - сразу
+  byte retries = 0;
+  uint32_t lastSend, lastReceive;
+  bool pingSent = false;
+
+  // Заполняются обработчиками AsyncClient
+  bool tcpOpened = false, tcpClosed = false;
+  int8_t tcpError = 0;
+  byte received = 0;
+  byte connackCode, subackCode;
+  RxStep rxStep = RX_TYPE;
+  byte rxType, rxShift;
+  uint32_t rxLength, rxPos;
+  byte rxBody[3]; // начало тела: ответам брокера хватает
+
+  void setLedOn()
+  {
+    if (ledPin >= 0)
+      digitalWrite(ledPin, LOW);
+  }
+
+  void setLedOff()
+  {
+    if (ledPin >= 0)
+      digitalWrite(ledPin, HIGH);
+  }
+
+  void enter(State next)
+  {
+    state = next;
+    stateTime = millis();
+  }
+
+  void attempt()
+  {
+    tcpOpened = tcpClosed = false;
+    tcpError = 0;
+    received = 0;
+    rxStep = RX_TYPE;
+    pingSent = false;
+    attemptTime = millis();
+    Serial.printf("MQTT: connecting to %s:%u as %s\n", host.c_str(), port, clientId.c_str());
+    setLedOn();
+    enter(MQTT_TCP);
+    if (!tcp.connect(host.c_str(), port))
+      failed(F("TCP connect failed"));
+  }
+
+  // Разрыв и пауза до следующей попытки
+  void failed(const __FlashStringHelper *reason)
+  {
+    uint32_t step = mqttRetryMin << (retries < 6 ? retries : 6);
+
+    if (!tcp.freeable())
+      tcp.close(true);
+    tcpClosed = false;
+    if (step > mqttRetryMax)
+      step = mqttRetryMax;
+    if (retries < 255)
+      retries++;
+    retryDelay = step / 2 + ESP.random() % (step / 2);
+    setLedOff();
+    Serial.print(F("MQTT: "));
+    Serial.print(reason);
+    if (tcpError)
+      Serial.printf(" (error %d)", tcpError);
+    Serial.printf(", retry in %lu ms\n", (unsigned long)retryDelay);
+    enter(MQTT_IDLE);
+  }
+
+  // PINGREQ, если интервал молчит любая сторона, как у PubSubClient: при
+  // частых публикациях QoS 0 брокер не отвечает ничем, и без пинга
+  // соединение рвалось бы само; разрыв, если брокер молчит полтора интервала
+  void keepAlive(uint32_t now)
+  {
+    const uint32_t interval = mqttKeepAlive * 1000UL;
+
+    if (now - lastReceive >= interval * 3 / 2)
+    {
+      failed(F("keepalive timeout"));
+      return;
+    }
+    if (!pingSent && (now - lastSend >= interval || now - lastReceive >= interval) && addHeader(0xC0, 0))
+    {
+      pingSent = true;
+      send();
+    }
+  }
+
+  void sendConnect()
+  {
+    size_t length = 10 + 2 + clientId.length();
+    byte flags = 0x02; // чистая сессия
+
+    if (user.length())
+    {
+      length += 2 + user.length() + 2 + password.length();
+      flags |= 0xC0;
+    }
+    if (!addHeader(0x10, length))
+      return; // на пустом соединении не бывает; брокер не ответит - повтор по mqttTimeout
+    addString("MQTT", 4);
+    const char rest[] = {4, (char)flags, (char)(mqttKeepAlive >> 8), (char)(mqttKeepAlive & 0xFF)};
+    tcp.add(rest, sizeof(rest));
+    addString(clientId.c_str(), clientId.length());
+    if (user.length())
+    {
+      addString(user.c_str(), user.length());
+      addString(password.c_str(), password.length());
+    }
+    send();
+    lastReceive = millis();
+  }
+
+  // Один топик, QoS 0, идентификатор пакета 1
+  bool sendSubscribe()
+  {
+    const char packetId[] = {0, 1}, qos = 0;
+
+    if (!addHeader(0x82, 2 + 2 + subscription.length() + 1))
+      return false;
+    tcp.add(packetId, sizeof(packetId));
+    addString(subscription.c_str(), subscription.length());
+    tcp.add(&qos, 1);
+    return send();
+  }
+
+  // Фиксированный заголовок, если в буфере отправки есть место для всего
+  // пакета: тип и длина остатка по 7 бит
+  bool addHeader(byte type, size_t length)
+  {
+    char header[5];
+    size_t n = 0, rest = length;
+
+    header[n++] = type;
+    do
+    {
+      header[n] = rest % 128;
+      rest /= 128;
+      if (rest)
+        header[n] |= 0x80;
+      n++;
+    } while (rest && n < sizeof(header));
+    // Больше 268 МБ длина не кодируется; пакет без места целиком не
+    // начинается - иначе add() обрежет тело и поток к брокеру собьется
+    if (rest || tcp.space() < n + length)
+      return false;
+    tcp.add(header, n);
+    return true;
+  }
+
+  void addString(const char *str, size_t len)
+  {
+    const char prefix[] = {(char)(len >> 8), (char)(len & 0xFF)};
+
+    tcp.add(prefix, sizeof(prefix));
+    tcp.add(str, len);
+  }
+
+  bool send()
+  {
+    lastSend = millis();
+    return tcp.send();
+  }
+
+  // Входящий поток по байтам: тип, длина остатка, тело. Из тела
+  // запоминаются только первые байты - код ответа брокера
+  void receive(const uint8_t *data, size_t len)
+  {
+    for (size_t i = 0; i < len; i++)
+    {
+      switch (rxStep)
+      {
+      case RX_TYPE:
+        rxType = data[i] >> 4;
+        rxLength = rxPos = rxShift = 0;
+        rxStep = RX_LENGTH;
+        break;
+      case RX_LENGTH:
+        rxLength |= (uint32_t)(data[i] & 0x7F) << rxShift;
+        rxShift += 7;
+        if (data[i] & 0x80)
+          break;
+        rxStep = RX_BODY;
+        if (!rxLength)
+          packetReceived(); // пакет без тела
+        break;
+      case RX_BODY:
+      {
+        size_t n = len - i < rxLength - rxPos ? len - i : rxLength - rxPos;
+
+        for (size_t j = 0; j < n && rxPos + j < sizeof(rxBody); j++)
+          rxBody[rxPos + j] = data[i + j];
+        rxPos += n;
+        i += n - 1;
+        if (rxPos == rxLength)
+          packetReceived();
+        break;
+      }
+      }
+    }
+  }
+
+  void packetReceived()
+  {
+    rxStep = RX_TYPE;
+    lastReceive = millis();
+    pingSent = false;
+    switch (rxType)
+    {
+    case 2: // CONNACK: флаги, код
+      connackCode = rxLength >= 2 ? rxBody[1] : 0xFF;
+      received |= GOT_CONNACK;
+      break;
+    case 9: // SUBACK: идентификатор, код
+      subackCode = rxLength >= 3 ? rxBody[2] : 0x80;
+      received |= GOT_SUBACK;
+      break;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,57 @@
+// Создан из pages/button.html: ./gzip_embed page pages/button.html - не править вручную
+static const char page[] =
+    "<!DOCTYPE HTML>\n"
+    "<html>\n"
+    "  <head>\n"
+    "    <meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">\n"
+    "  </head>\n"
+    "  <h1>OrangePI - Web Server</h1>\n"
+    "  <p>Buttons\n"
+    "    <a href=\"ON\">\n"
+    "      <button>ON</button>\n"
+    "    </a>&nbsp;\n"
+    "    <a href=\"OFF\">\n"
+    "      <button>OFF</button>\n"
+    "    </a>\n"
+    "  </p>\n"
+    "  <p>State: <span id=\"state\">?</span></p>\n"
+    "  <p>Relays: <span id=\"mask\">?</span></p>\n"
+    "  <script>\n"
+    "    var events = new EventSource('/events');\n"
+    "    events.addEventListener('relays', function(e) {\n"
+    "      var on = parseInt(e.data.slice(-1), 16) & 1;\n"
+    "      document.getElementById('state').innerHTML = on ? 'ON' : 'OFF';\n"
+    "      document.getElementById('mask').innerHTML = e.data;\n"
+    "    });\n"
+    "  </script>\n"
+    "</html>\n";
+
+// gzip: 401 байт вместо 681
+static const unsigned char pageGzip[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x52, 0x5f, 0x6f, 0x9b, 0x30,
+    0x10, 0x7f, 0xef, 0xa7, 0xb8, 0xf1, 0x50, 0x83, 0x94, 0x80, 0x78, 0xd9, 0x43, 0x0b, 0x54, 0xea,
+    0x16, 0xb4, 0x48, 0x5d, 0x88, 0x96, 0x48, 0xd5, 0x1e, 0x2f, 0xf8, 0x12, 0xac, 0x81, 0x41, 0xb6,
+    0x43, 0x14, 0x4d, 0xfb, 0xee, 0x35, 0x36, 0xd3, 0xaa, 0xe6, 0x61, 0x4f, 0xdc, 0x1d, 0xbf, 0x3f,
+    0x77, 0xe7, 0xcb, 0x3e, 0x7d, 0xad, 0xbe, 0xec, 0x7f, 0x6e, 0x57, 0xf0, 0x6d, 0xff, 0xfd, 0xa5,
+    0xb8, 0xcb, 0x1a, 0xd3, 0xb5, 0xc5, 0x1d, 0x40, 0xd6, 0x10, 0xf2, 0x29, 0xb0, 0x61, 0x47, 0x06,
+    0x41, 0x62, 0x47, 0x79, 0x30, 0x0a, 0xba, 0x0c, 0xbd, 0x32, 0x01, 0xd4, 0xbd, 0x34, 0x24, 0x4d,
+    0x1e, 0x5c, 0x04, 0x37, 0x4d, 0xce, 0x69, 0x14, 0x35, 0x2d, 0x5d, 0xb2, 0x00, 0x21, 0x85, 0x11,
+    0xd8, 0x2e, 0x75, 0x8d, 0x2d, 0xe5, 0x69, 0xe0, 0x14, 0x93, 0xbf, 0x92, 0x59, 0x93, 0x16, 0x95,
+    0x42, 0x79, 0xa2, 0xed, 0x1a, 0x96, 0xf0, 0x4a, 0x07, 0xd8, 0x91, 0x1a, 0x49, 0x59, 0x48, 0xea,
+    0x00, 0x43, 0xf1, 0x7c, 0x36, 0xa6, 0x97, 0xda, 0x37, 0x80, 0xd0, 0x28, 0x3a, 0xe6, 0x41, 0xb5,
+    0x09, 0x7c, 0x4b, 0xb6, 0x76, 0x70, 0x80, 0xa2, 0xda, 0x64, 0xc9, 0x1c, 0x7a, 0x6c, 0x82, 0xc5,
+    0xbd, 0x3c, 0xe8, 0xe1, 0xf1, 0x03, 0xb5, 0x2c, 0x6f, 0xb9, 0x65, 0x79, 0x4b, 0x76, 0x9d, 0x0e,
+    0x73, 0x17, 0x3b, 0x83, 0x86, 0x1e, 0x20, 0xd3, 0x03, 0x4a, 0x10, 0x3c, 0x0f, 0xf4, 0x54, 0x08,
+    0x8a, 0xa7, 0x2c, 0x99, 0x4a, 0xc5, 0x3f, 0xe4, 0x0f, 0x6a, 0xf1, 0xaa, 0xdf, 0x43, 0x3b, 0xd4,
+    0xbf, 0x6e, 0x91, 0xba, 0x56, 0x62, 0x30, 0xde, 0x6e, 0x44, 0x05, 0x34, 0xda, 0x25, 0x6a, 0xc8,
+    0x41, 0xd2, 0x05, 0x56, 0x53, 0xb2, 0xeb, 0xcf, 0xaa, 0xa6, 0x90, 0x25, 0xfe, 0x17, 0x8b, 0xfc,
+    0x24, 0x3e, 0x8b, 0x91, 0x73, 0x87, 0x7a, 0x11, 0xda, 0xae, 0x9f, 0x54, 0xc8, 0x94, 0x73, 0x66,
+    0x0b, 0x38, 0x9e, 0x65, 0x6d, 0x44, 0x2f, 0x43, 0x8a, 0xe0, 0xf7, 0x3c, 0xea, 0x64, 0xd1, 0x4b,
+    0x2b, 0x3f, 0xa0, 0xd2, 0xb4, 0x96, 0x26, 0xa4, 0x98, 0xa3, 0xc1, 0x58, 0xb7, 0xf6, 0xb9, 0xc2,
+    0x65, 0x1a, 0x2d, 0x20, 0xfd, 0x1c, 0xc1, 0x3d, 0xa4, 0x8f, 0x33, 0x85, 0xf7, 0xf5, 0xb9, 0xb3,
+    0x0e, 0xf1, 0x89, 0xcc, 0xaa, 0xa5, 0x29, 0x7c, 0xbe, 0xae, 0x79, 0xc8, 0xdc, 0xec, 0x2c, 0x8a,
+    0x85, 0xb4, 0xbe, 0xd3, 0xb9, 0x58, 0x59, 0xab, 0xfd, 0x04, 0xac, 0xda, 0x30, 0x78, 0xb0, 0x9f,
+    0xb2, 0x64, 0xff, 0x55, 0x99, 0xd6, 0xf2, 0x41, 0xc4, 0xb7, 0xe4, 0x99, 0x7f, 0xdc, 0xb8, 0x76,
+    0x69, 0xf3, 0x9e, 0xec, 0x49, 0xb8, 0x8b, 0x7c, 0x03, 0x13, 0x57, 0xf2, 0x0a, 0xa9, 0x02, 0x00,
+    0x00,
+};
@@ -0,0 +1,337 @@
+// Создан из шаблонов: pages/esp/root.html pages/esp/wifi.html pages/esp/mqtt.html pages/esp/store.html pages/esp/reboot.html
+// ./html_template - не править вручную
+
+// pages/esp/root.html: 2796 байт текста, кусков 11, подстановок 10
+static const char rootPage[] PROGMEM =
+    "<!DOCTYPE html>\n"
+    "      <html>\n"
+    "      <head>\n"
+    "      <title>ESP </title>\n"
+    "      <style type=\"text/css\">\n"
+    "      .checkbox {\n"
+    "      vertical-align:top;\n"
+    "      margin:0 3px 0 0;\n"
+    "      width:17px;\n"
+    "      height:17px;\n"
+    "      }\n"
+    "      .checkbox + label {\n"
+    "      cursor:pointer;\n"
+    "      }\n"
+    "      checkbox:not(checked) {\n"
+    "      position:absolute;\n"
+    "      opacity:0;\n"
+    "      }\n"
+    "    .checkbox:not(checked) + label {\n"
+    "      position:relative;\n"
+    "      padding:0 0 0 60px;\n"
+    "    }\n"
+    "    .checkbox:not(checked) + label:before {\n"
+    "      content:'';\n"
+    "      position:absolute;\n"
+    "      top:-4px;\n"
+    "      left:0;\n"
+    "      width:50px;\n"
+    "      height:26px;\n"
+    "      border-radius:13px;\n"
+    "      background:#CDD1DA;\n"
+    "      box-shadow:inset 0 2px 3px rgba(0,0,0,.2);\n"
+    "    }\n"
+    "    .checkbox:not(checked) + label:after {\n"
+    "      content:'';\n"
+    "      position:absolute;\n"
+    "      top:-2px;\n"
+    "      left:2px;\n"
+    "      width:22px;\n"
+    "      height:22px;\n"
+    "      border-radius:10px;\n"
+    "      background:#FFF;\n"
+    "      box-shadow:0 2px 5px rgba(0,0,0,.3);\n"
+    "      transition:all .2s;\n"
+    "    }\n"
+    "    .checkbox:checked + label:before {\n"
+    "      background:#9FD468;\n"
+    "    }\n"
+    "    .checkbox:checked + label:after {\n"
+    "      left:26px;\n"
+    "    }\n"
+    "  </style>\n"
+    "  <script type=\"text/javascript\">\n"
+    "    function openUrl(url) {\n"
+    "      var request = new XMLHttpRequest();\n"
+    "      request.open('GET', url, true);\n"
+    "      request.send(null);\n"
+    "    }\n"
+    "    function showData(text) {\n"
+    "      var data = JSON.parse(text);\n"
+    "      document.getElementById('').innerHTML = (data. != null) ? data. : \"?\";\n"
+    "      document.getElementById('').innerHTML = data.;\n"
+    "      document.getElementById('').innerHTML = (data. != true ) ? \"Not connected \" :  \"Connected\";\n"
+    "    }\n"
+    "    function refreshData() {\n"
+    "      var request = new XMLHttpRequest();\n"
+    "      request.open('GET', '/data', true);\n"
+    "      request.onreadystatechange = function() {\n"
+    "        if (request.readyState == 4 && request.status == 200)\n"
+    "          showData(request.responseText);\n"
+    "      }\n"
+    "      request.send(null);\n"
+    "    }\n"
+    "    function pollData() {\n"
+    "      refreshData();\n"
+    "      setInterval(refreshData, 500);\n"
+    "    }\n"
+    "    if (window.EventSource) {\n"
+    "      var events = new EventSource('/events');\n"
+    "      events.onmessage = function(e) { showData(e.data); };\n"
+    "      events.onerror = function() {\n"
+    "        if (events.readyState == EventSource.CLOSED)\n"
+    "          pollData();\n"
+    "      };\n"
+    "    } else {\n"
+    "      pollData();\n"
+    "    }\n"
+    "  </script>\n"
+    "</head>\n"
+    "<body>\n"
+    "  <form>\n"
+    "    <h3>ESP </h3>\n"
+    "    <p>\n"
+    "    Temp : <span id=\"\">?</span> C<br/>\n"
+    "    WiFi mode: <span id=\"\">?</span><br/>\n"
+    "    MQTT broker: <span id=\"\">?</span><br/>\n"
+    "    </label>\n"
+    "    <p>\n"
+    "    <input type=\"button\" value=\"WiFi Setup\" onclick=\"location.href='/wifi';\" />\n"
+    "    <input type=\"button\" value=\"MQTT Setup\" onclick=\"location.href='/mqtt';\" />\n"
+    "    <input type=\"button\" value=\"Reboot!\" onclick=\"if (confirm('Are you sure to reboot?')) location.href='/reboot';\" />\n"
+    "  </form>\n"
+    "</body>\n"
+    "</html>";
+
+template <class Writer>
+static void renderRootPage(Writer &page)
+{
+  page.printP(rootPage + 0, 1394);
+  page.print(FPSTR(tempArg));
+  page.printP(rootPage + 1394, 21);
+  page.print(FPSTR(tempArg));
+  page.printP(rootPage + 1415, 17);
+  page.print(FPSTR(tempArg));
+  page.printP(rootPage + 1432, 39);
+  page.print(FPSTR(wifimodeArg));
+  page.printP(rootPage + 1471, 20);
+  page.print(FPSTR(wifimodeArg));
+  page.printP(rootPage + 1491, 33);
+  page.print(FPSTR(mqttconnectedArg));
+  page.printP(rootPage + 1524, 21);
+  page.print(FPSTR(mqttconnectedArg));
+  page.printP(rootPage + 1545, 824);
+  page.print(FPSTR(tempArg));
+  page.printP(rootPage + 2369, 43);
+  page.print(FPSTR(wifimodeArg));
+  page.printP(rootPage + 2412, 43);
+  page.print(FPSTR(mqttconnectedArg));
+  page.printP(rootPage + 2455, 341);
+}
+
+static inline const String &rootPageETag()
+{
+  static String etag;
+
+  if (!etag.length())
+  {
+    PageHash hash;
+
+    renderRootPage(hash);
+    etag = hash.etag();
+  }
+  return etag;
+}
+
+// pages/esp/wifi.html: 514 байт текста, кусков 11, подстановок 10
+static const char wifiPage[] PROGMEM =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "  <title>WiFi Setup</title>\n"
+    "</head>\n"
+    "<body>\n"
+    "  <form name=\"wifi\" method=\"get\" action=\"/store\">\n"
+    "    <h3>WiFi Setup</h3>\n"
+    "    SSID:<br/>\n"
+    "    <input type=\"text\" name=\"\" maxlength= value=\"\" />\n"
+    "    <br/>\n"
+    "    Password:<br/>\n"
+    "    <input type=\"password\" name=\"\" maxlength= value=\"\" />\n"
+    "    <br/>\n"
+    "    mDNS domain:<br/>\n"
+    "    <input type=\"text\" name=\"\" maxlength= value=\"\" />\n"
+    "    \n"
+    "    <p>\n"
+    "    <input type=\"submit\" value=\"Save\" />\n"
+    "    <input type=\"hidden\" name=\"\" value=\"1\" />\n"
+    "  </form>\n"
+    "</body>\n"
+    "</html>";
+
+static void renderWifiPage(PageWriter &page)
+{
+  page.printP(wifiPage + 0, 191);
+  page.print(FPSTR(ssidArg));
+  page.printP(wifiPage + 191, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(wifiPage + 203, 8);
+  page.printEscaped(ssid);
+  page.printP(wifiPage + 211, 67);
+  page.print(FPSTR(passwordArg));
+  page.printP(wifiPage + 278, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(wifiPage + 290, 8);
+  page.printEscaped(password);
+  page.printP(wifiPage + 298, 66);
+  page.print(FPSTR(domainArg));
+  page.printP(wifiPage + 364, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(wifiPage + 376, 8);
+  page.printEscaped(domain);
+  page.printP(wifiPage + 384, 90);
+  page.print(FPSTR(rebootArg));
+  page.printP(wifiPage + 474, 40);
+}
+
+// pages/esp/mqtt.html: 837 байт текста, кусков 19, подстановок 18
+static const char mqttPage[] PROGMEM =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "  <title>MQTT Setup</title>\n"
+    "</head>\n"
+    "<body>\n"
+    "  <form name=\"mqtt\" method=\"get\" action=\"/store\">\n"
+    "    <h3>MQTT Setup</h3>\n"
+    "    Server:<br/>\n"
+    "    <input type=\"text\" name=\"\" maxlength= value=\"\" onchange=\"document.mqtt.reboot.value=1;\" />\n"
+    "    \n"
+    "    <br/>\n"
+    "    Port:<br/>\n"
+    "    <input type=\"text\" name=\"\" maxlength=5 value=\"\" onchange=\"document.mqtt.reboot.value=1;\" />\n"
+    "    <br/>\n"
+    "    User:<br/>\n"
+    "    <input type=\"text\" name=\"\" maxlength= value=\"\" />\n"
+    "    \n"
+    "    <br/>\n"
+    "    Password:<br/>\n"
+    "    <input type=\"password\" name=\"\" maxlength= value=\"\" />\n"
+    "    <br/>\n"
+    "    Client:<br/>\n"
+    "    <input type=\"text\" name=\"\" maxlength= value=\"\" />\n"
+    "    <br/>\n"
+    "    Topic:<br/>\n"
+    "    <input type=\"text\" name=\"\" maxlength= value=\"\" />\n"
+    "    <p>\n"
+    "    <input type=\"submit\" value=\"Save\" />\n"
+    "    <input type=\"hidden\" name=\"\" value=\"0\" />\n"
+    "  </form>\n"
+    "</body>\n"
+    "</html>";
+
+static void renderMqttPage(PageWriter &page)
+{
+  page.printP(mqttPage + 0, 193);
+  page.print(FPSTR(serverArg));
+  page.printP(mqttPage + 193, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(mqttPage + 205, 8);
+  page.printEscaped(mqttServer);
+  page.printP(mqttPage + 213, 105);
+  page.print(FPSTR(portArg));
+  page.printP(mqttPage + 318, 21);
+  page.print((unsigned long)(mqttPort));
+  page.printP(mqttPage + 339, 100);
+  page.print(FPSTR(userArg));
+  page.printP(mqttPage + 439, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(mqttPage + 451, 8);
+  page.printEscaped(mqttUser);
+  page.printP(mqttPage + 459, 72);
+  page.print(FPSTR(mqttpswdArg));
+  page.printP(mqttPage + 531, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(mqttPage + 543, 8);
+  page.printEscaped(mqttPassword);
+  page.printP(mqttPage + 551, 61);
+  page.print(FPSTR(clientArg));
+  page.printP(mqttPage + 612, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(mqttPage + 624, 8);
+  page.printEscaped(mqttClient);
+  page.printP(mqttPage + 632, 60);
+  page.print(FPSTR(topicArg));
+  page.printP(mqttPage + 692, 12);
+  page.print((unsigned long)(maxStrParamLength));
+  page.printP(mqttPage + 704, 8);
+  page.printEscaped(mqttTopic);
+  page.printP(mqttPage + 712, 85);
+  page.print(FPSTR(rebootArg));
+  page.printP(mqttPage + 797, 40);
+}
+
+// pages/esp/store.html: 337 байт текста, кусков 3, подстановок 0
+static const char storePage[] PROGMEM =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "  <title>Store Setup</title>\n"
+    "  <meta http-equiv=\"refresh\" content=\"5; /index.html\">\n"
+    "</head>\n"
+    "<body>\n"
+    "  Configuration stored successfully.\n"
+    "  <br/>\n"
+    "  <i>You must reboot module to apply new configuration!</i>\n"
+    "  <p>\n"
+    "  Wait for 5 sec. or click <a href=\"/index.html\">this</a> to return to main page.\n"
+    "</body>\n"
+    "</html>";
+
+static void renderStorePage(PageWriter &page, bool rebootNotice)
+{
+  page.printP(storePage + 0, 166);
+  if (rebootNotice)
+  {
+    page.printP(storePage + 166, 68);
+  }
+  page.printP(storePage + 234, 103);
+}
+
+// pages/esp/reboot.html: 157 байт текста, кусков 1, подстановок 0
+static const char rebootPage[] PROGMEM =
+    "<!DOCTYPE html>\n"
+    "<html>\n"
+    "<head>\n"
+    "  <title>Rebooting</title>\n"
+    "  <meta http-equiv=\"refresh\" content=\"5; /index.html\">\n"
+    "</head>\n"
+    "<body>\n"
+    "  Rebooting...\n"
+    "</body>\n"
+    "</html>";
+
+template <class Writer>
+static void renderRebootPage(Writer &page)
+{
+  page.printP(rebootPage + 0, 157);
+}
+
+static inline const String &rebootPageETag()
+{
+  static String etag;
+
+  if (!etag.length())
+  {
+    PageHash hash;
+
+    renderRebootPage(hash);
+    etag = hash.etag();
+  }
+  return etag;
+}
@@ -0,0 +1,121 @@
+// Встраивание ответа в программу: файл превращается в заголовок C с
+// двумя массивами - телом как есть (строкой, sizeof - 1 дает длину) и его
+// gzip-вариантом (имяGzip), сжатым при сборке встроенным кодером httpd/deflate.
+// С -z для каждого файла рядом пишется файл.gz - их отдает кэш статики
+// httpd/static клиентам, принимающим gzip; файлы, которые не сжимаются,
+// пропускаются.
+// Сборка: gcc -O2 -o gzip_embed tools/gzip_embed.c httpd/deflate.c
+// Запуск: ./gzip_embed имя файл > заголовок.h
+//         (например ./gzip_embed page pages/button.html > pages/button_html.h)
+//         ./gzip_embed -z www/*.html www/*.js www/*.css
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../httpd/deflate.h"
+
+static unsigned char *readFile(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    unsigned char *data = NULL;
+    long size;
+
+    if (!f)
+        return NULL;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0 &&
+        (data = malloc(size + 1)) && fread(data, 1, size, f) == (size_t)size)
+        *len = size;
+    else
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+// Тело строками исходника: по строке файла на строку литерала
+static void printString(const char *name, const unsigned char *data, size_t len)
+{
+    printf("static const char %s[] =\n    \"", name);
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char ch = data[i];
+
+        if (ch == '\n')
+            printf(i + 1 < len ? "\\n\"\n    \"" : "\\n");
+        else if (ch == '"' || ch == '\\')
+            printf("\\%c", ch);
+        else if (ch < 0x20 || ch >= 0x7F)
+            printf("\\%03o", ch); // восьмеричная запись не поглощает следующие цифры
+        else
+            putchar(ch);
+    }
+    printf("\";\n");
+}
+
+static void printBytes(const char *name, const unsigned char *data, size_t len)
+{
+    printf("static const unsigned char %sGzip[] = {", name);
+    for (size_t i = 0; i < len; i++)
+        printf("%s0x%02x,", i % 16 ? " " : "\n    ", data[i]);
+    printf("\n};\n");
+}
+
+// Файл.gz рядом с каждым файлом; false при ошибке
+static bool writeVariants(char **paths, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        unsigned char *data, *gz = NULL;
+        size_t len = 0, gzLen = 0;
+        char gzPath[4096];
+        FILE *f = NULL;
+        bool ok;
+
+        snprintf(gzPath, sizeof(gzPath), "%s.gz", paths[i]);
+        ok = (data = readFile(paths[i], &len)) && (gz = malloc(gzipBound(len))) && (gzLen = gzipCompress(data, len, gz));
+        if (ok && gzLen < len)
+            ok = (f = fopen(gzPath, "wb")) && fwrite(gz, 1, gzLen, f) == gzLen;
+        if (f && fclose(f))
+            ok = false;
+        if (!ok)
+        {
+            fprintf(stderr, "=> Error compressing %s\n", paths[i]);
+            return false;
+        }
+        fprintf(stderr, "=> %s: %zu bytes, gzip %zu bytes%s\n", paths[i], len, gzLen,
+                gzLen < len ? "" : " (skipped)");
+        free(data);
+        free(gz);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned char *data, *gz;
+    size_t len = 0, gzLen;
+
+    if (argc > 1 && !strcmp(argv[1], "-z"))
+        return writeVariants(argv + 2, argc - 2) ? 0 : 1;
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s name file > header.h\n       %s -z file...\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (!(data = readFile(argv[2], &len)) || !(gz = malloc(gzipBound(len))) || !(gzLen = gzipCompress(data, len, gz)))
+    {
+        fprintf(stderr, "=> Error reading or compressing %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("// Создан из %s: ./gzip_embed %s %s - не править вручную\n", argv[2], argv[1], argv[2]);
+    printString(argv[1], data, len);
+    printf("\n// gzip: %zu байт вместо %zu\n", gzLen, len);
+    printBytes(argv[1], gz, gzLen);
+    fprintf(stderr, "=> %s: %zu bytes, gzip %zu bytes (%.1f%%)\n", argv[2], len, gzLen, 100.0 * gzLen / (len ? len : 1));
+    free(data);
+    free(gz);
+    return 0;
+}
@@ -0,0 +1,285 @@
+// Компилятор шаблонов HTML для страниц прошивки main.c.
+// Шаблон - файл HTML с подстановками:
+//   {{имя}}        - значение String, экранированное для HTML;
+//   {{#имя}}       - число;
+//   {{!имя}}       - строка из PROGMEM как есть (имена параметров формы);
+//   {{?условие}}   - начало части, которая выводится при истинном условии,
+//   {{/}}          - ее конец;
+//   {{%параметры}} - параметры функции вывода, например {{%bool notice}}.
+// Имя и условие - выражения C++, видимые в месте подключения заголовка.
+// Весь неизменный текст страницы ложится одним массивом в PROGMEM, а для
+// страницы создается функция renderИмяPage(PageWriter &page, ...), которая
+// выводит куски массива по смещениям и длинам, посчитанным при сборке, и
+// между ними - подстановки. Последний перевод строки файла отбрасывается.
+// Странице без значений, известных только при работе (лишь текст и
+// {{!имя}}), дается и сильный ETag - функция имяPageETag(): при первом
+// вызове она выводит страницу в PageHash (FNV-1a, main.c) и запоминает
+// хэш. В него входят значения {{!имя}}, так что ETag меняется вместе с
+// байтами страницы. Функция вывода такой страницы - шаблон от Writer.
+// Сборка: gcc -O2 -o html_template tools/html_template.c
+// Запуск: ./html_template pages/esp/*.html > pages/esp_pages.h
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_DEPTH 8 // вложенность {{?...}}
+
+typedef struct
+{
+    char name[64];      // имя страницы из имени файла: wifi -> wifi
+    char *text;         // неизменный текст подряд
+    size_t textLen;
+    char *code;         // тело функции вывода
+    size_t codeLen, codeCap;
+    char params[272];   // ", " и текст тега
+    int segments, fields;
+    bool dynamic;       // есть подстановки, известные только при работе
+} Page;
+
+static char *readFile(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    char *data = NULL;
+    long size;
+
+    if (!f)
+        return NULL;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0 &&
+        (data = malloc(size + 1)) && fread(data, 1, size, f) == (size_t)size)
+    {
+        data[size] = '\0';
+        *len = size;
+    }
+    else
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static void emit(Page *p, int depth, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+// Строка тела функции с отступом по вложенности условий
+static void emit(Page *p, int depth, const char *format, ...)
+{
+    va_list ap;
+    int n;
+
+    for (;;)
+    {
+        size_t room = p->codeCap - p->codeLen;
+
+        va_start(ap, format);
+        n = snprintf(p->code + p->codeLen, room, "%*s", 2 + depth * 2, "");
+        if ((size_t)n < room)
+            n += vsnprintf(p->code + p->codeLen + n, room - n, format, ap);
+        va_end(ap);
+        if ((size_t)n + 1 < room)
+            break;
+        p->codeCap = p->codeCap * 2 + n + 64;
+        if (!(p->code = realloc(p->code, p->codeCap)))
+            exit(1);
+    }
+    p->codeLen += n;
+    p->code[p->codeLen++] = '\n';
+    p->code[p->codeLen] = '\0';
+}
+
+// Кусок неизменного текста: в массив страницы и вывод по смещению
+static void addText(Page *p, const char *text, size_t len, int depth)
+{
+    if (!len)
+        return;
+    memcpy(p->text + p->textLen, text, len);
+    emit(p, depth, "page.printP(%sPage + %zu, %zu);", p->name, p->textLen, len);
+    p->textLen += len;
+    p->segments++;
+}
+
+static void trim(char *s)
+{
+    size_t len = strlen(s);
+    char *start = s;
+
+    while (len && isspace((unsigned char)s[len - 1]))
+        s[--len] = '\0';
+    while (isspace((unsigned char)*start))
+        start++;
+    memmove(s, start, strlen(start) + 1);
+}
+
+static bool compile(Page *p, const char *path, char *src, size_t len)
+{
+    const char *pos = src, *end = src + len;
+    int depth = 0;
+
+    if (len && src[len - 1] == '\n')
+        end--;
+    p->text = malloc(len + 1);
+    p->codeCap = 1024;
+    p->code = malloc(p->codeCap);
+    p->code[0] = '\0';
+    while (pos < end)
+    {
+        const char *open = strstr(pos, "{{"), *close;
+        char tag[256];
+        size_t tagLen;
+
+        if (!open || open >= end)
+        {
+            addText(p, pos, end - pos, depth);
+            break;
+        }
+        addText(p, pos, open - pos, depth);
+        if (!(close = strstr(open + 2, "}}")) || (tagLen = close - open - 2) >= sizeof(tag))
+        {
+            fprintf(stderr, "=> %s: unterminated placeholder at offset %zu\n", path, (size_t)(open - src));
+            return false;
+        }
+        memcpy(tag, open + 2, tagLen);
+        tag[tagLen] = '\0';
+        pos = close + 2;
+
+        switch (tag[0])
+        {
+        case '%':
+            p->dynamic = true;
+            snprintf(p->params, sizeof(p->params), ", %s", tag + 1);
+            trim(p->params + 2);
+            if (pos < end && *pos == '\n')
+                pos++;
+            continue;
+        case '?':
+            if (depth == MAX_DEPTH)
+            {
+                fprintf(stderr, "=> %s: sections nested too deep\n", path);
+                return false;
+            }
+            p->dynamic = true;
+            trim(tag + 1);
+            emit(p, depth, "if (%s)", tag + 1);
+            emit(p, depth, "{");
+            depth++;
+            continue;
+        case '/':
+            if (!depth)
+            {
+                fprintf(stderr, "=> %s: {{/}} without {{?...}}\n", path);
+                return false;
+            }
+            depth--;
+            emit(p, depth, "}");
+            continue;
+        case '#':
+            p->dynamic = true;
+            trim(tag + 1);
+            emit(p, depth, "page.print((unsigned long)(%s));", tag + 1);
+            break;
+        case '!':
+            trim(tag + 1);
+            emit(p, depth, "page.print(FPSTR(%s));", tag + 1);
+            break;
+        default:
+            p->dynamic = true;
+            trim(tag);
+            emit(p, depth, "page.printEscaped(%s);", tag);
+        }
+        p->fields++;
+    }
+    if (depth)
+    {
+        fprintf(stderr, "=> %s: {{?...}} without {{/}}\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Имя страницы: имя файла без каталога и расширения, только буквы и цифры
+static void pageName(char *name, size_t size, const char *path)
+{
+    const char *base = strrchr(path, '/');
+    size_t n = 0;
+
+    for (base = base ? base + 1 : path; *base && *base != '.' && n + 1 < size; base++)
+    {
+        if (isalnum((unsigned char)*base))
+            name[n++] = *base;
+    }
+    name[n] = '\0';
+}
+
+// Неизменный текст строками исходника: по строке файла на строку литерала
+static void printText(const Page *p)
+{
+    printf("static const char %sPage[] PROGMEM =\n    \"", p->name);
+    for (size_t i = 0; i < p->textLen; i++)
+    {
+        unsigned char ch = p->text[i];
+
+        if (ch == '\n')
+            printf(i + 1 < p->textLen ? "\\n\"\n    \"" : "\\n");
+        else if (ch == '"' || ch == '\\')
+            printf("\\%c", ch);
+        else if (ch < 0x20 || ch >= 0x7F)
+            printf("\\%03o", ch);
+        else
+            putchar(ch);
+    }
+    printf("\";\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s template.html... > header.h\n", argv[0]);
+        return 1;
+    }
+
+    printf("// Создан из шаблонов:");
+    for (int i = 1; i < argc; i++)
+        printf(" %s", argv[i]);
+    printf("\n// ./html_template - не править вручную\n");
+    for (int i = 1; i < argc; i++)
+    {
+        Page page = {0};
+        size_t len = 0;
+        char *src = readFile(argv[i], &len);
+        char title[64];
+
+        pageName(page.name, sizeof(page.name), argv[i]);
+        if (!src || !compile(&page, argv[i], src, len))
+        {
+            if (!src)
+                fprintf(stderr, "=> Error reading %s\n", argv[i]);
+            return 1;
+        }
+        snprintf(title, sizeof(title), "%s", page.name);
+        title[0] = toupper((unsigned char)title[0]);
+
+        printf("\n// %s: %zu байт текста, кусков %d, подстановок %d\n", argv[i], page.textLen, page.segments,
+               page.fields);
+        printText(&page);
+        if (page.dynamic)
+            printf("\nstatic void render%sPage(PageWriter &page%s)\n{\n%s}\n", title, page.params, page.code);
+        else
+        {
+            printf("\ntemplate <class Writer>\nstatic void render%sPage(Writer &page)\n{\n%s}\n", title, page.code);
+            printf("\nstatic inline const String &%sPageETag()\n{\n  static String etag;\n\n"
+                   "  if (!etag.length())\n  {\n    PageHash hash;\n\n    render%sPage(hash);\n"
+                   "    etag = hash.etag();\n  }\n  return etag;\n}\n", page.name, title);
+        }
+        fprintf(stderr, "=> %s: %zu bytes of text, %d segments, %d placeholders%s\n", argv[i], page.textLen,
+                page.segments, page.fields, page.dynamic ? "" : ", ETag");
+        free(src);
+        free(page.text);
+        free(page.code);
+    }
+    return 0;
+}